@@ -2,7 +2,27 @@
 
 #define UU_INIT
 
+#include "UU/Memory.hpp"
+#include "UU/Parallel.hpp"
+#include "UU/Simd.hpp"
+#include "UU/Span.hpp"
 #include "UU/Math.hpp"
+#include "UU/VectorView.hpp"
 #include "UU/Colour.hpp"
+#include "UU/Image.hpp"
+#include "UU/Blend.hpp"
+#include "UU/Palette.hpp"
+#include "UU/Lab.hpp"
+#include "UU/PixelFormat.hpp"
+#include "UU/Filter.hpp"
+#include "UU/Resample.hpp"
+#include "UU/Statistics.hpp"
+#include "UU/AABox.hpp"
+#include "UU/Reduce.hpp"
+#include "UU/Bvh.hpp"
+#include "UU/Frustum.hpp"
+#include "UU/Morton.hpp"
+#include "UU/Divisor.hpp"
+#include "UU/Polynomial.hpp"
 
 #undef UU_INIT
\ No newline at end of file
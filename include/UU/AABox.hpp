@@ -0,0 +1,147 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Math.hpp"
+
+#include <limits>
+
+namespace UU
+{
+	template <typename T, size_t size>
+	class CAABox
+	{
+	public:
+		CVector<T, size> min, max;
+
+		// Default constructed boxes are empty (min > max) so that growing them by any point yields that point.
+		CAABox();
+		CAABox(const CVector<T, size> & min, const CVector<T, size> & max);
+
+		bool				operator==(const CAABox & b) const;
+		bool				operator!=(const CAABox & b) const;
+
+		bool				IsEmpty() const;
+
+		void				Grow(const CVector<T, size> & v);
+		void				Grow(const CAABox & b);
+
+		CVector<T, size>	Center() const;
+		CVector<T, size>	Extents() const;
+
+		bool				Contains(const CVector<T, size> & v) const;
+		bool				Intersects(const CAABox & b) const;
+
+		friend std::ostream & operator<<(std::ostream & os, const CAABox & b)
+		{
+			os << "[" << b.min << ", " << b.max << "]";
+
+			return os;
+		}
+	};
+
+	using CAABox2f = CAABox<float, 2>;
+	using CAABox3f = CAABox<float, 3>;
+
+	using CAABox2d = CAABox<double, 2>;
+	using CAABox3d = CAABox<double, 3>;
+
+	using CAABox2i = CAABox<int, 2>;
+	using CAABox3i = CAABox<int, 3>;
+}
+
+template <typename T, size_t size>
+UU::CAABox<T, size>::CAABox()
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		min[i] = std::numeric_limits<T>::max();
+		max[i] = std::numeric_limits<T>::lowest();
+	}
+}
+
+template <typename T, size_t size>
+UU::CAABox<T, size>::CAABox(const CVector<T, size> & min, const CVector<T, size> & max)
+	: min(min), max(max)
+{
+}
+
+template <typename T, size_t size>
+bool UU::CAABox<T, size>::operator==(const CAABox & b) const
+{
+	return min == b.min && max == b.max;
+}
+
+template <typename T, size_t size>
+bool UU::CAABox<T, size>::operator!=(const CAABox & b) const
+{
+	return min != b.min || max != b.max;
+}
+
+template <typename T, size_t size>
+bool UU::CAABox<T, size>::IsEmpty() const
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		if (min[i] > max[i])
+			return true;
+	}
+
+	return false;
+}
+
+template <typename T, size_t size>
+void UU::CAABox<T, size>::Grow(const CVector<T, size> & v)
+{
+	min = min.Min(v);
+	max = max.Max(v);
+}
+
+template <typename T, size_t size>
+void UU::CAABox<T, size>::Grow(const CAABox & b)
+{
+	min = min.Min(b.min);
+	max = max.Max(b.max);
+}
+
+template <typename T, size_t size>
+UU::CVector<T, size> UU::CAABox<T, size>::Center() const
+{
+	CVector<T, size> temp;
+
+	for (size_t i = 0; i < size; ++i)
+		temp[i] = min[i] + (max[i] - min[i]) / T(2);
+
+	return temp;
+}
+
+template <typename T, size_t size>
+UU::CVector<T, size> UU::CAABox<T, size>::Extents() const
+{
+	CVector<T, size> temp;
+
+	for (size_t i = 0; i < size; ++i)
+		temp[i] = max[i] - min[i];
+
+	return temp;
+}
+
+template <typename T, size_t size>
+bool UU::CAABox<T, size>::Contains(const CVector<T, size> & v) const
+{
+	return v.WithinAABox(min, max);
+}
+
+template <typename T, size_t size>
+bool UU::CAABox<T, size>::Intersects(const CAABox & b) const
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		if (b.max[i] < min[i] || b.min[i] > max[i])
+			return false;
+	}
+
+	return true;
+}
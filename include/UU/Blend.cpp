@@ -0,0 +1,518 @@
+#include "../UU.hpp"
+#include "Blend.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+	using UU::CColour;
+	using UU::ECompositeOp;
+	using UU::EBlendMode;
+
+	// Lane operations shared by the 8-bit and float kernels. TLanes holds whole pixels, four channels each,
+	// and One() is 255 or 1.0f. The 8-bit classes also move pixels in and out of 16-bit lanes.
+
+#if defined(UU_AVX2)
+	class CLanes8 final
+	{
+	public:
+		using TPixels = __m256i;
+		using TLanes = __m256i;
+
+		static constexpr size_t PIXELS = 8;
+
+		static TPixels Load(const CColour * p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+		static void Store(CColour * p, TPixels v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+
+		// Lo and Hi take the low and high half of each 128-bit lane, Pack undoes that with unsigned saturation.
+		static TLanes Lo(TPixels v) { return _mm256_unpacklo_epi8(v, _mm256_setzero_si256()); }
+		static TLanes Hi(TPixels v) { return _mm256_unpackhi_epi8(v, _mm256_setzero_si256()); }
+		static TPixels Pack(TLanes lo, TLanes hi) { return _mm256_packus_epi16(lo, hi); }
+
+		static TLanes Zero() { return _mm256_setzero_si256(); }
+		static TLanes One() { return _mm256_set1_epi16(255); }
+
+		static TLanes Add(TLanes a, TLanes b) { return _mm256_add_epi16(a, b); }
+		static TLanes Sub(TLanes a, TLanes b) { return _mm256_sub_epi16(a, b); }
+
+		// a * b / 255 rounded to nearest for a, b in [0, 255].
+		static TLanes Mul(TLanes a, TLanes b)
+		{
+			const __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+
+			return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+		}
+
+		static TLanes Alpha(TLanes v) { return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0xff), 0xff); }
+
+		// Alpha in the colour channels and One() in the alpha channel.
+		static TLanes AlphaOpaque(TLanes v)
+		{
+			const __m256i colour = _mm256_setr_epi64x(0x0000ffffffffffffll, 0x0000ffffffffffffll, 0x0000ffffffffffffll, 0x0000ffffffffffffll);
+
+			return _mm256_or_si256(_mm256_and_si256(Alpha(v), colour), _mm256_andnot_si256(colour, One()));
+		}
+
+		// Pack saturates.
+		static TLanes Saturate(TLanes v) { return v; }
+	};
+#elif defined(UU_SSE2)
+	class CLanes8 final
+	{
+	public:
+		using TPixels = __m128i;
+		using TLanes = __m128i;
+
+		static constexpr size_t PIXELS = 4;
+
+		static TPixels Load(const CColour * p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+		static void Store(CColour * p, TPixels v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+
+		static TLanes Lo(TPixels v) { return _mm_unpacklo_epi8(v, _mm_setzero_si128()); }
+		static TLanes Hi(TPixels v) { return _mm_unpackhi_epi8(v, _mm_setzero_si128()); }
+		static TPixels Pack(TLanes lo, TLanes hi) { return _mm_packus_epi16(lo, hi); }
+
+		static TLanes Zero() { return _mm_setzero_si128(); }
+		static TLanes One() { return _mm_set1_epi16(255); }
+
+		static TLanes Add(TLanes a, TLanes b) { return _mm_add_epi16(a, b); }
+		static TLanes Sub(TLanes a, TLanes b) { return _mm_sub_epi16(a, b); }
+
+		static TLanes Mul(TLanes a, TLanes b)
+		{
+			const __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+
+			return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		}
+
+		static TLanes Alpha(TLanes v) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xff), 0xff); }
+
+		static TLanes AlphaOpaque(TLanes v)
+		{
+			const __m128i colour = _mm_set_epi32(0x0000ffff, -1, 0x0000ffff, -1);
+
+			return _mm_or_si128(_mm_and_si128(Alpha(v), colour), _mm_andnot_si128(colour, One()));
+		}
+
+		static TLanes Saturate(TLanes v) { return v; }
+	};
+#else
+	// Two pixels per step, Lo and Hi holding the channels of one each.
+	class CLanes8 final
+	{
+	public:
+		static constexpr size_t PIXELS = 2;
+
+		class TPixels
+		{
+		public:
+			CColour p[PIXELS];
+		};
+
+		class TLanes
+		{
+		public:
+			uint32_t v[4];
+		};
+
+		static TPixels Load(const CColour * p) { return TPixels{ { p[0], p[1] } }; }
+		static void Store(CColour * p, const TPixels & v) { p[0] = v.p[0]; p[1] = v.p[1]; }
+
+		static TLanes Lo(const TPixels & v) { return TLanes{ { v.p[0].r, v.p[0].g, v.p[0].b, v.p[0].a } }; }
+		static TLanes Hi(const TPixels & v) { return TLanes{ { v.p[1].r, v.p[1].g, v.p[1].b, v.p[1].a } }; }
+
+		static TPixels Pack(const TLanes & lo, const TLanes & hi)
+		{
+			const auto sat = [](uint32_t x) { return static_cast<uint8_t>(x > 255 ? 255 : x); };
+
+			return TPixels{ { CColour(sat(lo.v[0]), sat(lo.v[1]), sat(lo.v[2]), sat(lo.v[3])), CColour(sat(hi.v[0]), sat(hi.v[1]), sat(hi.v[2]), sat(hi.v[3])) } };
+		}
+
+		static TLanes Zero() { return TLanes{ { 0, 0, 0, 0 } }; }
+		static TLanes One() { return TLanes{ { 255, 255, 255, 255 } }; }
+
+		static TLanes Add(const TLanes & a, const TLanes & b) { return TLanes{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+		static TLanes Sub(const TLanes & a, const TLanes & b) { return TLanes{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+
+		static TLanes Mul(const TLanes & a, const TLanes & b)
+		{
+			TLanes r;
+
+			for (size_t i = 0; i < 4; ++i)
+			{
+				const uint32_t t = a.v[i] * b.v[i] + 128;
+
+				r.v[i] = (t + (t >> 8)) >> 8;
+			}
+
+			return r;
+		}
+
+		static TLanes Alpha(const TLanes & v) { return TLanes{ { v.v[3], v.v[3], v.v[3], v.v[3] } }; }
+		static TLanes AlphaOpaque(const TLanes & v) { return TLanes{ { v.v[3], v.v[3], v.v[3], 255 } }; }
+
+		static TLanes Saturate(const TLanes & v) { return v; }
+	};
+#endif
+
+	// One CVec4f pixel per register.
+	class CLanesFloat final
+	{
+	public:
+		using TLanes = UU::CSimd<float, 4>;
+
+		static TLanes Load(const UU::CVec4f & p) { return TLanes::Load(reinterpret_cast<const float *>(&p)); }
+		static void Store(UU::CVec4f & p, const TLanes & v) { v.Store(reinterpret_cast<float *>(&p)); }
+
+		static TLanes Zero() { return TLanes(0.f); }
+		static TLanes One() { return TLanes(1.f); }
+
+		static TLanes Add(const TLanes & a, const TLanes & b) { return a + b; }
+		static TLanes Sub(const TLanes & a, const TLanes & b) { return a - b; }
+		static TLanes Mul(const TLanes & a, const TLanes & b) { return a * b; }
+
+		static TLanes Alpha(const TLanes & v) { alignas(16) float f[4]; v.Store(f); return TLanes(f[3]); }
+		static TLanes AlphaOpaque(const TLanes & v) { alignas(16) float f[4]; v.Store(f); f[0] = f[1] = f[2] = f[3]; f[3] = 1.f; return TLanes::Load(f); }
+
+		static TLanes Saturate(const TLanes & v) { return Min(v, One()); }
+	};
+
+	enum class EFactor : uint8_t
+	{
+		Zero,
+		One,
+		SourceAlpha,
+		DestinationAlpha,
+		InverseSourceAlpha,
+		InverseDestinationAlpha
+	};
+
+	constexpr EFactor SourceFactor(ECompositeOp op)
+	{
+		switch (op)
+		{
+		case ECompositeOp::Clear:
+		case ECompositeOp::Destination:
+		case ECompositeOp::DestinationIn:
+		case ECompositeOp::DestinationOut:
+			return EFactor::Zero;
+		case ECompositeOp::SourceIn:
+		case ECompositeOp::SourceAtop:
+			return EFactor::DestinationAlpha;
+		case ECompositeOp::DestinationOver:
+		case ECompositeOp::SourceOut:
+		case ECompositeOp::DestinationAtop:
+		case ECompositeOp::Xor:
+			return EFactor::InverseDestinationAlpha;
+		default:
+			return EFactor::One;
+		}
+	}
+
+	constexpr EFactor DestinationFactor(ECompositeOp op)
+	{
+		switch (op)
+		{
+		case ECompositeOp::Clear:
+		case ECompositeOp::Source:
+		case ECompositeOp::SourceIn:
+		case ECompositeOp::SourceOut:
+			return EFactor::Zero;
+		case ECompositeOp::DestinationIn:
+		case ECompositeOp::DestinationAtop:
+			return EFactor::SourceAlpha;
+		case ECompositeOp::SourceOver:
+		case ECompositeOp::DestinationOut:
+		case ECompositeOp::SourceAtop:
+		case ECompositeOp::Xor:
+			return EFactor::InverseSourceAlpha;
+		default:
+			return EFactor::One;
+		}
+	}
+
+	template <EFactor factor, typename W, typename TLanes>
+	TLanes Scale(const TLanes & x, const TLanes & as, const TLanes & ad)
+	{
+		if constexpr (factor == EFactor::Zero)
+			return W::Zero();
+		else if constexpr (factor == EFactor::One)
+			return x;
+		else if constexpr (factor == EFactor::SourceAlpha)
+			return W::Mul(x, as);
+		else if constexpr (factor == EFactor::DestinationAlpha)
+			return W::Mul(x, ad);
+		else if constexpr (factor == EFactor::InverseSourceAlpha)
+			return W::Mul(x, W::Sub(W::One(), as));
+		else
+			return W::Mul(x, W::Sub(W::One(), ad));
+	}
+
+	template <ECompositeOp op, typename W, typename TLanes>
+	TLanes CompositeLanes(const TLanes & s, const TLanes & d)
+	{
+		const TLanes as = W::Alpha(s);
+		const TLanes ad = W::Alpha(d);
+		const TLanes r = W::Add(Scale<SourceFactor(op), W>(s, as, ad), Scale<DestinationFactor(op), W>(d, as, ad));
+
+		if constexpr (op == ECompositeOp::Plus)
+			return W::Saturate(r);
+		else
+			return r;
+	}
+
+	template <EBlendMode mode, typename W, typename TLanes>
+	TLanes BlendLanes(const TLanes & s, const TLanes & d)
+	{
+		if constexpr (mode == EBlendMode::Add)
+		{
+			return CompositeLanes<ECompositeOp::Plus, W>(s, d);
+		}
+		else if constexpr (mode == EBlendMode::Multiply)
+		{
+			const TLanes one = W::One();
+
+			return W::Add(W::Add(W::Mul(s, d), W::Mul(s, W::Sub(one, W::Alpha(d)))), W::Mul(d, W::Sub(one, W::Alpha(s))));
+		}
+		else if constexpr (mode == EBlendMode::Screen)
+		{
+			return W::Sub(W::Add(s, d), W::Mul(s, d));
+		}
+		else
+		{
+			return CompositeLanes<ECompositeOp::SourceOver, W>(s, d);
+		}
+	}
+
+	template <typename W, typename Fn>
+	void TransformBlock(const CColour * s, const CColour * d, CColour * o, const Fn & fn)
+	{
+		const typename W::TPixels s8 = W::Load(s);
+		const typename W::TPixels d8 = W::Load(d);
+
+		W::Store(o, W::Pack(fn(W::Lo(s8), W::Lo(d8)), fn(W::Hi(s8), W::Hi(d8))));
+	}
+
+	// Applies fn(source lanes, destination lanes) over the spans, the tail through a padded block.
+	template <typename Fn>
+	void Transform8(const CColour * s, const CColour * d, CColour * o, size_t count, Fn fn)
+	{
+		using W = CLanes8;
+
+		UU::ParallelFor(count, UU::BLEND_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+		{
+			size_t i = begin;
+
+			for (; i + W::PIXELS <= end; i += W::PIXELS)
+				TransformBlock<W>(s + i, d + i, o + i, fn);
+
+			if (i < end)
+			{
+				CColour ts[W::PIXELS], td[W::PIXELS], to[W::PIXELS];
+
+				std::memcpy(ts, s + i, (end - i) * sizeof(CColour));
+				std::memcpy(td, d + i, (end - i) * sizeof(CColour));
+
+				TransformBlock<W>(ts, td, to, fn);
+
+				std::memcpy(o + i, to, (end - i) * sizeof(CColour));
+			}
+		});
+	}
+
+	template <typename Fn>
+	void TransformFloat(const UU::CVec4f * s, const UU::CVec4f * d, UU::CVec4f * o, size_t count, Fn fn)
+	{
+		using W = CLanesFloat;
+
+		UU::ParallelFor(count, UU::BLEND_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				W::Store(o[i], fn(W::Load(s[i]), W::Load(d[i])));
+		});
+	}
+
+	template <ECompositeOp op>
+	void Composite8(UU::CSpan<const CColour> src, UU::CSpan<const CColour> dst, UU::CSpan<CColour> out)
+	{
+		Transform8(src.Data(), dst.Data(), out.Data(), out.Size(), [](const auto & s, const auto & d) { return CompositeLanes<op, CLanes8>(s, d); });
+	}
+
+	template <EBlendMode mode>
+	void Blend8(UU::CSpan<const CColour> src, UU::CSpan<const CColour> dst, UU::CSpan<CColour> out)
+	{
+		Transform8(src.Data(), dst.Data(), out.Data(), out.Size(), [](const auto & s, const auto & d) { return BlendLanes<mode, CLanes8>(s, d); });
+	}
+
+	template <ECompositeOp op>
+	void CompositeFloat(UU::CSpan<const UU::CVec4f> src, UU::CSpan<const UU::CVec4f> dst, UU::CSpan<UU::CVec4f> out)
+	{
+		TransformFloat(src.Data(), dst.Data(), out.Data(), out.Size(), [](const auto & s, const auto & d) { return CompositeLanes<op, CLanesFloat>(s, d); });
+	}
+
+	template <EBlendMode mode>
+	void BlendFloat(UU::CSpan<const UU::CVec4f> src, UU::CSpan<const UU::CVec4f> dst, UU::CSpan<UU::CVec4f> out)
+	{
+		TransformFloat(src.Data(), dst.Data(), out.Data(), out.Size(), [](const auto & s, const auto & d) { return BlendLanes<mode, CLanesFloat>(s, d); });
+	}
+
+	// Calls fn with a std::integral_constant of the runtime operator.
+	template <typename Fn>
+	void WithCompositeOp(ECompositeOp op, Fn && fn)
+	{
+		using EOp = ECompositeOp;
+
+		switch (op)
+		{
+		case EOp::DestinationOver:
+			return fn(std::integral_constant<EOp, EOp::DestinationOver>());
+		case EOp::Clear:
+			return fn(std::integral_constant<EOp, EOp::Clear>());
+		case EOp::Source:
+			return fn(std::integral_constant<EOp, EOp::Source>());
+		case EOp::Destination:
+			return fn(std::integral_constant<EOp, EOp::Destination>());
+		case EOp::SourceIn:
+			return fn(std::integral_constant<EOp, EOp::SourceIn>());
+		case EOp::DestinationIn:
+			return fn(std::integral_constant<EOp, EOp::DestinationIn>());
+		case EOp::SourceOut:
+			return fn(std::integral_constant<EOp, EOp::SourceOut>());
+		case EOp::DestinationOut:
+			return fn(std::integral_constant<EOp, EOp::DestinationOut>());
+		case EOp::SourceAtop:
+			return fn(std::integral_constant<EOp, EOp::SourceAtop>());
+		case EOp::DestinationAtop:
+			return fn(std::integral_constant<EOp, EOp::DestinationAtop>());
+		case EOp::Xor:
+			return fn(std::integral_constant<EOp, EOp::Xor>());
+		case EOp::Plus:
+			return fn(std::integral_constant<EOp, EOp::Plus>());
+		default:
+			return fn(std::integral_constant<EOp, EOp::SourceOver>());
+		}
+	}
+
+	template <typename Fn>
+	void WithBlendMode(EBlendMode mode, Fn && fn)
+	{
+		switch (mode)
+		{
+		case EBlendMode::Add:
+			return fn(std::integral_constant<EBlendMode, EBlendMode::Add>());
+		case EBlendMode::Multiply:
+			return fn(std::integral_constant<EBlendMode, EBlendMode::Multiply>());
+		case EBlendMode::Screen:
+			return fn(std::integral_constant<EBlendMode, EBlendMode::Screen>());
+		default:
+			return fn(std::integral_constant<EBlendMode, EBlendMode::Normal>());
+		}
+	}
+}
+
+// Premultiplied Alpha
+
+void UU::Premultiply(CSpan<const CColour> in, CSpan<CColour> out)
+{
+	Transform8(in.Data(), in.Data(), out.Data(), out.Size(), [](const auto & s, const auto &) { return CLanes8::Mul(s, CLanes8::AlphaOpaque(s)); });
+}
+
+void UU::Unpremultiply(CSpan<const CColour> in, CSpan<CColour> out)
+{
+	using V = CSimdNative<float>;
+
+	ParallelFor(in.Size(), BLEND_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		alignas(64) float r[V::LANES], g[V::LANES], b[V::LANES], a[V::LANES];
+		alignas(64) int32_t r_out[V::LANES], g_out[V::LANES], b_out[V::LANES];
+
+		for (size_t i = begin; i < end; i += V::LANES)
+		{
+			const size_t n = end - i < V::LANES ? end - i : V::LANES;
+
+			for (size_t j = 0; j < V::LANES; ++j)
+			{
+				const CColour c = in[i + (j < n ? j : 0)];
+
+				r[j] = c.r;
+				g[j] = c.g;
+				b[j] = c.b;
+				a[j] = c.a;
+			}
+
+			// c * 255 / a is at least 1 / (2a) away from a rounding boundary unless exactly on one, so the
+			// correctly rounded float quotient rounds half up the same way as the exact integer division.
+			const V va = V::Load(a);
+			const auto clear = va == V(0.f);
+			const auto channel = [&](const float * c, int32_t * o)
+			{
+				const V q = Floor(V::Load(c) * V(255.f) / va + V(0.5f));
+
+				StoreInt32(Select(clear, V(0.f), Min(q, V(255.f))), o);
+			};
+
+			channel(r, r_out);
+			channel(g, g_out);
+			channel(b, b_out);
+
+			for (size_t j = 0; j < n; ++j)
+				out[i + j] = CColour(static_cast<uint8_t>(r_out[j]), static_cast<uint8_t>(g_out[j]), static_cast<uint8_t>(b_out[j]), static_cast<uint8_t>(a[j]));
+		}
+	});
+}
+
+void UU::Premultiply(CSpan<const CVec4f> in, CSpan<CVec4f> out)
+{
+	TransformFloat(in.Data(), in.Data(), out.Data(), out.Size(), [](const auto & s, const auto &) { return s * CLanesFloat::AlphaOpaque(s); });
+}
+
+void UU::Unpremultiply(CSpan<const CVec4f> in, CSpan<CVec4f> out)
+{
+	TransformFloat(in.Data(), in.Data(), out.Data(), out.Size(), [](const auto & s, const auto &)
+	{
+		const auto a = CLanesFloat::AlphaOpaque(s);
+
+		return Select(a == CLanesFloat::Zero(), CLanesFloat::Zero(), s / a);
+	});
+}
+
+// Compositing
+
+void UU::Composite(CSpan<const CColour> src, CSpan<const CColour> dst, CSpan<CColour> out, ECompositeOp op)
+{
+	WithCompositeOp(op, [&](auto tag) { Composite8<decltype(tag)::value>(src, dst, out); });
+}
+
+void UU::Blend(CSpan<const CColour> src, CSpan<const CColour> dst, CSpan<CColour> out, EBlendMode mode)
+{
+	WithBlendMode(mode, [&](auto tag) { Blend8<decltype(tag)::value>(src, dst, out); });
+}
+
+void UU::Composite(CSpan<const CVec4f> src, CSpan<const CVec4f> dst, CSpan<CVec4f> out, ECompositeOp op)
+{
+	WithCompositeOp(op, [&](auto tag) { CompositeFloat<decltype(tag)::value>(src, dst, out); });
+}
+
+void UU::Blend(CSpan<const CVec4f> src, CSpan<const CVec4f> dst, CSpan<CVec4f> out, EBlendMode mode)
+{
+	WithBlendMode(mode, [&](auto tag) { BlendFloat<decltype(tag)::value>(src, dst, out); });
+}
+
+void UU::Composite(CImageView<const CColour> src, CImageView<const CColour> dst, CImageView<CColour> out, ECompositeOp op)
+{
+	WithCompositeOp(op, [&](auto tag)
+	{
+		ParallelForRows(out, [&](size_t y, CSpan<CColour> row) { Composite8<decltype(tag)::value>(src.RowSpan(y), dst.RowSpan(y), row); });
+	});
+}
+
+void UU::Blend(CImageView<const CColour> src, CImageView<const CColour> dst, CImageView<CColour> out, EBlendMode mode)
+{
+	WithBlendMode(mode, [&](auto tag)
+	{
+		ParallelForRows(out, [&](size_t y, CSpan<CColour> row) { Blend8<decltype(tag)::value>(src.RowSpan(y), dst.RowSpan(y), row); });
+	});
+}
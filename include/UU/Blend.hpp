@@ -0,0 +1,64 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Colour.hpp"
+#include "Image.hpp"
+#include "Math.hpp"
+#include "Span.hpp"
+
+#include <cstdint>
+
+namespace UU
+{
+	// Porter-Duff operators, source op destination, on premultiplied colours. Every channel, alpha included,
+	// becomes Fa * source + Fb * destination with the factors listed.
+	enum class ECompositeOp : uint8_t
+	{
+		SourceOver,			// 1,			1 - as
+		DestinationOver,	// 1 - ad,		1
+		Clear,				// 0,			0
+		Source,				// 1,			0
+		Destination,		// 0,			1
+		SourceIn,			// ad,			0
+		DestinationIn,		// 0,			as
+		SourceOut,			// 1 - ad,		0
+		DestinationOut,		// 0,			1 - as
+		SourceAtop,			// ad,			1 - as
+		DestinationAtop,	// 1 - ad,		as
+		Xor,				// 1 - ad,		1 - as
+		Plus				// 1,			1, saturated
+	};
+
+	// Separable blend modes of the W3C compositing model on premultiplied colours, composited source over:
+	// Normal is SourceOver, Add is Plus, Multiply gives s * d + s * (1 - ad) + d * (1 - as) and Screen s + d - s * d.
+	enum class EBlendMode : uint8_t
+	{
+		Normal,
+		Add,
+		Multiply,
+		Screen
+	};
+
+	constexpr size_t BLEND_PARALLEL_GRAIN = 1 << 15;
+
+	// CColour spans use 8-bit fixed point on 16-bit lanes, 4 pixels per step with SSE2 and 8 with AVX2, where
+	// every product is x * y / 255 rounded to nearest exactly. Unpremultiply rounds c * 255 / a to nearest and
+	// clears pixels with zero alpha. All spans have the same size, out may alias any input.
+	void				Premultiply(CSpan<const CColour> in, CSpan<CColour> out);
+	void				Unpremultiply(CSpan<const CColour> in, CSpan<CColour> out);
+	void				Composite(CSpan<const CColour> src, CSpan<const CColour> dst, CSpan<CColour> out, ECompositeOp op = ECompositeOp::SourceOver);
+	void				Blend(CSpan<const CColour> src, CSpan<const CColour> dst, CSpan<CColour> out, EBlendMode mode = EBlendMode::Normal);
+
+	// The same operations in float on (r, g, b, a) in [0, 1], one pixel per SSE register.
+	void				Premultiply(CSpan<const CVec4f> in, CSpan<CVec4f> out);
+	void				Unpremultiply(CSpan<const CVec4f> in, CSpan<CVec4f> out);
+	void				Composite(CSpan<const CVec4f> src, CSpan<const CVec4f> dst, CSpan<CVec4f> out, ECompositeOp op = ECompositeOp::SourceOver);
+	void				Blend(CSpan<const CVec4f> src, CSpan<const CVec4f> dst, CSpan<CVec4f> out, EBlendMode mode = EBlendMode::Normal);
+
+	// Row by row forms for images, all views have the same size.
+	void				Composite(CImageView<const CColour> src, CImageView<const CColour> dst, CImageView<CColour> out, ECompositeOp op = ECompositeOp::SourceOver);
+	void				Blend(CImageView<const CColour> src, CImageView<const CColour> dst, CImageView<CColour> out, EBlendMode mode = EBlendMode::Normal);
+}
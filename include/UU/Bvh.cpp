@@ -0,0 +1,963 @@
+#include "../UU.hpp"
+#include "Bvh.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+
+namespace
+{
+	constexpr size_t	BVH_BINS = 16;
+	constexpr size_t	BVH_MAX_LEAF_SIZE = 16;
+	constexpr size_t	BVH_PARALLEL_BIN_THRESHOLD = 1 << 16;
+	constexpr size_t	BVH_PARALLEL_TASK_THRESHOLD = 1 << 12;
+	constexpr size_t	BVH_STACK_SIZE = 128;
+	constexpr float		BVH_TRAVERSAL_COST = 1.f;
+	constexpr float		BVH_DET_EPSILON = 1e-12f;
+
+	// Traversal holds at most one entry per level plus the two children of the node being visited, so
+	// nodes deeper than this become leaves. Below BVH_MEDIAN_DEPTH splits halve the range, which reaches
+	// single triangles within 32 levels whatever SAH did above.
+	constexpr size_t	BVH_MAX_DEPTH = BVH_STACK_SIZE - 1;
+	constexpr size_t	BVH_MEDIAN_DEPTH = BVH_MAX_DEPTH - 32;
+
+	// Packets of 8 rays run as one register of 8 lanes, or two of 4.
+	using V = UU::CSimd<float, (UU::SIMD_FLOAT_LANES < 8 ? UU::SIMD_FLOAT_LANES : 8)>;
+
+	class CBounds
+	{
+	public:
+
+		float		min[3], max[3];
+
+		void Reset()
+		{
+			min[0] = min[1] = min[2] = FLT_MAX;
+			max[0] = max[1] = max[2] = -FLT_MAX;
+		}
+
+		void Grow(const float * p)
+		{
+			for (size_t k = 0; k < 3; ++k)
+			{
+				min[k] = p[k] < min[k] ? p[k] : min[k];
+				max[k] = p[k] > max[k] ? p[k] : max[k];
+			}
+		}
+
+		void Grow(const CBounds & b)
+		{
+			for (size_t k = 0; k < 3; ++k)
+			{
+				min[k] = b.min[k] < min[k] ? b.min[k] : min[k];
+				max[k] = b.max[k] > max[k] ? b.max[k] : max[k];
+			}
+		}
+
+		float HalfArea() const
+		{
+			if (min[0] > max[0])
+				return 0.f;
+
+			const float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+
+			return dx * dy + dy * dz + dz * dx;
+		}
+	};
+
+	class CBin
+	{
+	public:
+
+		CBounds		bounds;
+		uint32_t	count;
+	};
+
+	using CBinSet = CBin[3][BVH_BINS];
+
+	class CBuildContext
+	{
+	public:
+
+		std::vector<CBounds>		prim_bounds;
+		std::vector<float>			centroids;
+		std::vector<uint32_t>		order;
+		UU::CBvhNode *				nodes = nullptr;
+		std::atomic<uint32_t>		next_node{ 0 };
+		size_t						max_leaf_size = 4;
+		size_t						spawn_depth = 0;
+	};
+
+	class CStackEntry
+	{
+	public:
+
+		uint32_t	node;
+		uint32_t	mask;
+		float		t_near;
+	};
+
+	void ResetBins(CBinSet & bins)
+	{
+		for (auto & axis : bins)
+			for (CBin & bin : axis)
+			{
+				bin.bounds.Reset();
+				bin.count = 0;
+			}
+	}
+
+	size_t BinIndex(float c, float min, float scale)
+	{
+		const auto b = static_cast<size_t>((c - min) * scale);
+
+		return b < BVH_BINS ? b : BVH_BINS - 1;
+	}
+
+	void ComputeRangeBounds(const CBuildContext & ctx, size_t begin, size_t end, CBounds & bounds, CBounds & centroid_bounds)
+	{
+		bounds.Reset();
+		centroid_bounds.Reset();
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			const uint32_t p = ctx.order[i];
+
+			bounds.Grow(ctx.prim_bounds[p]);
+			centroid_bounds.Grow(&ctx.centroids[p * 3]);
+		}
+	}
+
+	void BinRange(const CBuildContext & ctx, size_t begin, size_t end, const CBounds & centroid_bounds, const float * scale, CBinSet & bins)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const uint32_t p = ctx.order[i];
+			const float * c = &ctx.centroids[p * 3];
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				CBin & bin = bins[k][BinIndex(c[k], centroid_bounds.min[k], scale[k])];
+
+				bin.bounds.Grow(ctx.prim_bounds[p]);
+				++bin.count;
+			}
+		}
+	}
+
+	void MakeLeaf(UU::CBvhNode & node, size_t begin, size_t end)
+	{
+		node.left_first = static_cast<uint32_t>(begin);
+		node.count = static_cast<uint32_t>(end - begin);
+	}
+
+	void BuildNode(CBuildContext & ctx, uint32_t node_index, size_t begin, size_t end, size_t depth)
+	{
+		UU::CBvhNode & node = ctx.nodes[node_index];
+		const size_t count = end - begin;
+
+		CBounds bounds, centroid_bounds;
+
+		if (count >= BVH_PARALLEL_BIN_THRESHOLD)
+		{
+			std::vector<CBounds> local(UU::ParallelChunkCount(count, BVH_PARALLEL_BIN_THRESHOLD / 4) * 2);
+
+			UU::ParallelFor(count, BVH_PARALLEL_BIN_THRESHOLD / 4, [&](size_t chunk, size_t b, size_t e)
+			{
+				ComputeRangeBounds(ctx, begin + b, begin + e, local[chunk * 2], local[chunk * 2 + 1]);
+			});
+
+			bounds.Reset();
+			centroid_bounds.Reset();
+
+			for (size_t i = 0; i < local.size(); i += 2)
+			{
+				bounds.Grow(local[i]);
+				centroid_bounds.Grow(local[i + 1]);
+			}
+		}
+		else
+		{
+			ComputeRangeBounds(ctx, begin, end, bounds, centroid_bounds);
+		}
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			node.min[k] = bounds.min[k];
+			node.max[k] = bounds.max[k];
+		}
+
+		if (count <= ctx.max_leaf_size || depth >= BVH_MAX_DEPTH)
+		{
+			MakeLeaf(node, begin, end);
+			return;
+		}
+
+		float scale[3];
+		bool splittable = false;
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			const float extent = centroid_bounds.max[k] - centroid_bounds.min[k];
+
+			scale[k] = extent > 0.f ? static_cast<float>(BVH_BINS) / extent : 0.f;
+			splittable |= extent > 0.f;
+		}
+
+		size_t mid = begin + count / 2;
+
+		if (splittable && depth < BVH_MEDIAN_DEPTH)
+		{
+			CBinSet bins;
+
+			if (count >= BVH_PARALLEL_BIN_THRESHOLD)
+			{
+				std::vector<CBinSet> local(UU::ParallelChunkCount(count, BVH_PARALLEL_BIN_THRESHOLD / 4));
+
+				UU::ParallelFor(count, BVH_PARALLEL_BIN_THRESHOLD / 4, [&](size_t chunk, size_t b, size_t e)
+				{
+					ResetBins(local[chunk]);
+					BinRange(ctx, begin + b, begin + e, centroid_bounds, scale, local[chunk]);
+				});
+
+				ResetBins(bins);
+
+				for (const CBinSet & set : local)
+					for (size_t k = 0; k < 3; ++k)
+						for (size_t i = 0; i < BVH_BINS; ++i)
+						{
+							bins[k][i].bounds.Grow(set[k][i].bounds);
+							bins[k][i].count += set[k][i].count;
+						}
+			}
+			else
+			{
+				ResetBins(bins);
+				BinRange(ctx, begin, end, centroid_bounds, scale, bins);
+			}
+
+			float best_cost = FLT_MAX;
+			size_t best_axis = 3, best_split = 0;
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				if (scale[k] == 0.f)
+					continue;
+
+				float right_cost[BVH_BINS];
+				CBounds acc;
+				uint32_t acc_count = 0;
+
+				acc.Reset();
+
+				for (size_t i = BVH_BINS - 1; i > 0; --i)
+				{
+					acc.Grow(bins[k][i].bounds);
+					acc_count += bins[k][i].count;
+					right_cost[i] = acc_count * acc.HalfArea();
+				}
+
+				acc.Reset();
+				acc_count = 0;
+
+				for (size_t i = 1; i < BVH_BINS; ++i)
+				{
+					acc.Grow(bins[k][i - 1].bounds);
+					acc_count += bins[k][i - 1].count;
+
+					const float cost = acc_count * acc.HalfArea() + right_cost[i];
+
+					if (cost < best_cost)
+					{
+						best_cost = cost;
+						best_axis = k;
+						best_split = i;
+					}
+				}
+			}
+
+			const float area = bounds.HalfArea() > 0.f ? bounds.HalfArea() : FLT_MIN;
+			const float split_cost = BVH_TRAVERSAL_COST + best_cost / area;
+
+			if (best_axis == 3 || (split_cost >= static_cast<float>(count) && count <= BVH_MAX_LEAF_SIZE))
+			{
+				MakeLeaf(node, begin, end);
+				return;
+			}
+
+			const auto split = std::partition(ctx.order.begin() + begin, ctx.order.begin() + end, [&](uint32_t p)
+			{
+				return BinIndex(ctx.centroids[p * 3 + best_axis], centroid_bounds.min[best_axis], scale[best_axis]) < best_split;
+			});
+
+			mid = static_cast<size_t>(split - ctx.order.begin());
+
+			if (mid == begin || mid == end)
+				mid = begin + count / 2;
+		}
+		else if (splittable)
+		{
+			size_t axis = 0;
+
+			for (size_t k = 1; k < 3; ++k)
+			{
+				if (centroid_bounds.max[k] - centroid_bounds.min[k] > centroid_bounds.max[axis] - centroid_bounds.min[axis])
+					axis = k;
+			}
+
+			std::nth_element(ctx.order.begin() + begin, ctx.order.begin() + mid, ctx.order.begin() + end, [&](uint32_t p, uint32_t q)
+			{
+				return ctx.centroids[p * 3 + axis] < ctx.centroids[q * 3 + axis];
+			});
+		}
+		else if (count <= BVH_MAX_LEAF_SIZE)
+		{
+			MakeLeaf(node, begin, end);
+			return;
+		}
+
+		const uint32_t child = ctx.next_node.fetch_add(2);
+
+		node.left_first = child;
+		node.count = 0;
+
+		if (count >= BVH_PARALLEL_TASK_THRESHOLD && depth < ctx.spawn_depth)
+		{
+			auto left = std::async(std::launch::async, [&ctx, child, begin, mid, depth]()
+			{
+				BuildNode(ctx, child, begin, mid, depth + 1);
+			});
+
+			BuildNode(ctx, child + 1, mid, end, depth + 1);
+			left.get();
+		}
+		else
+		{
+			BuildNode(ctx, child, begin, mid, depth + 1);
+			BuildNode(ctx, child + 1, mid, end, depth + 1);
+		}
+	}
+
+	bool IntersectBox(const UU::CBvhNode & node, const float * origin, const float * inv_dir, float t_min, float t_max, float & t_near)
+	{
+		for (size_t k = 0; k < 3; ++k)
+		{
+			const float t0 = (node.min[k] - origin[k]) * inv_dir[k];
+			const float t1 = (node.max[k] - origin[k]) * inv_dir[k];
+			const float lo = t0 < t1 ? t0 : t1;
+			const float hi = t0 < t1 ? t1 : t0;
+
+			// Written so a NaN slab (origin on the plane of a zero direction) leaves the interval untouched.
+			t_min = t_min < lo ? lo : t_min;
+			t_max = t_max > hi ? hi : t_max;
+		}
+
+		t_near = t_min;
+
+		return t_min <= t_max;
+	}
+
+	bool IntersectTriangle(const UU::CBvhTriangle & tri, const float * o, const float * d, float t_min, float t_max,
+		float & t, float & u, float & v)
+	{
+		const float px = d[1] * tri.e2[2] - d[2] * tri.e2[1];
+		const float py = d[2] * tri.e2[0] - d[0] * tri.e2[2];
+		const float pz = d[0] * tri.e2[1] - d[1] * tri.e2[0];
+
+		const float det = tri.e1[0] * px + tri.e1[1] * py + tri.e1[2] * pz;
+
+		if (det > -BVH_DET_EPSILON && det < BVH_DET_EPSILON)
+			return false;
+
+		const float inv_det = 1.f / det;
+
+		const float sx = o[0] - tri.v0[0], sy = o[1] - tri.v0[1], sz = o[2] - tri.v0[2];
+		const float _u = (sx * px + sy * py + sz * pz) * inv_det;
+
+		if (_u < 0.f || _u > 1.f)
+			return false;
+
+		const float qx = sy * tri.e1[2] - sz * tri.e1[1];
+		const float qy = sz * tri.e1[0] - sx * tri.e1[2];
+		const float qz = sx * tri.e1[1] - sy * tri.e1[0];
+
+		const float _v = (d[0] * qx + d[1] * qy + d[2] * qz) * inv_det;
+
+		if (_v < 0.f || _u + _v > 1.f)
+			return false;
+
+		const float _t = (tri.e2[0] * qx + tri.e2[1] * qy + tri.e2[2] * qz) * inv_det;
+
+		if (!(_t > t_min && _t < t_max))
+			return false;
+
+		t = _t;
+		u = _u;
+		v = _v;
+
+		return true;
+	}
+
+	class CPacketState
+	{
+	public:
+
+		alignas(32) float	origin[3][8];
+		alignas(32) float	inv_dir[3][8];
+		alignas(32) float	t_min[8];
+		alignas(32) float	t_max[8];
+		uint32_t			active;
+
+		explicit CPacketState(const UU::CRayPacket8 & packet)
+		{
+			active = 0;
+
+			for (size_t l = 0; l < 8; ++l)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					origin[k][l] = packet.origin[k][l];
+					inv_dir[k][l] = 1.f / packet.direction[k][l];
+				}
+
+				t_min[l] = packet.t_min[l];
+				t_max[l] = packet.t_max[l];
+
+				if (t_min[l] <= t_max[l])
+					active |= 1u << l;
+			}
+		}
+	};
+
+	// Returns the lanes of `mask` whose ray overlaps the node, and the nearest entry distance among them.
+	uint32_t IntersectBox8(const UU::CBvhNode & node, const CPacketState & s, uint32_t mask, float & t_near)
+	{
+		alignas(32) float lanes[8];
+		uint32_t overlap = 0;
+
+		for (size_t l = 0; l < 8; l += V::LANES)
+		{
+			V t_min = V::Load(s.t_min + l);
+			V t_max = V::Load(s.t_max + l);
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const V o = V::Load(s.origin[k] + l);
+				const V inv = V::Load(s.inv_dir[k] + l);
+				const V t0 = (V(node.min[k]) - o) * inv;
+				const V t1 = (V(node.max[k]) - o) * inv;
+
+				// Min and Max return their second operand on NaN, which keeps the running interval.
+				t_min = UU::Max(UU::Min(t0, t1), t_min);
+				t_max = UU::Min(UU::Max(t0, t1), t_max);
+			}
+
+			overlap |= UU::MoveMask(t_min <= t_max) << l;
+			t_min.Store(lanes + l);
+		}
+
+		mask &= overlap;
+		t_near = FLT_MAX;
+
+		for (uint32_t m = mask; m != 0; m &= m - 1)
+		{
+			const float t = lanes[UU::CountTrailingZeros(m)];
+			t_near = t < t_near ? t : t_near;
+		}
+
+		return mask;
+	}
+
+	// Moller-Trumbore against all lanes of `mask`; hitting lanes get their t_max shortened and their
+	// hit record written. Returns the lanes that hit.
+	uint32_t IntersectTriangle8(const UU::CBvhTriangle & tri, CPacketState & s, const UU::CRayPacket8 & packet,
+		uint32_t mask, UU::CRayHit8 * hit)
+	{
+		const V e1x(tri.e1[0]), e1y(tri.e1[1]), e1z(tri.e1[2]);
+		const V e2x(tri.e2[0]), e2y(tri.e2[1]), e2z(tri.e2[2]);
+		const V zero(0.f), one(1.f);
+
+		alignas(32) float lanes_t[8], lanes_u[8], lanes_v[8];
+		uint32_t result = 0;
+
+		for (size_t l = 0; l < 8; l += V::LANES)
+		{
+			if (((mask >> l) & ((1u << V::LANES) - 1)) == 0)
+				continue;
+
+			const V dx = V::Load(packet.direction[0] + l);
+			const V dy = V::Load(packet.direction[1] + l);
+			const V dz = V::Load(packet.direction[2] + l);
+
+			const V px = dy * e2z - dz * e2y;
+			const V py = dz * e2x - dx * e2z;
+			const V pz = dx * e2y - dy * e2x;
+
+			const V det = e1x * px + e1y * py + e1z * pz;
+			const V inv_det = one / det;
+
+			const V sx = V::Load(s.origin[0] + l) - V(tri.v0[0]);
+			const V sy = V::Load(s.origin[1] + l) - V(tri.v0[1]);
+			const V sz = V::Load(s.origin[2] + l) - V(tri.v0[2]);
+
+			const V u = (sx * px + sy * py + sz * pz) * inv_det;
+
+			const V qx = sy * e1z - sz * e1y;
+			const V qy = sz * e1x - sx * e1z;
+			const V qz = sx * e1y - sy * e1x;
+
+			const V v = (dx * qx + dy * qy + dz * qz) * inv_det;
+			const V t = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+
+			const auto ok = (UU::Abs(det) >= V(BVH_DET_EPSILON)) & (u >= zero) & (v >= zero) & (u + v <= one)
+				& (t > V::Load(s.t_min + l)) & (t < V::Load(s.t_max + l));
+
+			const uint32_t block = (UU::MoveMask(ok) << l) & mask;
+
+			if (block == 0)
+				continue;
+
+			t.Store(lanes_t + l);
+			u.Store(lanes_u + l);
+			v.Store(lanes_v + l);
+			result |= block;
+		}
+
+		for (uint32_t m = result; m != 0; m &= m - 1)
+		{
+			const size_t l = UU::CountTrailingZeros(m);
+
+			s.t_max[l] = lanes_t[l];
+
+			if (hit)
+			{
+				hit->t[l] = lanes_t[l];
+				hit->u[l] = lanes_u[l];
+				hit->v[l] = lanes_v[l];
+				hit->triangle[l] = tri.id;
+			}
+		}
+
+		return result;
+	}
+}
+
+// CRayPacket8 - Function Definitions
+
+UU::CRayPacket8::CRayPacket8()
+{
+	for (size_t l = 0; l < 8; ++l)
+	{
+		for (size_t k = 0; k < 3; ++k)
+		{
+			origin[k][l] = 0.f;
+			direction[k][l] = k == 2 ? 1.f : 0.f;
+		}
+
+		// Inactive until SetRay is called.
+		t_min[l] = FLT_MAX;
+		t_max[l] = 0.f;
+	}
+}
+
+void UU::CRayPacket8::SetRay(size_t lane, const CRay & ray)
+{
+	for (size_t k = 0; k < 3; ++k)
+	{
+		origin[k][lane] = ray.origin[k];
+		direction[k][lane] = ray.direction[k];
+	}
+
+	t_min[lane] = ray.t_min;
+	t_max[lane] = ray.t_max;
+}
+
+UU::CRay UU::CRayPacket8::GetRay(size_t lane) const
+{
+	return CRay(CVec3f(origin[0][lane], origin[1][lane], origin[2][lane]),
+		CVec3f(direction[0][lane], direction[1][lane], direction[2][lane]), t_min[lane], t_max[lane]);
+}
+
+// CRayHit8 - Function Definitions
+
+UU::CRayHit UU::CRayHit8::GetHit(size_t lane) const
+{
+	CRayHit temp;
+
+	temp.t = t[lane];
+	temp.u = u[lane];
+	temp.v = v[lane];
+	temp.triangle = triangle[lane];
+
+	return temp;
+}
+
+// CBvh - Function Definitions
+
+UU::CBvh::CBvh(CVectorView<const float, 3> vertices, CSpan<const uint32_t> indices, size_t max_leaf_size)
+{
+	Build(vertices, indices, max_leaf_size);
+}
+
+void UU::CBvh::Build(CVectorView<const float, 3> vertices, CSpan<const uint32_t> indices, size_t max_leaf_size)
+{
+	Clear();
+
+	const size_t count = indices.Size() / 3;
+
+	if (count == 0)
+		return;
+
+	CBuildContext ctx;
+
+	ctx.prim_bounds.resize(count);
+	ctx.centroids.resize(count * 3);
+	ctx.order.resize(count);
+	ctx.max_leaf_size = Clamp<size_t>(max_leaf_size, 1, BVH_MAX_LEAF_SIZE);
+
+	for (size_t threads = HardwareThreads(); threads > 1; threads >>= 1)
+		++ctx.spawn_depth;
+
+	ParallelFor(count, 4096, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			CBounds & b = ctx.prim_bounds[i];
+			b.Reset();
+
+			for (size_t j = 0; j < 3; ++j)
+				b.Grow(vertices[indices[i * 3 + j]].Base());
+
+			for (size_t k = 0; k < 3; ++k)
+				ctx.centroids[i * 3 + k] = (b.min[k] + b.max[k]) * 0.5f;
+
+			ctx.order[i] = static_cast<uint32_t>(i);
+		}
+	});
+
+	// Root at 0, node 1 is padding so that every sibling pair starts on a cache line.
+	nodes.resize(count * 2 + 2);
+	ctx.nodes = nodes.data();
+	ctx.next_node = 2;
+	nodes[1] = CBvhNode{};
+
+	BuildNode(ctx, 0, 0, count, 0);
+
+	nodes.resize(ctx.next_node);
+	nodes.shrink_to_fit();
+
+	triangles.resize(count);
+
+	ParallelFor(count, 4096, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const uint32_t p = ctx.order[i];
+			const float * v0 = vertices[indices[p * 3 + 0]].Base();
+			const float * v1 = vertices[indices[p * 3 + 1]].Base();
+			const float * v2 = vertices[indices[p * 3 + 2]].Base();
+			CBvhTriangle & tri = triangles[i];
+
+			for (size_t k = 0; k < 3; ++k)
+			{
+				tri.v0[k] = v0[k];
+				tri.e1[k] = v1[k] - v0[k];
+				tri.e2[k] = v2[k] - v0[k];
+			}
+
+			tri.id = p;
+		}
+	});
+}
+
+void UU::CBvh::Clear()
+{
+	nodes.clear();
+	triangles.clear();
+}
+
+bool UU::CBvh::Intersect(const CRay & ray, CRayHit & hit) const
+{
+	if (nodes.empty())
+		return false;
+
+	const float * origin = ray.origin.Base();
+	const float * dir = ray.direction.Base();
+	const float inv_dir[3] = { 1.f / dir[0], 1.f / dir[1], 1.f / dir[2] };
+	float t_max = ray.t_max;
+	float t_near;
+	bool found = false;
+
+	if (!IntersectBox(nodes[0], origin, inv_dir, ray.t_min, t_max, t_near))
+		return false;
+
+	CStackEntry stack[BVH_STACK_SIZE];
+	size_t sp = 0;
+	uint32_t current = 0;
+
+	while (true)
+	{
+		const CBvhNode & node = nodes[current];
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+			{
+				float t, u, v;
+
+				if (!IntersectTriangle(triangles[i], origin, dir, ray.t_min, t_max, t, u, v))
+					continue;
+
+				t_max = t;
+				hit.t = t;
+				hit.u = u;
+				hit.v = v;
+				hit.triangle = triangles[i].id;
+				found = true;
+			}
+		}
+		else
+		{
+			float near_a, near_b;
+			const bool hit_a = IntersectBox(nodes[node.left_first], origin, inv_dir, ray.t_min, t_max, near_a);
+			const bool hit_b = IntersectBox(nodes[node.left_first + 1], origin, inv_dir, ray.t_min, t_max, near_b);
+
+			if (hit_a && hit_b)
+			{
+				const bool a_first = near_a <= near_b;
+
+				stack[sp++] = { node.left_first + (a_first ? 1u : 0u), 1, a_first ? near_b : near_a };
+				current = node.left_first + (a_first ? 0u : 1u);
+				continue;
+			}
+
+			if (hit_a || hit_b)
+			{
+				current = node.left_first + (hit_a ? 0u : 1u);
+				continue;
+			}
+		}
+
+		// Pop, skipping subtrees that start beyond the closest hit found so far.
+		while (sp > 0 && stack[sp - 1].t_near > t_max)
+			--sp;
+
+		if (sp == 0)
+			break;
+
+		current = stack[--sp].node;
+	}
+
+	return found;
+}
+
+bool UU::CBvh::Occluded(const CRay & ray) const
+{
+	if (nodes.empty())
+		return false;
+
+	const float * origin = ray.origin.Base();
+	const float * dir = ray.direction.Base();
+	const float inv_dir[3] = { 1.f / dir[0], 1.f / dir[1], 1.f / dir[2] };
+	float t_near;
+
+	if (!IntersectBox(nodes[0], origin, inv_dir, ray.t_min, ray.t_max, t_near))
+		return false;
+
+	uint32_t stack[BVH_STACK_SIZE];
+	size_t sp = 0;
+
+	stack[sp++] = 0;
+
+	while (sp > 0)
+	{
+		const CBvhNode & node = nodes[stack[--sp]];
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+			{
+				float t, u, v;
+
+				if (IntersectTriangle(triangles[i], origin, dir, ray.t_min, ray.t_max, t, u, v))
+					return true;
+			}
+
+			continue;
+		}
+
+		for (uint32_t c = node.left_first; c < node.left_first + 2; ++c)
+		{
+			if (IntersectBox(nodes[c], origin, inv_dir, ray.t_min, ray.t_max, t_near))
+				stack[sp++] = c;
+		}
+	}
+
+	return false;
+}
+
+uint32_t UU::CBvh::Intersect(const CRayPacket8 & packet, CRayHit8 & hit) const
+{
+	for (size_t l = 0; l < 8; ++l)
+	{
+		hit.t[l] = FLT_MAX;
+		hit.u[l] = hit.v[l] = 0.f;
+		hit.triangle[l] = BVH_INVALID_TRIANGLE;
+	}
+
+	if (nodes.empty())
+		return 0;
+
+	CPacketState s(packet);
+	uint32_t result = 0;
+	float t_near;
+
+	const uint32_t root_mask = IntersectBox8(nodes[0], s, s.active, t_near);
+
+	if (root_mask == 0)
+		return 0;
+
+	CStackEntry stack[BVH_STACK_SIZE];
+	size_t sp = 0;
+
+	stack[sp++] = { 0, root_mask, t_near };
+
+	while (sp > 0)
+	{
+		const CStackEntry entry = stack[--sp];
+
+		float t_far = 0.f;
+
+		for (uint32_t m = entry.mask; m != 0; m &= m - 1)
+		{
+			const float t = s.t_max[UU::CountTrailingZeros(m)];
+			t_far = t > t_far ? t : t_far;
+		}
+
+		if (entry.t_near > t_far)
+			continue;
+
+		const CBvhNode & node = nodes[entry.node];
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+				result |= IntersectTriangle8(triangles[i], s, packet, entry.mask, &hit);
+
+			continue;
+		}
+
+		float near_a, near_b;
+		const uint32_t mask_a = IntersectBox8(nodes[node.left_first], s, entry.mask, near_a);
+		const uint32_t mask_b = IntersectBox8(nodes[node.left_first + 1], s, entry.mask, near_b);
+
+		if (mask_a && mask_b)
+		{
+			if (near_a <= near_b)
+			{
+				stack[sp++] = { node.left_first + 1, mask_b, near_b };
+				stack[sp++] = { node.left_first, mask_a, near_a };
+			}
+			else
+			{
+				stack[sp++] = { node.left_first, mask_a, near_a };
+				stack[sp++] = { node.left_first + 1, mask_b, near_b };
+			}
+		}
+		else if (mask_a)
+		{
+			stack[sp++] = { node.left_first, mask_a, near_a };
+		}
+		else if (mask_b)
+		{
+			stack[sp++] = { node.left_first + 1, mask_b, near_b };
+		}
+	}
+
+	return result;
+}
+
+uint32_t UU::CBvh::Occluded(const CRayPacket8 & packet) const
+{
+	if (nodes.empty())
+		return 0;
+
+	CPacketState s(packet);
+	uint32_t result = 0;
+	float t_near;
+
+	const uint32_t root_mask = IntersectBox8(nodes[0], s, s.active, t_near);
+
+	if (root_mask == 0)
+		return 0;
+
+	CStackEntry stack[BVH_STACK_SIZE];
+	size_t sp = 0;
+
+	stack[sp++] = { 0, root_mask, t_near };
+
+	while (sp > 0)
+	{
+		const CStackEntry entry = stack[--sp];
+		const uint32_t mask = entry.mask & ~result;
+
+		if (mask == 0)
+			continue;
+
+		const CBvhNode & node = nodes[entry.node];
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.left_first; i < node.left_first + node.count; ++i)
+			{
+				// Lanes drop out of the mask as soon as they hit, so the t_max shortening is harmless here.
+				result |= IntersectTriangle8(triangles[i], s, packet, mask & ~result, nullptr);
+
+				if ((mask & ~result) == 0)
+					break;
+			}
+
+			if ((s.active & ~result) == 0)
+				return result;
+
+			continue;
+		}
+
+		for (uint32_t c = node.left_first; c < node.left_first + 2; ++c)
+		{
+			const uint32_t child_mask = IntersectBox8(nodes[c], s, mask, t_near);
+
+			if (child_mask)
+				stack[sp++] = { c, child_mask, t_near };
+		}
+	}
+
+	return result;
+}
+
+bool UU::CBvh::Empty() const
+{
+	return nodes.empty();
+}
+
+size_t UU::CBvh::NodeCount() const
+{
+	return nodes.size();
+}
+
+size_t UU::CBvh::TriangleCount() const
+{
+	return triangles.size();
+}
+
+UU::CSpan<const UU::CBvhNode> UU::CBvh::Nodes() const
+{
+	return CSpan<const CBvhNode>(nodes.data(), nodes.size());
+}
+
+UU::CSpan<const UU::CBvhTriangle> UU::CBvh::Triangles() const
+{
+	return CSpan<const CBvhTriangle>(triangles.data(), triangles.size());
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Math.hpp"
+#include "Memory.hpp"
+#include "Span.hpp"
+#include "VectorView.hpp"
+
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+namespace UU
+{
+	constexpr uint32_t BVH_INVALID_TRIANGLE = 0xFFFFFFFFu;
+
+	class CRay final
+	{
+	public:
+
+		CVec3f			origin, direction;
+		float			t_min, t_max;
+
+		CRay() : origin(0.f, 0.f, 0.f), direction(0.f, 0.f, 1.f), t_min(0.f), t_max(FLT_MAX) {}
+
+		CRay(const CVec3f & o, const CVec3f & d, float min_t = 0.f, float max_t = FLT_MAX)
+			: origin(o), direction(d), t_min(min_t), t_max(max_t) {}
+	};
+
+	class CRayHit final
+	{
+	public:
+
+		float			t = FLT_MAX, u = 0.f, v = 0.f;
+		uint32_t		triangle = BVH_INVALID_TRIANGLE;
+
+		bool			IsHit() const { return triangle != BVH_INVALID_TRIANGLE; }
+	};
+
+	// Eight rays in SoA layout, traversed together as one 8 lane register with AVX2 and two 4 lane ones
+	// otherwise. Lanes with t_min > t_max are inactive.
+	class alignas(32) CRayPacket8 final
+	{
+	public:
+
+		float			origin[3][8];
+		float			direction[3][8];
+		float			t_min[8];
+		float			t_max[8];
+
+		CRayPacket8();
+
+		void			SetRay(size_t lane, const CRay & ray);
+		CRay			GetRay(size_t lane) const;
+	};
+
+	class alignas(32) CRayHit8 final
+	{
+	public:
+
+		float			t[8];
+		float			u[8];
+		float			v[8];
+		uint32_t		triangle[8];
+
+		CRayHit			GetHit(size_t lane) const;
+	};
+
+	// 32 bytes, so a sibling pair always shares one cache line. Interior nodes have count == 0
+	// and their children at left_first and left_first + 1; leaves own triangles
+	// [left_first, left_first + count) in the BVH's reordered triangle list.
+	class alignas(32) CBvhNode final
+	{
+	public:
+
+		float			min[3];
+		uint32_t		left_first;
+		float			max[3];
+		uint32_t		count;
+
+		bool			IsLeaf() const { return count != 0; }
+	};
+
+	// Triangle pre-transformed for Moller-Trumbore, stored in leaf order. id is the triangle's
+	// index in the index buffer the BVH was built from.
+	class CBvhTriangle final
+	{
+	public:
+
+		float			v0[3], e1[3], e2[3];
+		uint32_t		id;
+	};
+
+	class CBvh final
+	{
+	private:
+
+		std::vector<CBvhNode, CAlignedAllocator<CBvhNode>>			nodes;
+		std::vector<CBvhTriangle, CAlignedAllocator<CBvhTriangle>>	triangles;
+
+	public:
+
+		CBvh() = default;
+
+		CBvh(CVectorView<const float, 3> vertices, CSpan<const uint32_t> indices, size_t max_leaf_size = 4);
+
+		// SAH build with 16 bins per axis. Large nodes are binned and split on all hardware threads. Deep
+		// chains from clustered input switch to median splits so the tree fits the traversal stack.
+		void					Build(CVectorView<const float, 3> vertices, CSpan<const uint32_t> indices, size_t max_leaf_size = 4);
+		void					Clear();
+
+		// Closest hit. hit.triangle is the index of the triangle in the original index buffer.
+		bool					Intersect(const CRay & ray, CRayHit & hit) const;
+
+		// Any hit within [t_min, t_max], terminating on the first intersection found.
+		bool					Occluded(const CRay & ray) const;
+
+		// Packet variants return a bit mask of the lanes that hit.
+		uint32_t				Intersect(const CRayPacket8 & packet, CRayHit8 & hit) const;
+		uint32_t				Occluded(const CRayPacket8 & packet) const;
+
+		bool					Empty() const;
+		size_t					NodeCount() const;
+		size_t					TriangleCount() const;
+
+		CSpan<const CBvhNode>		Nodes() const;
+		CSpan<const CBvhTriangle>	Triangles() const;
+	};
+}
@@ -1,7 +1,349 @@
 #include "Colour.hpp"
 #include "UU.hpp"
 
+#include <array>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+
+namespace
+{
+	// Channels scaled to [0, 1] with their minimum and maximum, shared by ToHSB, Hue, Saturation and Brightness.
+	void ChannelRange(UU::CColour col, float & r, float & g, float & b, float & min, float & max)
+	{
+		r = col.r / 255.0f;
+		g = col.g / 255.0f;
+		b = col.b / 255.0f;
+
+		min = UU::Min(r, g, b);
+		max = UU::Max(r, g, b);
+	}
+
+	// Hue in degrees, 0 for greys.
+	float HueOf(float r, float g, float b, float min, float max)
+	{
+		if (max == min)
+			return 0.f;
+
+		const float delta = max - min;
+		float hue;
+
+		if (r == max)
+			hue = (g - b) / delta;
+		else if (g == max)
+			hue = 2 + (b - r) / delta;
+		else
+			hue = 4 + (r - g) / delta;
+
+		hue *= 60.f;
+
+		if (hue < 0.f)
+			hue += 360.0f;
+
+		return hue;
+	}
+
+	float SaturationOf(float min, float max)
+	{
+		if (max == min)
+			return 0.f;
+
+		if ((max + min) / 2.0f <= 0.5f)
+			return (max - min) / (max + min);
+
+		return (max - min) / (2 - max - min);
+	}
+
+	// The per pixel conversions above with a select per branch, on lanes of r, g and b already scaled to [0, 1].
+	template <typename V>
+	void ToHSBLanes(const V & r, const V & g, const V & b, V & h, V & s, V & l)
+	{
+		const V zero(0.f);
+		const V min = UU::Min(UU::Min(r, g), b);
+		const V max = UU::Max(UU::Max(r, g), b);
+		const V delta = max - min;
+		const auto grey = max == min;
+
+		V hue = UU::Select(r == max, (g - b) / delta, UU::Select(g == max, V(2.f) + (b - r) / delta, V(4.f) + (r - g) / delta));
+
+		hue = hue * V(60.f);
+		hue = UU::Select(hue < zero, hue + V(360.0f), hue);
+
+		l = (max + min) / V(2.0f);
+		h = UU::Select(grey, zero, hue);
+		s = UU::Select(grey, zero, delta / UU::Select(l <= V(0.5f), max + min, V(2.f) - max - min));
+	}
+
+	template <typename V>
+	void ToColourLanes(const V & h, const V & s, const V & b, V & r_out, V & g_out, V & b_out)
+	{
+		const V one(1.0f);
+		const V hue = UU::Select(h == one, V(0.0f), h * V(6.0f));
+		const V f = hue - UU::Trunc(hue);
+		const V r = b * V(255.0f);
+		const V p = r * (one - s);
+		const V q = r * (one - s * f);
+		const V t = r * (one - (s * (one - f)));
+
+		const auto sector0 = hue < one;
+		const auto sector1 = hue < V(2.0f);
+		const auto sector2 = hue < V(3.0f);
+		const auto sector3 = hue < V(4.0f);
+		const auto sector4 = hue < V(5.0f);
+
+		r_out = UU::Select(sector0, r, UU::Select(sector1, q, UU::Select(sector3, p, UU::Select(sector4, t, r))));
+		g_out = UU::Select(sector0, t, UU::Select(sector2, r, UU::Select(sector3, q, p)));
+		b_out = UU::Select(sector1, p, UU::Select(sector2, t, UU::Select(sector4, r, q)));
+	}
+
+	// Truncation of the per pixel static_cast, clamped so out of range lanes stay defined.
+	template <typename V>
+	void StoreChannel(const V & x, int32_t * out)
+	{
+		UU::StoreInt32(UU::Floor(UU::Min(UU::Max(x, V(0.0f)), V(255.0f))), out);
+	}
+
+	double SrgbToLinearExact(double c)
+	{
+		return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+	}
+
+	double LinearToSrgbExact(double c)
+	{
+		return c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1 / 2.4) - 0.055;
+	}
+
+	// Codes 0 to 255 decoded, followed by the linear alpha values i / 255 so a single index per channel
+	// covers a whole pixel.
+	const float * SrgbDecodeTable()
+	{
+		static const auto table = []
+		{
+			std::array<float, 512> t{};
+
+			for (size_t i = 0; i < 256; ++i)
+			{
+				t[i] = static_cast<float>(SrgbToLinearExact(i / 255.0));
+				t[i + 256] = i / 255.0f;
+			}
+
+			return t;
+		}();
+
+		return table.data();
+	}
+
+	// Floats below 2^-13 all encode to 0 and the largest float below 1 to 255, in between every
+	// exponent is cut into 8 segments by the top 3 mantissa bits. Each entry packs a linear fit over the
+	// next 8 mantissa bits t as bias << 16 | scale, with (bias << 9) + scale * t equal to
+	// (255 * LinearToSrgbExact(c) + 0.5) << 16, so the final shift both rounds and truncates.
+	constexpr uint32_t SRGB_ENCODE_MIN = 0x39000000;
+	constexpr uint32_t SRGB_ENCODE_MAX = 0x3f7fffff;
+	constexpr size_t SRGB_ENCODE_TABLE_SIZE = ((SRGB_ENCODE_MAX - SRGB_ENCODE_MIN) >> 20) + 1;
+
+	float FromBits(uint32_t u)
+	{
+		float f;
+		std::memcpy(&f, &u, sizeof(f));
+
+		return f;
+	}
+
+	uint32_t ToBits(float f)
+	{
+		uint32_t u;
+		std::memcpy(&u, &f, sizeof(u));
+
+		return u;
+	}
+
+	const uint32_t * SrgbEncodeTable()
+	{
+		static const auto table = []
+		{
+			std::array<uint32_t, SRGB_ENCODE_TABLE_SIZE> entries{};
+
+			for (size_t i = 0; i < SRGB_ENCODE_TABLE_SIZE; ++i)
+			{
+				// Least squares line through the midpoints of the 256 steps of t.
+				const uint32_t base = SRGB_ENCODE_MIN + (static_cast<uint32_t>(i) << 20);
+				double sum_y = 0, sum_ty = 0;
+
+				for (uint32_t t = 0; t < 256; ++t)
+				{
+					const double y = 255 * LinearToSrgbExact(static_cast<double>(FromBits(base + (t << 12) + 0x800))) + 0.5;
+
+					sum_y += y;
+					sum_ty += t * y;
+				}
+
+				const double mean_t = 127.5, mean_y = sum_y / 256;
+				const double var_t = (256.0 * 256.0 - 1) / 12;
+				const double slope = (sum_ty / 256 - mean_t * mean_y) / var_t;
+
+				const auto bias = static_cast<uint32_t>(std::lround((mean_y - slope * mean_t) * 128));
+				const auto scale = static_cast<uint32_t>(std::lround(slope * 65536));
+
+				entries[i] = bias << 16 | scale;
+			}
+
+			return entries;
+		}();
+
+		return table.data();
+	}
+
+	uint8_t EncodeSrgb(const uint32_t * table, float c)
+	{
+		// Written so NaN takes the lower bound.
+		if (!(c > FromBits(SRGB_ENCODE_MIN)))
+			c = FromBits(SRGB_ENCODE_MIN);
+
+		if (c > FromBits(SRGB_ENCODE_MAX))
+			c = FromBits(SRGB_ENCODE_MAX);
+
+		const uint32_t u = ToBits(c);
+		const uint32_t entry = table[(u - SRGB_ENCODE_MIN) >> 20];
+		const uint32_t t = (u >> 12) & 0xff;
+
+		return static_cast<uint8_t>((((entry >> 16) << 9) + (entry & 0xffff) * t) >> 16);
+	}
+
+	uint8_t EncodeAlpha(float a)
+	{
+		if (!(a > 0.f))
+			return 0;
+
+		if (a > 1.f)
+			return 255;
+
+		return static_cast<uint8_t>(static_cast<int32_t>(a * 255.f + 0.5f));
+	}
+
+	UU::CLinearColour DecodePixel(const float * table, UU::CColour col)
+	{
+		return UU::CLinearColour(table[col.r], table[col.g], table[col.b], table[col.a + 256]);
+	}
+
+	UU::CColour EncodePixel(const uint32_t * table, const UU::CLinearColour & col)
+	{
+		return UU::CColour(EncodeSrgb(table, col.r), EncodeSrgb(table, col.g), EncodeSrgb(table, col.b), EncodeAlpha(col.a));
+	}
+
+#if defined(UU_AVX2)
+	// 8 pixels per step: the table entries are gathered for all 32 lanes, alpha lanes are then replaced by
+	// their linear encoding and the four registers packed down to bytes.
+	constexpr size_t SRGB_ENCODE_BLOCK = 8;
+
+	__m256i EncodeLanes(const uint32_t * table, __m256 x)
+	{
+		const __m256 lo = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(SRGB_ENCODE_MIN)));
+		const __m256 hi = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(SRGB_ENCODE_MAX)));
+
+		const __m256i u = _mm256_castps_si256(_mm256_min_ps(_mm256_max_ps(x, lo), hi));
+		const __m256i index = _mm256_srli_epi32(_mm256_sub_epi32(u, _mm256_castps_si256(lo)), 20);
+		const __m256i entry = _mm256_i32gather_epi32(reinterpret_cast<const int *>(table), index, 4);
+		const __m256i bias = _mm256_slli_epi32(_mm256_srli_epi32(entry, 16), 9);
+		const __m256i scale = _mm256_and_si256(entry, _mm256_set1_epi32(0xffff));
+		const __m256i t = _mm256_and_si256(_mm256_srli_epi32(u, 12), _mm256_set1_epi32(0xff));
+		const __m256i colour = _mm256_srli_epi32(_mm256_add_epi32(bias, _mm256_madd_epi16(scale, t)), 16);
+
+		const __m256 a = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+		const __m256i alpha = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(a, _mm256_set1_ps(255.f)), _mm256_set1_ps(0.5f)));
+
+		return _mm256_blend_epi32(colour, alpha, 0x88);
+	}
+
+	void EncodeBlock(const uint32_t * table, const UU::CLinearColour * in, UU::CColour * out)
+	{
+		const float * f = in->Base();
+
+		const __m256i q0 = EncodeLanes(table, _mm256_loadu_ps(f));
+		const __m256i q1 = EncodeLanes(table, _mm256_loadu_ps(f + 8));
+		const __m256i q2 = EncodeLanes(table, _mm256_loadu_ps(f + 16));
+		const __m256i q3 = EncodeLanes(table, _mm256_loadu_ps(f + 24));
+
+		// Packing works within 128 bit halves, leaving pixels 0 2 4 6 | 1 3 5 7.
+		const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(q0, q1), _mm256_packs_epi32(q2, q3));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+	}
+#elif defined(UU_SSE2)
+	// 4 pixels per step, as the AVX2 form with the table entries loaded one by one.
+	constexpr size_t SRGB_ENCODE_BLOCK = 4;
+
+	__m128i EncodeLanes(const uint32_t * table, __m128 x)
+	{
+		const __m128 lo = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(SRGB_ENCODE_MIN)));
+		const __m128 hi = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(SRGB_ENCODE_MAX)));
+
+		const __m128i u = _mm_castps_si128(_mm_min_ps(_mm_max_ps(x, lo), hi));
+
+		alignas(16) uint32_t index[4];
+		_mm_store_si128(reinterpret_cast<__m128i *>(index), _mm_srli_epi32(_mm_sub_epi32(u, _mm_castps_si128(lo)), 20));
+
+		const __m128i entry = _mm_setr_epi32(static_cast<int32_t>(table[index[0]]), static_cast<int32_t>(table[index[1]]), static_cast<int32_t>(table[index[2]]), static_cast<int32_t>(table[index[3]]));
+		const __m128i bias = _mm_slli_epi32(_mm_srli_epi32(entry, 16), 9);
+		const __m128i scale = _mm_and_si128(entry, _mm_set1_epi32(0xffff));
+		const __m128i t = _mm_and_si128(_mm_srli_epi32(u, 12), _mm_set1_epi32(0xff));
+		const __m128i colour = _mm_srli_epi32(_mm_add_epi32(bias, _mm_madd_epi16(scale, t)), 16);
+
+		const __m128 a = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.f));
+		const __m128i alpha = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(a, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+		const __m128i alpha_mask = _mm_setr_epi32(0, 0, 0, -1);
+
+		return _mm_or_si128(_mm_andnot_si128(alpha_mask, colour), _mm_and_si128(alpha_mask, alpha));
+	}
+
+	void EncodeBlock(const uint32_t * table, const UU::CLinearColour * in, UU::CColour * out)
+	{
+		const float * f = in->Base();
+
+		const __m128i q0 = EncodeLanes(table, _mm_loadu_ps(f));
+		const __m128i q1 = EncodeLanes(table, _mm_loadu_ps(f + 4));
+		const __m128i q2 = EncodeLanes(table, _mm_loadu_ps(f + 8));
+		const __m128i q3 = EncodeLanes(table, _mm_loadu_ps(f + 12));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(_mm_packs_epi32(q0, q1), _mm_packs_epi32(q2, q3)));
+	}
+#else
+	constexpr size_t SRGB_ENCODE_BLOCK = 1;
+
+	void EncodeBlock(const uint32_t * table, const UU::CLinearColour * in, UU::CColour * out)
+	{
+		*out = EncodePixel(table, *in);
+	}
+#endif
+
+	void DecodeRange(const float * table, const UU::CColour * in, UU::CLinearColour * out, size_t count)
+	{
+		size_t i = 0;
+#if defined(UU_AVX2)
+		// Two pixels per gather, alpha lanes offset into the second half of the table.
+		const __m256i offset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m256i index = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + i))), offset);
+
+			_mm256_storeu_ps(out[i].Base(), _mm256_i32gather_ps(table, index, 4));
+		}
+#endif
+		for (; i < count; ++i)
+			out[i] = DecodePixel(table, in[i]);
+	}
+
+	void EncodeRange(const uint32_t * table, const UU::CLinearColour * in, UU::CColour * out, size_t count)
+	{
+		size_t i = 0;
+
+		for (; i + SRGB_ENCODE_BLOCK <= count; i += SRGB_ENCODE_BLOCK)
+			EncodeBlock(table, in + i, out + i);
+
+		for (; i < count; ++i)
+			out[i] = EncodePixel(table, in[i]);
+	}
+}
 
 
 // CColour - Static Values
@@ -69,44 +411,11 @@ uint32_t UU::CColour::ToD3DColour() const
 
 UU::CHSB UU::CColour::ToHSB() const
 {
-	CHSB temp;
-	const float _r = r / 255.0f,
-		_g = g / 255.0f,
-		_b = b / 255.0f;
-
-	const float max = _r > _g ? _r : _g > _b ? _g : _b,
-		min = _r < _g ? _r : _g < _b ? _g : _b;
+	float _r, _g, _b, min, max;
 
-	temp.b = (max + min) / 2.0f;
+	ChannelRange(*this, _r, _g, _b, min, max);
 
-	if (max != min)
-	{
-		if (temp.b <= 0.5f)
-			temp.s = (max - min) / (max + min);
-		else
-			temp.s = (max - min) / (2 - max - min);
-	}
-	else
-		temp.s = 0;
-
-	const float delta = max - min;
-	float hue = 0.0f;
-
-	if (_r == max)
-		hue = (_g - _b) / delta;
-	else if (_g == max)
-		hue = 2 + (_b - _r) / delta;
-	else if (_b == max)
-		hue = 4 + (_r - _g) / delta;
-
-	hue *= 60;
-
-	if (hue < 0.f)
-		hue += 360.0f;
-
-	temp.h = hue;
-
-	return temp;
+	return CHSB(HueOf(_r, _g, _b, min, max), SaturationOf(min, max), (max + min) / 2.0f);
 }
 
 uint32_t & UU::CColour::AsRawColour()
@@ -129,71 +438,36 @@ UU::CColour UU::CColour::WithAlpha(uint8_t a) const
 
 float UU::CColour::Hue() const
 {
-	if (r == g && g == b)
-		return 0.f;
-
-	const float _r = r / 255.0f,
-		_g = g / 255.0f,
-		_b = b / 255.0f;
+	float _r, _g, _b, min, max;
 
-	const float max = _r > _g ? _r : _g > _b ? _g : _b,
-		min = _r < _g ? _r : _g < _b ? _g : _b;
-	const float delta = max - min;
-	float hue = 0.f;
-
-	if (_r == max)
-	{
-		hue = (_g - _b) / delta;
-	}
-	else if (_g == max)
-	{
-		hue = 2 + (_b - _r) / delta;
-	}
-	else if (_b == max)
-	{
-		hue = 4 + (_r - _g) / delta;
-	}
-	hue *= 60.f;
+	ChannelRange(*this, _r, _g, _b, min, max);
 
-	if (hue < 0.f)
-	{
-		hue += 360.0f;
-	}
-	return hue;
+	return HueOf(_r, _g, _b, min, max);
 }
 
 float UU::CColour::Saturation() const
 {
-	const float _r = r / 255.0f,
-		_g = g / 255.0f,
-		_b = b / 255.0f;
+	float _r, _g, _b, min, max;
 
-	const float max = _r > _g ? _r : _g > _b ? _g : _b,
-		min = _r < _g ? _r : _g < _b ? _g : _b;
-	float l, s = 0;
+	ChannelRange(*this, _r, _g, _b, min, max);
 
-	if (max != min)
-	{
-		l = (max + min) / 2;
-		if (l <= 0.5f)
-			s = (max - min) / (max + min);
-		else
-			s = (max - min) / (2 - max - min);
-	}
-	return s;
+	return SaturationOf(min, max);
 }
 
 float UU::CColour::Brightness() const
 {
-	const float _r = r / 255.0f,
-		_g = g / 255.0f,
-		_b = b / 255.0f;
+	float _r, _g, _b, min, max;
+
+	ChannelRange(*this, _r, _g, _b, min, max);
 
-	const float	max = _r > _g ? _r : _g > _b ? _g : _b,
-		min = _r < _g ? _r : _g < _b ? _g : _b;
 	return (max + min) / 2.0f;
 }
 
+UU::CLinearColour UU::CColour::ToLinear() const
+{
+	return DecodePixel(SrgbDecodeTable(), *this);
+}
+
 // CHSB - Function Definitions
 
 float & UU::CHSB::operator[](const int i)
@@ -263,4 +537,262 @@ UU::CColour UU::CHSB::ToColour() const
 		return CColour(t, p, r);
 
 	return CColour(r, p, q);
-}
\ No newline at end of file
+}
+
+// CLinearColour - Function Definitions
+
+float & UU::CLinearColour::operator[](const int i)
+{
+	return reinterpret_cast<float *>(this)[i];
+}
+
+float UU::CLinearColour::operator[](const int i) const
+{
+	return reinterpret_cast<const float *>(this)[i];
+}
+
+float * UU::CLinearColour::Base()
+{
+	return reinterpret_cast<float *>(this);
+}
+
+float const * UU::CLinearColour::Base() const
+{
+	return reinterpret_cast<float const *>(this);
+}
+
+void UU::CLinearColour::CopyToArray(float * f) const
+{
+	f[0] = r;
+	f[1] = g;
+	f[2] = b;
+	f[3] = a;
+}
+
+bool UU::CLinearColour::operator==(const CLinearColour & col) const
+{
+	return r == col.r
+		&& g == col.g
+		&& b == col.b
+		&& a == col.a;
+}
+
+bool UU::CLinearColour::operator!=(const CLinearColour & col) const
+{
+	return !(*this == col);
+}
+
+UU::CLinearColour UU::CLinearColour::operator+(const CLinearColour & col) const
+{
+	return CLinearColour(r + col.r, g + col.g, b + col.b, a + col.a);
+}
+
+UU::CLinearColour UU::CLinearColour::operator-(const CLinearColour & col) const
+{
+	return CLinearColour(r - col.r, g - col.g, b - col.b, a - col.a);
+}
+
+UU::CLinearColour UU::CLinearColour::operator*(const CLinearColour & col) const
+{
+	return CLinearColour(r * col.r, g * col.g, b * col.b, a * col.a);
+}
+
+UU::CLinearColour UU::CLinearColour::operator*(const float f) const
+{
+	return CLinearColour(r * f, g * f, b * f, a * f);
+}
+
+UU::CLinearColour UU::CLinearColour::operator/(const float f) const
+{
+	return CLinearColour(r / f, g / f, b / f, a / f);
+}
+
+UU::CLinearColour & UU::CLinearColour::operator+=(const CLinearColour & col)
+{
+	return *this = *this + col;
+}
+
+UU::CLinearColour & UU::CLinearColour::operator-=(const CLinearColour & col)
+{
+	return *this = *this - col;
+}
+
+UU::CLinearColour & UU::CLinearColour::operator*=(const CLinearColour & col)
+{
+	return *this = *this * col;
+}
+
+UU::CLinearColour & UU::CLinearColour::operator*=(const float f)
+{
+	return *this = *this * f;
+}
+
+UU::CLinearColour & UU::CLinearColour::operator/=(const float f)
+{
+	return *this = *this / f;
+}
+
+float UU::CLinearColour::Luminance() const
+{
+	return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+UU::CColour UU::CLinearColour::ToColour() const
+{
+	return EncodePixel(SrgbEncodeTable(), *this);
+}
+
+UU::CLinearColour UU::CLinearColour::Lerp(const CLinearColour & from, const CLinearColour & to, const float t)
+{
+	return from + (to - from) * t;
+}
+
+// sRGB Transfer
+
+float UU::SrgbToLinear(const float c)
+{
+	return static_cast<float>(SrgbToLinearExact(static_cast<double>(c)));
+}
+
+float UU::LinearToSrgb(const float c)
+{
+	return static_cast<float>(LinearToSrgbExact(static_cast<double>(c)));
+}
+
+float UU::SrgbToLinear8(const uint8_t c)
+{
+	return SrgbDecodeTable()[c];
+}
+
+uint8_t UU::LinearToSrgb8(const float c)
+{
+	return EncodeSrgb(SrgbEncodeTable(), c);
+}
+
+UU::CColour UU::Mix(const CColour from, const CColour to, const float t)
+{
+	return CLinearColour::Lerp(from.ToLinear(), to.ToLinear(), t).ToColour();
+}
+
+// Span Conversions
+
+void UU::ToHSB(CSpan<const CColour> in, CSpan<CHSB> out)
+{
+	using V = CSimdNative<float>;
+
+	ParallelFor(in.Size(), COLOUR_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		alignas(64) float r[V::LANES], g[V::LANES], b[V::LANES];
+		alignas(64) float h[V::LANES], s[V::LANES], l[V::LANES];
+
+		size_t i = begin;
+
+		for (; i + V::LANES <= end; i += V::LANES)
+		{
+			for (size_t j = 0; j < V::LANES; ++j)
+			{
+				r[j] = in[i + j].r;
+				g[j] = in[i + j].g;
+				b[j] = in[i + j].b;
+			}
+
+			V vh, vs, vl;
+
+			ToHSBLanes(V::Load(r) / V(255.0f), V::Load(g) / V(255.0f), V::Load(b) / V(255.0f), vh, vs, vl);
+
+			vh.Store(h);
+			vs.Store(s);
+			vl.Store(l);
+
+			for (size_t j = 0; j < V::LANES; ++j)
+				out[i + j] = CHSB(h[j], s[j], l[j]);
+		}
+
+		for (; i < end; ++i)
+			out[i] = in[i].ToHSB();
+	});
+}
+
+void UU::ToColour(CSpan<const CHSB> in, CSpan<CColour> out)
+{
+	using V = CSimdNative<float>;
+
+	ParallelFor(in.Size(), COLOUR_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		alignas(64) float h[V::LANES], s[V::LANES], b[V::LANES];
+		alignas(64) int32_t r_out[V::LANES], g_out[V::LANES], b_out[V::LANES];
+
+		size_t i = begin;
+
+		for (; i + V::LANES <= end; i += V::LANES)
+		{
+			for (size_t j = 0; j < V::LANES; ++j)
+			{
+				h[j] = in[i + j].h;
+				s[j] = in[i + j].s;
+				b[j] = in[i + j].b;
+			}
+
+			V vr, vg, vb;
+
+			ToColourLanes(V::Load(h), V::Load(s), V::Load(b), vr, vg, vb);
+
+			StoreChannel(vr, r_out);
+			StoreChannel(vg, g_out);
+			StoreChannel(vb, b_out);
+
+			for (size_t j = 0; j < V::LANES; ++j)
+				out[i + j] = CColour(static_cast<uint8_t>(r_out[j]), static_cast<uint8_t>(g_out[j]), static_cast<uint8_t>(b_out[j]));
+		}
+
+		for (; i < end; ++i)
+			out[i] = in[i].ToColour();
+	});
+}
+
+void UU::ToLinear(CSpan<const CColour> in, CSpan<CLinearColour> out)
+{
+	const float * table = SrgbDecodeTable();
+
+	ParallelFor(in.Size(), COLOUR_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		DecodeRange(table, in.Data() + begin, out.Data() + begin, end - begin);
+	});
+}
+
+void UU::ToColour(CSpan<const CLinearColour> in, CSpan<CColour> out)
+{
+	const uint32_t * table = SrgbEncodeTable();
+
+	ParallelFor(in.Size(), COLOUR_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		EncodeRange(table, in.Data() + begin, out.Data() + begin, end - begin);
+	});
+}
+
+void UU::Mix(CSpan<const CColour> from, CSpan<const CColour> to, const float t, CSpan<CColour> out)
+{
+	const float * decode = SrgbDecodeTable();
+	const uint32_t * encode = SrgbEncodeTable();
+
+	ParallelFor(from.Size(), COLOUR_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		// Decoded a block at a time so the lerp and the encode stay in cache.
+		constexpr size_t block = 256;
+
+		CLinearColour a[block], b[block];
+
+		for (size_t i = begin; i < end; i += block)
+		{
+			const size_t n = end - i < block ? end - i : block;
+
+			DecodeRange(decode, from.Data() + i, a, n);
+			DecodeRange(decode, to.Data() + i, b, n);
+
+			for (size_t j = 0; j < n; ++j)
+				a[j] = CLinearColour::Lerp(a[j], b[j], t);
+
+			EncodeRange(encode, a, out.Data() + i, n);
+		}
+	});
+}
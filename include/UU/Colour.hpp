@@ -4,10 +4,13 @@
 	#error "Please only include UU.hpp for now"
 #endif
 
+#include <cstddef>
 #include <cstdint>
+#include "Span.hpp"
 
 namespace UU {
 	class CHSB;
+	class CLinearColour;
 	
 	class CColour final
 	{
@@ -44,6 +47,7 @@ namespace UU {
 
 		uint32_t						ToD3DColour() const;
 		CHSB							ToHSB() const;
+		CLinearColour					ToLinear() const;
 
 		uint32_t &						AsRawColour();
 		const uint32_t &				AsRawColour() const;
@@ -95,4 +99,81 @@ namespace UU {
 
 		CColour			ToColour() const;
 	};
+
+	// Straight (not premultiplied) colour in linear light, channels in [0, 1] once decoded from sRGB. Sums,
+	// scales and lerps of these are physically meaningful where the same maths on CColour is not.
+	class CLinearColour final
+	{
+	public:
+
+		float					r, g, b, a;
+
+		CLinearColour() : r(0.f), g(0.f), b(0.f), a(1.f) {}
+		CLinearColour(const CLinearColour & col) = default;
+		CLinearColour(CLinearColour && col) = default;
+		~CLinearColour() = default;
+
+		CLinearColour(float x, float y, float z, float w = 1.f) : r(x), g(y), b(z), a(w) {}
+
+		float &					operator[](int i);
+		float					operator[](int i) const;
+
+		float *					Base();
+		float const *			Base() const;
+
+		void					CopyToArray(float * f) const;
+
+		CLinearColour &			operator=(const CLinearColour & col) = default;
+		CLinearColour &			operator=(CLinearColour && col) = default;
+
+		bool					operator==(const CLinearColour & col) const;
+		bool					operator!=(const CLinearColour & col) const;
+
+		CLinearColour			operator+(const CLinearColour & col) const;
+		CLinearColour			operator-(const CLinearColour & col) const;
+		CLinearColour			operator*(const CLinearColour & col) const;
+		CLinearColour			operator*(float f) const;
+		CLinearColour			operator/(float f) const;
+
+		CLinearColour &			operator+=(const CLinearColour & col);
+		CLinearColour &			operator-=(const CLinearColour & col);
+		CLinearColour &			operator*=(const CLinearColour & col);
+		CLinearColour &			operator*=(float f);
+		CLinearColour &			operator/=(float f);
+
+		// Rec. 709 relative luminance.
+		float					Luminance() const;
+
+		CColour					ToColour() const;
+
+		static CLinearColour	Lerp(const CLinearColour & from, const CLinearColour & to, float t);
+	};
+
+	constexpr size_t COLOUR_PARALLEL_GRAIN = 1 << 14;
+
+	// Whole buffer forms of CColour::ToHSB and CHSB::ToColour with the same results, branch free over
+	// CSimdNative<float> lanes and split across threads above COLOUR_PARALLEL_GRAIN pixels. in and out have
+	// the same size, CHSB components outside the range ToHSB produces are clamped to a valid colour.
+	void				ToHSB(CSpan<const CColour> in, CSpan<CHSB> out);
+	void				ToColour(CSpan<const CHSB> in, CSpan<CColour> out);
+
+	// The sRGB transfer curve, exact, on [0, 1].
+	float				SrgbToLinear(float c);
+	float				LinearToSrgb(float c);
+
+	// Table driven forms used by CColour::ToLinear and CLinearColour::ToColour. Decoding reads a 256 entry
+	// table, encoding a 104 entry table of linear segments indexed by the float's exponent and top mantissa
+	// bits, within 0.6 of a step of the exact curve and monotonic. NaN and values below 0 encode to 0,
+	// values above 1 to 255.
+	float				SrgbToLinear8(uint8_t c);
+	uint8_t				LinearToSrgb8(float c);
+
+	// Whole buffer forms of CColour::ToLinear and CLinearColour::ToColour with the same results. Encoding runs
+	// 4 pixels per step with SSE2 and 8 with AVX2. Alpha is stored linearly in both formats.
+	void				ToLinear(CSpan<const CColour> in, CSpan<CLinearColour> out);
+	void				ToColour(CSpan<const CLinearColour> in, CSpan<CColour> out);
+
+	// Interpolation in linear light, t = 0 gives from and t = 1 gives to.
+	CColour				Mix(CColour from, CColour to, float t);
+	void				Mix(CSpan<const CColour> from, CSpan<const CColour> to, float t, CSpan<CColour> out);
 }
\ No newline at end of file
@@ -0,0 +1,483 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Math.hpp"
+#include "Simd.hpp"
+#include "Span.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace UU
+{
+	// Division by a runtime constant as a high multiply by a precomputed magic number and a shift, after
+	// libdivide (Granlund and Montgomery). Construction costs about one hardware division, every Divide
+	// afterwards a multiply, an add and a shift, and powers of two only shift. Results match the built in
+	// operators: quotients round toward zero and remainders take the sign of the numerator.
+	// T is int32_t, uint32_t, int64_t or uint64_t, and the divisor must not be 0.
+	template <typename T>
+	class CDivisor final
+	{
+		static_assert(std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8), "CDivisor supports 32 and 64 bit integers");
+
+	public:
+		using TUnsigned = std::make_unsigned_t<T>;
+
+		// Flags stored above the shift amount.
+		static constexpr uint8_t SHIFT_MASK = sizeof(T) * 8 - 1;
+		static constexpr uint8_t ADD_MARKER = 0x40;
+		static constexpr uint8_t NEGATIVE_DIVISOR = 0x80;
+
+		T					divisor = T(1);
+		TUnsigned			magic = 0;
+		uint8_t				shift = 0;
+
+		// |divisor| = odd * 2^trailing, inverse * odd = 1 modulo 2^bits and limit = max / |divisor|.
+		TUnsigned			inverse = 1;
+		TUnsigned			limit = std::numeric_limits<TUnsigned>::max();
+		uint8_t				trailing = 0;
+
+		CDivisor() = default;
+		explicit CDivisor(T d);
+
+		bool				IsPowerOfTwo() const;
+
+		T					Divide(T numerator) const;
+		T					Mod(T numerator) const;
+
+		// numerator % divisor == 0 with one multiply and a rotate.
+		bool				Divides(T numerator) const;
+
+		// Element-wise forms, out may alias in. 32-bit lanes are divided 4 or 8 at a time with SSE2 or AVX2,
+		// 64-bit lanes use the scalar multiply as there is no packed 64-bit high multiply.
+		void				Divide(CSpan<const T> in, CSpan<T> out) const;
+		void				Mod(CSpan<const T> in, CSpan<T> out) const;
+	};
+
+	template <typename T>
+	T operator/(T numerator, const CDivisor<T> & d);
+	template <typename T>
+	T operator%(T numerator, const CDivisor<T> & d);
+
+	// Mod(a, b) for a divisor reused across many calls.
+	template <typename T>
+	T Mod(T a, const CDivisor<T> & b);
+}
+
+namespace UU
+{
+	namespace Detail
+	{
+		// (high * 2^bits) / d and its remainder, high < d.
+		inline uint32_t DivideWide(uint32_t high, uint32_t d, uint32_t & rem)
+		{
+			const uint64_t n = static_cast<uint64_t>(high) << 32;
+
+			rem = static_cast<uint32_t>(n % d);
+
+			return static_cast<uint32_t>(n / d);
+		}
+
+		inline uint64_t DivideWide(uint64_t high, uint64_t d, uint64_t & rem)
+		{
+#if defined(_MSC_VER)
+			return _udiv128(high, 0, d, &rem);
+#else
+			const unsigned __int128 n = static_cast<unsigned __int128>(high) << 64;
+
+			rem = static_cast<uint64_t>(n % d);
+
+			return static_cast<uint64_t>(n / d);
+#endif
+		}
+
+		// High half of the full width product.
+		inline uint32_t MulHigh(uint32_t a, uint32_t b)
+		{
+			return static_cast<uint32_t>((static_cast<uint64_t>(a) * b) >> 32);
+		}
+
+		inline int32_t MulHigh(int32_t a, int32_t b)
+		{
+			return static_cast<int32_t>((static_cast<int64_t>(a) * b) >> 32);
+		}
+
+		inline uint64_t MulHigh(uint64_t a, uint64_t b)
+		{
+#if defined(_MSC_VER)
+			return __umulh(a, b);
+#else
+			return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#endif
+		}
+
+		inline int64_t MulHigh(int64_t a, int64_t b)
+		{
+#if defined(_MSC_VER)
+			return __mulh(a, b);
+#else
+			return static_cast<int64_t>((static_cast<__int128>(a) * b) >> 64);
+#endif
+		}
+
+#if defined(UU_AVX2)
+		// 32-bit integer lanes for the batch division.
+		class CDivideLanes final
+		{
+		public:
+			using TVec = __m256i;
+
+			static constexpr size_t LANES = 8;
+
+			static TVec Load(const void * p) { return _mm256_loadu_si256(static_cast<const __m256i *>(p)); }
+			static void Store(void * p, TVec a) { _mm256_storeu_si256(static_cast<__m256i *>(p), a); }
+			static TVec Set(uint32_t x) { return _mm256_set1_epi32(static_cast<int32_t>(x)); }
+
+			static TVec Add(TVec a, TVec b) { return _mm256_add_epi32(a, b); }
+			static TVec Sub(TVec a, TVec b) { return _mm256_sub_epi32(a, b); }
+			static TVec And(TVec a, TVec b) { return _mm256_and_si256(a, b); }
+			static TVec Xor(TVec a, TVec b) { return _mm256_xor_si256(a, b); }
+			static TVec MulLow(TVec a, TVec b) { return _mm256_mullo_epi32(a, b); }
+
+			static TVec ShiftRight(TVec a, int s) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(s)); }
+			static TVec ShiftRightArith(TVec a, int s) { return _mm256_sra_epi32(a, _mm_cvtsi32_si128(s)); }
+
+			// Unsigned high multiply, even lanes from one 32x32->64 multiply and odd lanes from another.
+			static TVec MulHigh(TVec a, TVec b)
+			{
+				const TVec even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32);
+				const TVec odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+
+				return _mm256_blend_epi32(even, odd, 0xAA);
+			}
+		};
+#elif defined(UU_SSE2)
+		class CDivideLanes final
+		{
+		public:
+			using TVec = __m128i;
+
+			static constexpr size_t LANES = 4;
+
+			static TVec Load(const void * p) { return _mm_loadu_si128(static_cast<const __m128i *>(p)); }
+			static void Store(void * p, TVec a) { _mm_storeu_si128(static_cast<__m128i *>(p), a); }
+			static TVec Set(uint32_t x) { return _mm_set1_epi32(static_cast<int32_t>(x)); }
+
+			static TVec Add(TVec a, TVec b) { return _mm_add_epi32(a, b); }
+			static TVec Sub(TVec a, TVec b) { return _mm_sub_epi32(a, b); }
+			static TVec And(TVec a, TVec b) { return _mm_and_si128(a, b); }
+			static TVec Xor(TVec a, TVec b) { return _mm_xor_si128(a, b); }
+
+			static TVec ShiftRight(TVec a, int s) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(s)); }
+			static TVec ShiftRightArith(TVec a, int s) { return _mm_sra_epi32(a, _mm_cvtsi32_si128(s)); }
+
+			static TVec MulHigh(TVec a, TVec b)
+			{
+				const TVec even = _mm_srli_epi64(_mm_mul_epu32(a, b), 32);
+				const TVec odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+				return _mm_or_si128(even, _mm_and_si128(odd, _mm_set_epi32(-1, 0, -1, 0)));
+			}
+
+			static TVec MulLow(TVec a, TVec b)
+			{
+	#if defined(UU_SSE4)
+				return _mm_mullo_epi32(a, b);
+	#else
+				const TVec even = _mm_mul_epu32(a, b);
+				const TVec odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+				return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	#endif
+			}
+		};
+#endif
+
+#if defined(UU_SSE2)
+		// CDivisor::Divide for one register of 32-bit lanes.
+		template <typename T>
+		CDivideLanes::TVec DivideLanes(CDivideLanes::TVec n, const CDivisor<T> & d)
+		{
+			using L = CDivideLanes;
+			using TVec = L::TVec;
+
+			const int shift = d.shift & CDivisor<T>::SHIFT_MASK;
+
+			if constexpr (std::is_unsigned<T>::value)
+			{
+				if (d.magic == 0)
+					return L::ShiftRight(n, shift);
+
+				const TVec q = L::MulHigh(n, L::Set(d.magic));
+
+				if (d.shift & CDivisor<T>::ADD_MARKER)
+					return L::ShiftRight(L::Add(L::ShiftRight(L::Sub(n, q), 1), q), shift);
+
+				return L::ShiftRight(q, shift);
+			}
+			else
+			{
+				const TVec sign = L::Set(d.shift & CDivisor<T>::NEGATIVE_DIVISOR ? ~0u : 0u);
+
+				if (d.magic == 0)
+				{
+					// Negative numerators are biased by 2^shift - 1 so the shift rounds toward zero.
+					TVec q = L::Add(n, L::And(L::ShiftRightArith(n, 31), L::Set((1u << shift) - 1)));
+
+					q = L::ShiftRightArith(q, shift);
+
+					return L::Sub(L::Xor(q, sign), sign);
+				}
+
+				// Signed high multiply from the unsigned one.
+				const TVec m = L::Set(d.magic);
+
+				TVec q = L::MulHigh(n, m);
+
+				q = L::Sub(q, L::And(L::ShiftRightArith(n, 31), m));
+				q = L::Sub(q, L::And(L::ShiftRightArith(m, 31), n));
+
+				if (d.shift & CDivisor<T>::ADD_MARKER)
+					q = L::Add(q, L::Sub(L::Xor(n, sign), sign));
+
+				q = L::ShiftRightArith(q, shift);
+
+				return L::Add(q, L::ShiftRight(q, 31));
+			}
+		}
+#endif
+	}
+}
+
+template <typename T>
+UU::CDivisor<T>::CDivisor(const T d) :
+	divisor(d)
+{
+	constexpr size_t bits = sizeof(T) * 8;
+
+	TUnsigned abs_d = static_cast<TUnsigned>(d);
+
+	if constexpr (std::is_signed<T>::value)
+	{
+		if (d < T(0))
+			abs_d = TUnsigned(0) - abs_d;
+	}
+
+	const auto floor_log_2 = static_cast<uint8_t>(bits - 1 - CountLeadingZeros(abs_d));
+
+	if ((abs_d & (abs_d - 1)) == 0)
+	{
+		magic = 0;
+		shift = floor_log_2;
+	}
+	else
+	{
+		// Signed magic numbers carry one bit less so they stay positive before the sign is applied.
+		constexpr uint8_t signed_bit = std::is_signed<T>::value ? 1 : 0;
+
+		TUnsigned rem;
+		TUnsigned m = Detail::DivideWide(TUnsigned(1) << (floor_log_2 - signed_bit), abs_d, rem);
+
+		const TUnsigned e = abs_d - rem;
+
+		if (e < (TUnsigned(1) << floor_log_2))
+		{
+			shift = floor_log_2 - signed_bit;
+		}
+		else
+		{
+			// The exact magic number needs one bit more than T, the missing top bit is added back in Divide.
+			const TUnsigned twice_rem = rem + rem;
+
+			m += m;
+
+			if (twice_rem >= abs_d || twice_rem < rem)
+				m += 1;
+
+			shift = floor_log_2 | ADD_MARKER;
+		}
+
+		magic = m + 1;
+
+		if constexpr (std::is_signed<T>::value)
+		{
+			if (d < T(0))
+				magic = TUnsigned(0) - magic;
+		}
+	}
+
+	if constexpr (std::is_signed<T>::value)
+	{
+		if (d < T(0))
+			shift |= NEGATIVE_DIVISOR;
+	}
+
+	// Newton's iteration doubles the correct low bits of the inverse, an odd number is its own inverse to 3 bits.
+	trailing = static_cast<uint8_t>(CountTrailingZeros(abs_d));
+
+	const TUnsigned odd = abs_d >> trailing;
+
+	inverse = odd;
+
+	for (int i = 0; i < 5; ++i)
+		inverse *= TUnsigned(2) - odd * inverse;
+
+	limit = std::numeric_limits<TUnsigned>::max() / abs_d;
+}
+
+template <typename T>
+bool UU::CDivisor<T>::IsPowerOfTwo() const
+{
+	return magic == 0;
+}
+
+template <typename T>
+T UU::CDivisor<T>::Divide(const T numerator) const
+{
+	constexpr size_t bits = sizeof(T) * 8;
+
+	const uint8_t s = shift & SHIFT_MASK;
+
+	if constexpr (std::is_unsigned<T>::value)
+	{
+		if (magic == 0)
+			return numerator >> s;
+
+		const T q = Detail::MulHigh(magic, numerator);
+
+		if (shift & ADD_MARKER)
+			return (((numerator - q) >> 1) + q) >> s;
+
+		return q >> s;
+	}
+	else
+	{
+		const TUnsigned sign = shift & NEGATIVE_DIVISOR ? ~TUnsigned(0) : TUnsigned(0);
+
+		if (magic == 0)
+		{
+			// Negative numerators are biased by 2^s - 1 so the shift rounds toward zero.
+			const TUnsigned mask = (TUnsigned(1) << s) - 1;
+			const T q = static_cast<T>(static_cast<TUnsigned>(numerator) + (static_cast<TUnsigned>(numerator >> (bits - 1)) & mask)) >> s;
+
+			return static_cast<T>((static_cast<TUnsigned>(q) ^ sign) - sign);
+		}
+
+		TUnsigned uq = static_cast<TUnsigned>(Detail::MulHigh(static_cast<T>(magic), numerator));
+
+		if (shift & ADD_MARKER)
+			uq += (static_cast<TUnsigned>(numerator) ^ sign) - sign;
+
+		const T q = static_cast<T>(uq) >> s;
+
+		return q + (q < T(0));
+	}
+}
+
+template <typename T>
+T UU::CDivisor<T>::Mod(const T numerator) const
+{
+	if constexpr (std::is_unsigned<T>::value)
+	{
+		if (magic == 0)
+			return numerator & (divisor - 1);
+	}
+
+	return static_cast<T>(static_cast<TUnsigned>(numerator) - static_cast<TUnsigned>(Divide(numerator)) * static_cast<TUnsigned>(divisor));
+}
+
+template <typename T>
+bool UU::CDivisor<T>::Divides(const T numerator) const
+{
+	constexpr size_t bits = sizeof(T) * 8;
+
+	TUnsigned n = static_cast<TUnsigned>(numerator);
+
+	if constexpr (std::is_signed<T>::value)
+	{
+		if (numerator < T(0))
+			n = TUnsigned(0) - n;
+	}
+
+	// n * inverse is n / odd for multiples of odd and lands above limit otherwise, the rotate moves any
+	// bits below 2^trailing to the top.
+	const TUnsigned x = n * inverse;
+	const TUnsigned rotated = (x >> trailing) | (x << ((bits - trailing) & (bits - 1)));
+
+	return rotated <= limit;
+}
+
+template <typename T>
+void UU::CDivisor<T>::Divide(CSpan<const T> in, CSpan<T> out) const
+{
+	size_t i = 0;
+
+#if defined(UU_SSE2)
+	if constexpr (sizeof(T) == 4)
+	{
+		using L = Detail::CDivideLanes;
+
+		for (; i + L::LANES <= in.Size(); i += L::LANES)
+			L::Store(out.Data() + i, Detail::DivideLanes(L::Load(in.Data() + i), *this));
+	}
+#endif
+
+	for (; i < in.Size(); ++i)
+		out[i] = Divide(in[i]);
+}
+
+template <typename T>
+void UU::CDivisor<T>::Mod(CSpan<const T> in, CSpan<T> out) const
+{
+	size_t i = 0;
+
+#if defined(UU_SSE2)
+	if constexpr (sizeof(T) == 4)
+	{
+		using L = Detail::CDivideLanes;
+
+		const typename L::TVec d = L::Set(static_cast<uint32_t>(divisor));
+		const typename L::TVec mask = L::Set(static_cast<uint32_t>(divisor) - 1);
+
+		if (std::is_unsigned<T>::value && magic == 0)
+		{
+			for (; i + L::LANES <= in.Size(); i += L::LANES)
+				L::Store(out.Data() + i, L::And(L::Load(in.Data() + i), mask));
+		}
+		else
+		{
+			for (; i + L::LANES <= in.Size(); i += L::LANES)
+			{
+				const typename L::TVec n = L::Load(in.Data() + i);
+
+				L::Store(out.Data() + i, L::Sub(n, L::MulLow(Detail::DivideLanes(n, *this), d)));
+			}
+		}
+	}
+#endif
+
+	for (; i < in.Size(); ++i)
+		out[i] = Mod(in[i]);
+}
+
+template <typename T>
+T UU::operator/(const T numerator, const CDivisor<T> & d)
+{
+	return d.Divide(numerator);
+}
+
+template <typename T>
+T UU::operator%(const T numerator, const CDivisor<T> & d)
+{
+	return d.Mod(numerator);
+}
+
+template <typename T>
+T UU::Mod(const T a, const CDivisor<T> & b)
+{
+	return b.Mod(a);
+}
@@ -0,0 +1,614 @@
+#include "../UU.hpp"
+#include "Filter.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	using UU::CColour;
+	using UU::CImageView;
+	using UU::CSpan;
+	using UU::EEdgeMode;
+
+	using V = UU::CSimdNative<float>;
+	using D = UU::CSimd<double, V::LANES / 2>;
+	using TFloats = std::vector<float, UU::CAlignedAllocator<float>>;
+
+	template <typename T>
+	constexpr size_t CHANNELS = std::is_same<T, CColour>::value ? 4 : 1;
+
+	size_t RowGrain(size_t width)
+	{
+		return width > 0 ? (UU::FILTER_PARALLEL_GRAIN + width - 1) / width : 1;
+	}
+
+	// Index of the pixel standing in for i along an axis of n, or -1 for a zero one.
+	ptrdiff_t EdgeIndex(ptrdiff_t i, ptrdiff_t n, EEdgeMode edge)
+	{
+		if (i >= 0 && i < n)
+			return i;
+
+		switch (edge)
+		{
+		case EEdgeMode::Clamp:
+			return i < 0 ? 0 : n - 1;
+		case EEdgeMode::Mirror:
+		{
+			if (n == 1)
+				return 0;
+
+			const ptrdiff_t period = 2 * (n - 1);
+			ptrdiff_t m = i % period;
+
+			if (m < 0)
+				m += period;
+
+			return m < n ? m : period - m;
+		}
+		case EEdgeMode::Wrap:
+		{
+			const ptrdiff_t m = i % n;
+
+			return m < 0 ? m + n : m;
+		}
+		case EEdgeMode::Zero:
+			return -1;
+		}
+
+		return -1;
+	}
+
+	// The passes work on rows of floats, channels interleaved as in the pixels.
+
+	void LoadRow(const CColour * in, float * out, size_t n)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+			const __m128i low = _mm_unpacklo_epi8(bytes, zero), high = _mm_unpackhi_epi8(bytes, zero);
+
+			_mm_storeu_ps(out + 4 * i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)));
+			_mm_storeu_ps(out + 4 * i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)));
+			_mm_storeu_ps(out + 4 * i + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)));
+			_mm_storeu_ps(out + 4 * i + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)));
+		}
+#endif
+
+		for (; i < n; ++i)
+		{
+			out[4 * i] = in[i].r;
+			out[4 * i + 1] = in[i].g;
+			out[4 * i + 2] = in[i].b;
+			out[4 * i + 3] = in[i].a;
+		}
+	}
+
+	void LoadRow(const float * in, float * out, size_t n)
+	{
+		std::memcpy(out, in, n * sizeof(float));
+	}
+
+	uint8_t RoundChannel(float c)
+	{
+		c += 0.5f;
+
+		return !(c > 0.f) ? 0 : c >= 255.f ? 255 : static_cast<uint8_t>(static_cast<int32_t>(c));
+	}
+
+	void StoreRow(const float * in, CColour * out, size_t n)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		// Same rounding as RoundChannel, max taking its second operand for NaN.
+		const __m128 half = _mm_set1_ps(0.5f), low = _mm_setzero_ps(), high = _mm_set1_ps(255.f);
+
+		const auto round = [&](const float * p)
+		{
+			return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_loadu_ps(p), half), low), high));
+		};
+
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128i first = _mm_packs_epi32(round(in + 4 * i), round(in + 4 * i + 4));
+			const __m128i second = _mm_packs_epi32(round(in + 4 * i + 8), round(in + 4 * i + 12));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(first, second));
+		}
+#endif
+
+		for (; i < n; ++i)
+			out[i] = CColour(RoundChannel(in[4 * i]), RoundChannel(in[4 * i + 1]), RoundChannel(in[4 * i + 2]), RoundChannel(in[4 * i + 3]));
+	}
+
+	void StoreRow(const float * in, float * out, size_t n)
+	{
+		std::memmove(out, in, n * sizeof(float));
+	}
+
+	// A row of width pixels with left and right pixels of padding filled per the edge mode.
+	template <typename T>
+	void PadRow(const T * row, size_t width, size_t left, size_t right, EEdgeMode edge, float * out)
+	{
+		constexpr size_t ch = CHANNELS<T>;
+
+		LoadRow(row, out + left * ch, width);
+
+		for (size_t i = 0; i < left + right; ++i)
+		{
+			const ptrdiff_t x = i < left ? ptrdiff_t(i) - ptrdiff_t(left) : ptrdiff_t(width + i - left);
+			const ptrdiff_t source = EdgeIndex(x, ptrdiff_t(width), edge);
+			float * dst = out + size_t(x + ptrdiff_t(left)) * ch;
+
+			for (size_t c = 0; c < ch; ++c)
+				dst[c] = source < 0 ? 0.f : out[(size_t(source) + left) * ch + c];
+		}
+	}
+
+	// out[i] = sum of kernel[k] * in[i + k * step], four registers at a time to hide the MulAdd latency.
+	void ConvolveFlat(const float * in, float * out, size_t n, const float * kernel, size_t taps, size_t step)
+	{
+		size_t i = 0;
+
+		for (; i + 4 * V::LANES <= n; i += 4 * V::LANES)
+		{
+			V acc0(0.f), acc1(0.f), acc2(0.f), acc3(0.f);
+
+			for (size_t k = 0; k < taps; ++k)
+			{
+				const V w(kernel[k]);
+				const float * p = in + i + k * step;
+
+				acc0 = MulAdd(w, V::Load(p), acc0);
+				acc1 = MulAdd(w, V::Load(p + V::LANES), acc1);
+				acc2 = MulAdd(w, V::Load(p + 2 * V::LANES), acc2);
+				acc3 = MulAdd(w, V::Load(p + 3 * V::LANES), acc3);
+			}
+
+			acc0.Store(out + i);
+			acc1.Store(out + i + V::LANES);
+			acc2.Store(out + i + 2 * V::LANES);
+			acc3.Store(out + i + 3 * V::LANES);
+		}
+
+		for (; i + V::LANES <= n; i += V::LANES)
+		{
+			V acc(0.f);
+
+			for (size_t k = 0; k < taps; ++k)
+				acc = MulAdd(V(kernel[k]), V::Load(in + i + k * step), acc);
+
+			acc.Store(out + i);
+		}
+
+		for (; i < n; ++i)
+		{
+			float acc = 0.f;
+
+			for (size_t k = 0; k < taps; ++k)
+				acc += kernel[k] * in[i + k * step];
+
+			out[i] = acc;
+		}
+	}
+
+	// The same down the columns of a block, rows[k] being the row under kernel[k].
+	void ConvolveColumns(const float * const * rows, float * out, size_t n, const float * kernel, size_t taps)
+	{
+		size_t i = 0;
+
+		for (; i + 4 * V::LANES <= n; i += 4 * V::LANES)
+		{
+			V acc0(0.f), acc1(0.f), acc2(0.f), acc3(0.f);
+
+			for (size_t k = 0; k < taps; ++k)
+			{
+				const V w(kernel[k]);
+				const float * p = rows[k] + i;
+
+				acc0 = MulAdd(w, V::Load(p), acc0);
+				acc1 = MulAdd(w, V::Load(p + V::LANES), acc1);
+				acc2 = MulAdd(w, V::Load(p + 2 * V::LANES), acc2);
+				acc3 = MulAdd(w, V::Load(p + 3 * V::LANES), acc3);
+			}
+
+			acc0.Store(out + i);
+			acc1.Store(out + i + V::LANES);
+			acc2.Store(out + i + 2 * V::LANES);
+			acc3.Store(out + i + 3 * V::LANES);
+		}
+
+		for (; i < n; ++i)
+		{
+			float acc = 0.f;
+
+			for (size_t k = 0; k < taps; ++k)
+				acc += kernel[k] * rows[k][i];
+
+			out[i] = acc;
+		}
+	}
+
+	// Means of every window of 2 radius + 1 pixels of a padded row. One running sum per channel, kept in double
+	// so that adding and removing samples never drifts. A pixel of four channels is a float register, its sums
+	// two double ones.
+	void BoxFlat(const float * in, float * out, size_t width, size_t radius, size_t step)
+	{
+		const size_t window = 2 * radius + 1;
+		const double scale = 1.0 / static_cast<double>(window);
+
+		if (step == 4)
+		{
+			using F4 = UU::CSimd<float, 4>;
+			using D2 = UU::CSimd<double, 2>;
+
+			const D2 s(scale);
+			D2 low(0.0), high(0.0);
+
+			for (size_t k = 0; k < window; ++k)
+			{
+				const F4 f = F4::Load(in + 4 * k);
+
+				low = low + WidenLow(f);
+				high = high + WidenHigh(f);
+			}
+
+			for (size_t x = 0; x < width; ++x)
+			{
+				Narrow(low * s, high * s).Store(out + 4 * x);
+
+				if (x + 1 < width)
+				{
+					const F4 add = F4::Load(in + 4 * (x + window)), sub = F4::Load(in + 4 * x);
+
+					low = low + (WidenLow(add) - WidenLow(sub));
+					high = high + (WidenHigh(add) - WidenHigh(sub));
+				}
+			}
+
+			return;
+		}
+
+		double sum = 0;
+
+		for (size_t k = 0; k < window; ++k)
+			sum += in[k];
+
+		for (size_t x = 0; x < width; ++x)
+		{
+			out[x] = static_cast<float>(sum * scale);
+
+			if (x + 1 < width)
+				sum += static_cast<double>(in[x + window]) - in[x];
+		}
+	}
+
+	// Horizontal filtering of any row, including those past the image, which are filled per the edge mode.
+	template <typename T, typename TFilter>
+	class CRowFilter final
+	{
+	private:
+
+		CImageView<const T>	in;
+		size_t				left, right;
+		EEdgeMode			edge;
+		const TFilter &		filter;
+		TFloats				padded;
+
+	public:
+
+		CRowFilter(CImageView<const T> in, size_t left, size_t right, EEdgeMode edge, const TFilter & filter) :
+			in(in), left(left), right(right), edge(edge), filter(filter), padded((in.Width() + left + right) * CHANNELS<T>)
+		{
+		}
+
+		void operator()(ptrdiff_t y, float * row)
+		{
+			const ptrdiff_t source = EdgeIndex(y, ptrdiff_t(in.Height()), edge);
+
+			if (source < 0)
+			{
+				std::fill(row, row + in.Width() * CHANNELS<T>, 0.f);
+				return;
+			}
+
+			PadRow(in.Row(size_t(source)), in.Width(), left, right, edge, padded.data());
+			filter(padded.data(), row);
+		}
+	};
+
+	template <typename T>
+	bool SameView(CImageView<const T> a, CImageView<T> b)
+	{
+		return a.Bytes() == b.Bytes() && a.Stride() == b.Stride();
+	}
+
+	// Points in at a copy of itself if out overlaps it, unless each row of out depends only on the same row of
+	// in and they are the same view.
+	template <typename T>
+	void Detach(CImageView<const T> & in, CImageView<T> out, bool rows_independent, UU::CImage<T> & copy)
+	{
+		const auto end = [](auto view) { return view.Bytes() + (view.Height() - 1) * view.Stride() + view.Width() * sizeof(T); };
+
+		if (!(in.Bytes() < end(out) && out.Bytes() < end(in)) || (rows_independent && SameView(in, out)))
+			return;
+
+		copy = UU::CImage<T>(in.Width(), in.Height());
+		copy.CopyFrom(in);
+		in = static_cast<const UU::CImage<T> &>(copy).View();
+	}
+
+	template <typename T>
+	void Copy(CImageView<const T> in, CImageView<T> out)
+	{
+		if (SameView(in, out))
+			return;
+
+		UU::ParallelForRows(out, [&](size_t y, CSpan<T> row) { std::memmove(row.Data(), in.Row(y), row.Size() * sizeof(T)); });
+	}
+
+	template <typename T>
+	void ConvolveImage(CImageView<const T> in, CImageView<T> out, CSpan<const float> horizontal, CSpan<const float> vertical, EEdgeMode edge)
+	{
+		constexpr size_t ch = CHANNELS<T>;
+		const size_t width = in.Width(), height = in.Height(), n = width * ch;
+
+		if (width == 0 || height == 0)
+			return;
+
+		// Bands read the rows either side of them, which another band may already have written.
+		UU::CImage<T> copy;
+
+		Detach(in, out, vertical.Empty(), copy);
+
+		if (horizontal.Empty() && vertical.Empty())
+		{
+			Copy(in, out);
+			return;
+		}
+
+		const size_t left = horizontal.Size() / 2, right = horizontal.Empty() ? 0 : horizontal.Size() - 1 - left;
+
+		const auto filter = [&](const float * padded, float * filtered)
+		{
+			if (horizontal.Empty())
+				std::memcpy(filtered, padded, n * sizeof(float));
+			else
+				ConvolveFlat(padded, filtered, n, horizontal.Data(), horizontal.Size(), ch);
+		};
+
+		if (vertical.Empty())
+		{
+			UU::ParallelFor(height, RowGrain(width), [&](size_t, size_t begin, size_t end)
+			{
+				TFloats padded((width + left + right) * ch), filtered(n);
+
+				for (size_t y = begin; y < end; ++y)
+				{
+					PadRow(in.Row(y), width, left, right, edge, padded.data());
+					filter(padded.data(), filtered.data());
+					StoreRow(filtered.data(), out.Row(y), width);
+				}
+			});
+
+			return;
+		}
+
+		const size_t taps = vertical.Size(), top = taps / 2;
+
+		UU::ParallelFor(height, RowGrain(width), [&](size_t, size_t begin, size_t end)
+		{
+			// Filtered rows from first on, a band and the rows under the kernel either side of it at a time.
+			const ptrdiff_t first = ptrdiff_t(begin) - ptrdiff_t(top);
+			const size_t capacity = taps - 1 + UU::FILTER_BLOCK_HEIGHT;
+
+			CRowFilter<T, decltype(filter)> row_filter(in, left, right, edge, filter);
+			TFloats ring(capacity * n);
+			std::vector<const float *> rows(taps);
+			alignas(64) float result[UU::FILTER_BLOCK_WIDTH];
+
+			const auto slot = [&](ptrdiff_t y) { return ring.data() + size_t(y - first) % capacity * n; };
+
+			for (ptrdiff_t y = first; y < first + ptrdiff_t(taps) - 1; ++y)
+				row_filter(y, slot(y));
+
+			for (size_t band = begin; band < end; band += UU::FILTER_BLOCK_HEIGHT)
+			{
+				const size_t band_end = end - band < UU::FILTER_BLOCK_HEIGHT ? end : band + UU::FILTER_BLOCK_HEIGHT;
+
+				for (size_t y = band; y < band_end; ++y)
+				{
+					const ptrdiff_t next = ptrdiff_t(y + taps - 1) - ptrdiff_t(top);
+
+					row_filter(next, slot(next));
+				}
+
+				for (size_t x = 0; x < n; x += UU::FILTER_BLOCK_WIDTH)
+				{
+					const size_t block = n - x < UU::FILTER_BLOCK_WIDTH ? n - x : UU::FILTER_BLOCK_WIDTH;
+
+					for (size_t y = band; y < band_end; ++y)
+					{
+						for (size_t k = 0; k < taps; ++k)
+							rows[k] = slot(ptrdiff_t(y + k) - ptrdiff_t(top)) + x;
+
+						ConvolveColumns(rows.data(), result, block, vertical.Data(), taps);
+						StoreRow(result, out.Row(y) + x / ch, block / ch);
+					}
+				}
+			}
+		});
+	}
+
+	template <typename T>
+	void BoxImage(CImageView<const T> in, CImageView<T> out, size_t radius, EEdgeMode edge)
+	{
+		constexpr size_t ch = CHANNELS<T>;
+		const size_t width = in.Width(), height = in.Height(), n = width * ch;
+
+		if (width == 0 || height == 0)
+			return;
+
+		UU::CImage<T> copy;
+
+		Detach(in, out, radius == 0, copy);
+
+		if (radius == 0)
+		{
+			Copy(in, out);
+			return;
+		}
+
+		const double scale = 1.0 / static_cast<double>(2 * radius + 1);
+		const auto filter = [&](const float * padded, float * filtered) { BoxFlat(padded, filtered, width, radius, ch); };
+
+		// Column sums in double over whole rows, lanes matching the float registers they are widened from. The
+		// row leaving the window is filtered again rather than kept, so memory does not grow with radius.
+		UU::ParallelFor(height, RowGrain(width), [&](size_t, size_t begin, size_t end)
+		{
+			CRowFilter<T, decltype(filter)> row_filter(in, radius, radius, edge, filter);
+			std::vector<double, UU::CAlignedAllocator<double>> sum(n, 0.0);
+			TFloats entering(n), leaving(n), result(n);
+
+			double * s = sum.data();
+			const float * add = entering.data();
+			const float * sub = leaving.data();
+
+			const auto accumulate = [&](bool remove)
+			{
+				size_t i = 0;
+
+				if (remove)
+				{
+					for (; i + V::LANES <= n; i += V::LANES)
+					{
+						const V a = V::Load(add + i), b = V::Load(sub + i);
+
+						(D::Load(s + i) + (WidenLow(a) - WidenLow(b))).Store(s + i);
+						(D::Load(s + i + D::LANES) + (WidenHigh(a) - WidenHigh(b))).Store(s + i + D::LANES);
+					}
+
+					for (; i < n; ++i)
+						s[i] += static_cast<double>(add[i]) - sub[i];
+				}
+				else
+				{
+					for (; i + V::LANES <= n; i += V::LANES)
+					{
+						const V a = V::Load(add + i);
+
+						(D::Load(s + i) + WidenLow(a)).Store(s + i);
+						(D::Load(s + i + D::LANES) + WidenHigh(a)).Store(s + i + D::LANES);
+					}
+
+					for (; i < n; ++i)
+						s[i] += add[i];
+				}
+			};
+
+			for (ptrdiff_t y = ptrdiff_t(begin) - ptrdiff_t(radius); y <= ptrdiff_t(begin + radius); ++y)
+			{
+				row_filter(y, entering.data());
+				accumulate(false);
+			}
+
+			for (size_t y = begin; y < end; ++y)
+			{
+				float * r = result.data();
+				size_t i = 0;
+
+				for (; i + V::LANES <= n; i += V::LANES)
+					Narrow(D::Load(s + i) * D(scale), D::Load(s + i + D::LANES) * D(scale)).Store(r + i);
+
+				for (; i < n; ++i)
+					r[i] = static_cast<float>(s[i] * scale);
+
+				StoreRow(r, out.Row(y), width);
+
+				if (y + 1 < end)
+				{
+					row_filter(ptrdiff_t(y + radius + 1), entering.data());
+					row_filter(ptrdiff_t(y) - ptrdiff_t(radius), leaving.data());
+					accumulate(true);
+				}
+			}
+		});
+	}
+
+	template <typename T>
+	void GaussianImage(CImageView<const T> in, CImageView<T> out, float sigma, EEdgeMode edge)
+	{
+		const std::vector<float> kernel = UU::GaussianKernel(sigma);
+		const CSpan<const float> span(kernel.data(), kernel.size());
+
+		ConvolveImage(in, out, span, span, edge);
+	}
+}
+
+std::vector<float> UU::GaussianKernel(float sigma)
+{
+	if (!(sigma > 0.f))
+		return { 1.f };
+
+	const auto radius = static_cast<size_t>(std::ceil(3.f * sigma));
+
+	std::vector<double> weights(2 * radius + 1);
+	double total = 0;
+
+	for (size_t i = 0; i < weights.size(); ++i)
+	{
+		const double x = static_cast<double>(i) - static_cast<double>(radius);
+
+		weights[i] = std::exp(-x * x / (2.0 * sigma * sigma));
+		total += weights[i];
+	}
+
+	std::vector<float> kernel(weights.size());
+
+	for (size_t i = 0; i < weights.size(); ++i)
+		kernel[i] = static_cast<float>(weights[i] / total);
+
+	return kernel;
+}
+
+void UU::Convolve(CImageView<const CColour> in, CImageView<CColour> out, CSpan<const float> horizontal, CSpan<const float> vertical, EEdgeMode edge)
+{
+	ConvolveImage(in, out, horizontal, vertical, edge);
+}
+
+void UU::Convolve(CImageView<const float> in, CImageView<float> out, CSpan<const float> horizontal, CSpan<const float> vertical, EEdgeMode edge)
+{
+	ConvolveImage(in, out, horizontal, vertical, edge);
+}
+
+void UU::BoxBlur(CImageView<const CColour> in, CImageView<CColour> out, size_t radius, EEdgeMode edge)
+{
+	BoxImage(in, out, radius, edge);
+}
+
+void UU::BoxBlur(CImageView<const float> in, CImageView<float> out, size_t radius, EEdgeMode edge)
+{
+	BoxImage(in, out, radius, edge);
+}
+
+void UU::GaussianBlur(CImageView<const CColour> in, CImageView<CColour> out, float sigma, EEdgeMode edge)
+{
+	GaussianImage(in, out, sigma, edge);
+}
+
+void UU::GaussianBlur(CImageView<const float> in, CImageView<float> out, float sigma, EEdgeMode edge)
+{
+	GaussianImage(in, out, sigma, edge);
+}
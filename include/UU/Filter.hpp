@@ -0,0 +1,50 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Colour.hpp"
+#include "Image.hpp"
+#include "Span.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace UU
+{
+	// Source of pixels beyond the image: the edge pixel, the image reflected about the edge pixel, the
+	// opposite side, or black with zero alpha.
+	enum class EEdgeMode : uint8_t
+	{
+		Clamp,
+		Mirror,
+		Wrap,
+		Zero
+	};
+
+	constexpr size_t FILTER_PARALLEL_GRAIN = 1 << 14;
+
+	// Floats per column block and rows per band of the vertical convolution. Threads keep a band and the rows
+	// under the kernel either side of it horizontally filtered, and walk it a column block at a time so that
+	// those rows stay in L1.
+	constexpr size_t FILTER_BLOCK_WIDTH = 256;
+	constexpr size_t FILTER_BLOCK_HEIGHT = 32;
+
+	// Normalised weights covering 3 sigma either side.
+	std::vector<float>	GaussianKernel(float sigma);
+
+	// Separable convolution, horizontal pass first, where kernel[i] weighs the pixel i - size / 2 away. An empty
+	// kernel skips that axis. Every channel of a CColour, alpha included, is filtered on its own and rounded
+	// back to nearest. The passes run in float over bands of rows split across threads, without an
+	// intermediate image. in and out have the same size and may overlap, at the cost of a copy of in.
+	void				Convolve(CImageView<const CColour> in, CImageView<CColour> out, CSpan<const float> horizontal, CSpan<const float> vertical, EEdgeMode edge = EEdgeMode::Clamp);
+	void				Convolve(CImageView<const float> in, CImageView<float> out, CSpan<const float> horizontal, CSpan<const float> vertical, EEdgeMode edge = EEdgeMode::Clamp);
+
+	// Mean over a (2 radius + 1) square from running sums, so the cost per pixel does not depend on radius.
+	void				BoxBlur(CImageView<const CColour> in, CImageView<CColour> out, size_t radius, EEdgeMode edge = EEdgeMode::Clamp);
+	void				BoxBlur(CImageView<const float> in, CImageView<float> out, size_t radius, EEdgeMode edge = EEdgeMode::Clamp);
+
+	void				GaussianBlur(CImageView<const CColour> in, CImageView<CColour> out, float sigma, EEdgeMode edge = EEdgeMode::Clamp);
+	void				GaussianBlur(CImageView<const float> in, CImageView<float> out, float sigma, EEdgeMode edge = EEdgeMode::Clamp);
+}
@@ -0,0 +1,309 @@
+#include "../UU.hpp"
+#include "Frustum.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	using V = UU::CSimdNative<float>;
+
+	// Objects classified per block, a whole number of registers of any width.
+	constexpr size_t CULL_BLOCK = 16;
+
+	// CULL_BLOCK objects in SoA form: centres, and a radius in ex or half extents in ex/ey/ez.
+	class CCullBlock
+	{
+	public:
+
+		alignas(64) float	cx[CULL_BLOCK], cy[CULL_BLOCK], cz[CULL_BLOCK];
+		alignas(64) float	ex[CULL_BLOCK], ey[CULL_BLOCK], ez[CULL_BLOCK];
+	};
+
+	template <bool box>
+	UU::ECullResult ClassifyOne(const UU::CFrustum & f, float cx, float cy, float cz, float ex, float ey, float ez)
+	{
+		UU::ECullResult result = UU::ECullResult::Inside;
+
+		for (const UU::CVec4f & p : f.planes)
+		{
+			const float dist = p[0] * cx + p[1] * cy + p[2] * cz + p[3];
+			const float rad = box ? UU::Abs(p[0]) * ex + UU::Abs(p[1]) * ey + UU::Abs(p[2]) * ez : ex;
+
+			if (dist < -rad)
+				return UU::ECullResult::Outside;
+
+			if (dist < rad)
+				result = UU::ECullResult::Intersecting;
+		}
+
+		return result;
+	}
+
+	template <bool box>
+	void ClassifyBlock(const UU::CFrustum & f, const CCullBlock & b, size_t n, UU::ECullResult * out)
+	{
+		for (size_t l = 0; l < n; l += V::LANES)
+		{
+			const V cx = V::Load(b.cx + l), cy = V::Load(b.cy + l), cz = V::Load(b.cz + l);
+			const V ex = V::Load(b.ex + l);
+			uint32_t outside = 0, intersect = 0;
+
+			for (const UU::CVec4f & p : f.planes)
+			{
+				const V dist = V(p[0]) * cx + V(p[1]) * cy + V(p[2]) * cz + V(p[3]);
+				V rad = ex;
+
+				if constexpr (box)
+					rad = V(UU::Abs(p[0])) * ex + V(UU::Abs(p[1])) * V::Load(b.ey + l) + V(UU::Abs(p[2])) * V::Load(b.ez + l);
+
+				outside |= UU::MoveMask(dist < -rad);
+				intersect |= UU::MoveMask(dist < rad);
+			}
+
+			// Outside 0, Intersecting 1 and Inside 2, whichever way round the two tests came out.
+			intersect |= outside;
+
+			for (size_t k = 0; k < V::LANES && l + k < n; ++k)
+				out[l + k] = static_cast<UU::ECullResult>(2 - ((intersect >> k) & 1) - ((outside >> k) & 1));
+		}
+	}
+
+	// Copies n floats stride bytes apart into a block row.
+	void CopyStrided(const uint8_t * p, size_t stride, size_t n, float * row)
+	{
+		for (size_t l = 0; l < n; ++l)
+			std::memcpy(row + l, p + l * stride, sizeof(float));
+	}
+
+	template <bool box, typename Load>
+	void ClassifyRange(const UU::CFrustum & f, size_t begin, size_t end, Load & load, UU::ECullResult * out)
+	{
+		CCullBlock block = {};
+
+		for (size_t i = begin; i < end; i += CULL_BLOCK)
+		{
+			const size_t n = end - i < CULL_BLOCK ? end - i : CULL_BLOCK;
+
+			load(i, n, block);
+			ClassifyBlock<box>(f, block, n, out + i);
+		}
+	}
+
+	template <bool box, typename Load>
+	void Classify(const UU::CFrustum & f, size_t count, Load && load, UU::CSpan<UU::ECullResult> out)
+	{
+		UU::ParallelFor(count, UU::FRUSTUM_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+		{
+			ClassifyRange<box>(f, begin, end, load, out.Data());
+		});
+	}
+
+	template <bool box, typename Load>
+	size_t Cull(const UU::CFrustum & f, size_t count, Load && load, std::vector<uint32_t> & indices, UU::ECullResult keep)
+	{
+		std::vector<std::vector<uint32_t>> local(UU::ParallelChunkCount(count, UU::FRUSTUM_PARALLEL_GRAIN));
+
+		UU::ParallelFor(count, UU::FRUSTUM_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+		{
+			std::vector<uint32_t> & visible = local[chunk];
+			CCullBlock block = {};
+			UU::ECullResult results[CULL_BLOCK];
+
+			visible.reserve(end - begin);
+
+			for (size_t i = begin; i < end; i += CULL_BLOCK)
+			{
+				const size_t n = end - i < CULL_BLOCK ? end - i : CULL_BLOCK;
+
+				load(i, n, block);
+				ClassifyBlock<box>(f, block, n, results);
+
+				for (size_t l = 0; l < n; ++l)
+				{
+					if (results[l] >= keep)
+						visible.push_back(static_cast<uint32_t>(i + l));
+				}
+			}
+		});
+
+		const size_t first = indices.size();
+		size_t total = 0;
+
+		for (const std::vector<uint32_t> & visible : local)
+			total += visible.size();
+
+		indices.resize(first + total);
+
+		for (size_t c = 0, offset = first; c < local.size(); offset += local[c].size(), ++c)
+			std::copy(local[c].begin(), local[c].end(), indices.begin() + offset);
+
+		return total;
+	}
+
+	auto LoadSpheres(UU::CVectorView<const float, 3> centers, UU::CSpan<const float> radii)
+	{
+		return [centers, radii](size_t i, size_t n, CCullBlock & b)
+		{
+			const uint8_t * p = centers.Bytes() + i * centers.Stride();
+
+			CopyStrided(p, centers.Stride(), n, b.cx);
+			CopyStrided(p + sizeof(float), centers.Stride(), n, b.cy);
+			CopyStrided(p + 2 * sizeof(float), centers.Stride(), n, b.cz);
+			std::copy_n(radii.Data() + i, n, b.ex);
+		};
+	}
+
+	auto LoadSpheres(UU::CVectorView<const float, 4> spheres)
+	{
+		return [spheres](size_t i, size_t n, CCullBlock & b)
+		{
+			const uint8_t * p = spheres.Bytes() + i * spheres.Stride();
+
+			CopyStrided(p, spheres.Stride(), n, b.cx);
+			CopyStrided(p + sizeof(float), spheres.Stride(), n, b.cy);
+			CopyStrided(p + 2 * sizeof(float), spheres.Stride(), n, b.cz);
+			CopyStrided(p + 3 * sizeof(float), spheres.Stride(), n, b.ex);
+		};
+	}
+
+	auto LoadSpheres(const UU::CSphereSoA & spheres)
+	{
+		return [&spheres](size_t i, size_t n, CCullBlock & b)
+		{
+			std::copy_n(spheres.x.Data() + i, n, b.cx);
+			std::copy_n(spheres.y.Data() + i, n, b.cy);
+			std::copy_n(spheres.z.Data() + i, n, b.cz);
+			std::copy_n(spheres.radius.Data() + i, n, b.ex);
+		};
+	}
+
+	auto LoadAABoxes(UU::CSpan<const UU::CAABox3f> boxes)
+	{
+		return [boxes](size_t i, size_t n, CCullBlock & b)
+		{
+			for (size_t l = 0; l < n; ++l)
+			{
+				const UU::CAABox3f & box = boxes[i + l];
+
+				b.cx[l] = (box.min[0] + box.max[0]) * 0.5f;
+				b.cy[l] = (box.min[1] + box.max[1]) * 0.5f;
+				b.cz[l] = (box.min[2] + box.max[2]) * 0.5f;
+				b.ex[l] = (box.max[0] - box.min[0]) * 0.5f;
+				b.ey[l] = (box.max[1] - box.min[1]) * 0.5f;
+				b.ez[l] = (box.max[2] - box.min[2]) * 0.5f;
+			}
+		};
+	}
+
+	// Centre and half extent of one axis from contiguous min and max rows.
+	void LoadAxis(const float * min, const float * max, size_t n, float * centre, float * extent)
+	{
+		for (size_t l = 0; l < n; ++l)
+		{
+			centre[l] = (min[l] + max[l]) * 0.5f;
+			extent[l] = (max[l] - min[l]) * 0.5f;
+		}
+	}
+
+	auto LoadAABoxes(const UU::CAABoxSoA & boxes)
+	{
+		return [&boxes](size_t i, size_t n, CCullBlock & b)
+		{
+			LoadAxis(boxes.min_x.Data() + i, boxes.max_x.Data() + i, n, b.cx, b.ex);
+			LoadAxis(boxes.min_y.Data() + i, boxes.max_y.Data() + i, n, b.cy, b.ey);
+			LoadAxis(boxes.min_z.Data() + i, boxes.max_z.Data() + i, n, b.cz, b.ez);
+		};
+	}
+}
+
+// CFrustum - Function Definitions
+
+UU::CFrustum::CFrustum(const CMatrix<float, 4, 4> & view_projection, bool zero_to_one_depth)
+{
+	const CMatrix<float, 4, 4> & m = view_projection;
+
+	for (size_t j = 0; j < 4; ++j)
+	{
+		planes[0][j] = m[3][j] + m[0][j];
+		planes[1][j] = m[3][j] - m[0][j];
+		planes[2][j] = m[3][j] + m[1][j];
+		planes[3][j] = m[3][j] - m[1][j];
+		planes[4][j] = zero_to_one_depth ? m[2][j] : m[3][j] + m[2][j];
+		planes[5][j] = m[3][j] - m[2][j];
+	}
+
+	for (CVec4f & p : planes)
+	{
+		const float len = p.AsCVector<3>().Length();
+
+		if (len > 0.f)
+			p /= len;
+	}
+}
+
+UU::ECullResult UU::CFrustum::ClassifySphere(const CVec3f & center, float radius) const
+{
+	return ClassifyOne<false>(*this, center[0], center[1], center[2], radius, 0.f, 0.f);
+}
+
+UU::ECullResult UU::CFrustum::ClassifyAABox(const CAABox3f & box) const
+{
+	const CVec3f c = box.Center();
+	const CVec3f e = box.Extents() * 0.5f;
+
+	return ClassifyOne<true>(*this, c[0], c[1], c[2], e[0], e[1], e[2]);
+}
+
+void UU::CFrustum::ClassifySpheres(CVectorView<const float, 3> centers, CSpan<const float> radii, CSpan<ECullResult> out) const
+{
+	Classify<false>(*this, centers.Size(), LoadSpheres(centers, radii), out);
+}
+
+void UU::CFrustum::ClassifySpheres(CVectorView<const float, 4> spheres, CSpan<ECullResult> out) const
+{
+	Classify<false>(*this, spheres.Size(), LoadSpheres(spheres), out);
+}
+
+void UU::CFrustum::ClassifySpheres(const CSphereSoA & spheres, CSpan<ECullResult> out) const
+{
+	Classify<false>(*this, spheres.x.Size(), LoadSpheres(spheres), out);
+}
+
+void UU::CFrustum::ClassifyAABoxes(CSpan<const CAABox3f> boxes, CSpan<ECullResult> out) const
+{
+	Classify<true>(*this, boxes.Size(), LoadAABoxes(boxes), out);
+}
+
+void UU::CFrustum::ClassifyAABoxes(const CAABoxSoA & boxes, CSpan<ECullResult> out) const
+{
+	Classify<true>(*this, boxes.min_x.Size(), LoadAABoxes(boxes), out);
+}
+
+size_t UU::CFrustum::CullSpheres(CVectorView<const float, 3> centers, CSpan<const float> radii, std::vector<uint32_t> & indices,
+	ECullResult keep) const
+{
+	return Cull<false>(*this, centers.Size(), LoadSpheres(centers, radii), indices, keep);
+}
+
+size_t UU::CFrustum::CullSpheres(CVectorView<const float, 4> spheres, std::vector<uint32_t> & indices, ECullResult keep) const
+{
+	return Cull<false>(*this, spheres.Size(), LoadSpheres(spheres), indices, keep);
+}
+
+size_t UU::CFrustum::CullSpheres(const CSphereSoA & spheres, std::vector<uint32_t> & indices, ECullResult keep) const
+{
+	return Cull<false>(*this, spheres.x.Size(), LoadSpheres(spheres), indices, keep);
+}
+
+size_t UU::CFrustum::CullAABoxes(CSpan<const CAABox3f> boxes, std::vector<uint32_t> & indices, ECullResult keep) const
+{
+	return Cull<true>(*this, boxes.Size(), LoadAABoxes(boxes), indices, keep);
+}
+
+size_t UU::CFrustum::CullAABoxes(const CAABoxSoA & boxes, std::vector<uint32_t> & indices, ECullResult keep) const
+{
+	return Cull<true>(*this, boxes.min_x.Size(), LoadAABoxes(boxes), indices, keep);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "AABox.hpp"
+#include "Math.hpp"
+#include "Span.hpp"
+#include "VectorView.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace UU
+{
+	// Ordered so that "result >= threshold" selects everything at least as visible as the threshold.
+	enum class ECullResult : uint8_t
+	{
+		Outside = 0,
+		Intersecting = 1,
+		Inside = 2
+	};
+
+	// Structure-of-arrays inputs. All spans must have the same size.
+	class CSphereSoA final
+	{
+	public:
+
+		CSpan<const float>	x, y, z, radius;
+	};
+
+	class CAABoxSoA final
+	{
+	public:
+
+		CSpan<const float>	min_x, min_y, min_z;
+		CSpan<const float>	max_x, max_y, max_z;
+	};
+
+	class CFrustum final
+	{
+	public:
+
+		// Normalised planes (a, b, c, d), a point is on the inner side when a*x + b*y + c*z + d >= 0.
+		// Order: left, right, bottom, top, near, far.
+		CVec4f				planes[6];
+
+		CFrustum() = default;
+
+		// Extracts the planes from a view-projection matrix for column vectors (clip = m * p).
+		// zero_to_one_depth selects a D3D style [0, w] clip depth instead of GL's [-w, w].
+		explicit CFrustum(const CMatrix<float, 4, 4> & view_projection, bool zero_to_one_depth = false);
+
+		ECullResult			ClassifySphere(const CVec3f & center, float radius) const;
+		ECullResult			ClassifyAABox(const CAABox3f & box) const;
+
+		// Batch classification over CSimdNative<float> lanes, a block of objects at a time. Inputs above
+		// FRUSTUM_PARALLEL_GRAIN objects are split into chunks across hardware threads.
+		void				ClassifySpheres(CVectorView<const float, 3> centers, CSpan<const float> radii, CSpan<ECullResult> out) const;
+		void				ClassifySpheres(CVectorView<const float, 4> spheres, CSpan<ECullResult> out) const;
+		void				ClassifySpheres(const CSphereSoA & spheres, CSpan<ECullResult> out) const;
+		void				ClassifyAABoxes(CSpan<const CAABox3f> boxes, CSpan<ECullResult> out) const;
+		void				ClassifyAABoxes(const CAABoxSoA & boxes, CSpan<ECullResult> out) const;
+
+		// Appends, in input order, the index of every object classified at or above `keep`.
+		// Returns the number of indices appended.
+		size_t				CullSpheres(CVectorView<const float, 3> centers, CSpan<const float> radii, std::vector<uint32_t> & indices,
+								ECullResult keep = ECullResult::Intersecting) const;
+		size_t				CullSpheres(CVectorView<const float, 4> spheres, std::vector<uint32_t> & indices,
+								ECullResult keep = ECullResult::Intersecting) const;
+		size_t				CullSpheres(const CSphereSoA & spheres, std::vector<uint32_t> & indices,
+								ECullResult keep = ECullResult::Intersecting) const;
+		size_t				CullAABoxes(CSpan<const CAABox3f> boxes, std::vector<uint32_t> & indices,
+								ECullResult keep = ECullResult::Intersecting) const;
+		size_t				CullAABoxes(const CAABoxSoA & boxes, std::vector<uint32_t> & indices,
+								ECullResult keep = ECullResult::Intersecting) const;
+	};
+
+	constexpr size_t FRUSTUM_PARALLEL_GRAIN = 1 << 14;
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Colour.hpp"
+#include "Memory.hpp"
+#include "Parallel.hpp"
+#include "Span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace UU
+{
+	constexpr size_t IMAGE_TILE_SIZE = 64;
+	constexpr size_t IMAGE_PARALLEL_GRAIN = 1 << 14;
+
+	// Linear images store rows one after another. Tiled images store tile_size x tile_size blocks one after
+	// another, so a 2D neighbourhood touches a handful of cache lines and pages instead of one per row.
+	enum class EImageLayout : uint8_t
+	{
+		Linear,
+		Tiled
+	};
+
+	// A non-owning rectangle of pixels whose rows are stride bytes apart, e.g. a whole CImage, a sub-image or
+	// a foreign frame buffer. Views are cheap to copy and slice, and are what colour kernels take. The buffer
+	// must be aligned for T. Use a const T for read-only views.
+	template <typename T>
+	class CImageView
+	{
+	public:
+		using TPixel = std::remove_const_t<T>;
+		using TByte = std::conditional_t<std::is_const<T>::value, const uint8_t, uint8_t>;
+
+		static constexpr size_t TILE_SIZE = IMAGE_TILE_SIZE;
+
+	private:
+		TByte * data = nullptr;
+		size_t width = 0;
+		size_t height = 0;
+		size_t stride = 0;
+
+	public:
+		CImageView() = default;
+
+		CImageView(T * base, size_t w, size_t h, size_t stride_bytes)
+			: data(reinterpret_cast<TByte *>(base)), width(w), height(h), stride(stride_bytes) {}
+
+		CImageView(T * base, size_t w, size_t h)
+			: CImageView(base, w, h, w * sizeof(T)) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible<U *, T *>::value && !std::is_same<U, T>::value>>
+		CImageView(const CImageView<U> & v)
+			: data(v.Bytes()), width(v.Width()), height(v.Height()), stride(v.Stride()) {}
+
+		T &					operator()(size_t x, size_t y) const;
+
+		T *					Row(size_t y) const;
+		CSpan<T>			RowSpan(size_t y) const;
+		// Every pixel in row order, only for contiguous views.
+		CSpan<T>			Pixels() const;
+
+		TByte *				Bytes() const;
+		size_t				Width() const;
+		size_t				Height() const;
+		size_t				Stride() const;
+		bool				Empty() const;
+		bool				IsContiguous() const;
+
+		CImageView			SubView(size_t x, size_t y, size_t w, size_t h) const;
+
+		// TILE_SIZE square sub-views, clipped at the right and bottom edges.
+		size_t				TilesX() const;
+		size_t				TilesY() const;
+		CImageView			Tile(size_t tx, size_t ty) const;
+	};
+
+	// An owning image of trivially copyable pixels, CColour by default, with every row or tile starting on a
+	// cache line. Linear images default to a stride of the row rounded up to CACHE_LINE_SIZE and hand out views
+	// of any sub-rectangle. Tiled images pad the edges to whole tiles and are accessed through operator(), Tile,
+	// ParallelForTiles, or by copying from and to a linear view.
+	template <typename T = CColour, EImageLayout layout = EImageLayout::Linear, size_t tile_size = IMAGE_TILE_SIZE>
+	class CImage final
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "CImage pixels are copied as bytes");
+		static_assert(tile_size > 0);
+
+	public:
+		static constexpr EImageLayout LAYOUT = layout;
+		static constexpr size_t TILE_SIZE = tile_size;
+
+	private:
+		std::vector<uint8_t, CAlignedAllocator<uint8_t>> storage;
+		size_t width = 0;
+		size_t height = 0;
+		// Bytes between rows of the image when Linear, of a tile when Tiled.
+		size_t stride = 0;
+
+		size_t				TileBytes() const;
+		size_t				Offset(size_t x, size_t y) const;
+
+	public:
+		CImage() = default;
+
+		// A stride_bytes of 0 picks the aligned default, otherwise it must be at least w * sizeof(T) and a
+		// multiple of alignof(T). Tiled images ignore it.
+		CImage(size_t w, size_t h, const T & fill = T(), size_t stride_bytes = 0);
+
+		T &					operator()(size_t x, size_t y);
+		const T &			operator()(size_t x, size_t y) const;
+
+		template <EImageLayout l = layout, typename = std::enable_if_t<l == EImageLayout::Linear>>
+		T *					Row(size_t y);
+		template <EImageLayout l = layout, typename = std::enable_if_t<l == EImageLayout::Linear>>
+		const T *			Row(size_t y) const;
+
+		template <EImageLayout l = layout, typename = std::enable_if_t<l == EImageLayout::Linear>>
+		CImageView<T>		View();
+		template <EImageLayout l = layout, typename = std::enable_if_t<l == EImageLayout::Linear>>
+		CImageView<const T>	View() const;
+
+		size_t				Width() const;
+		size_t				Height() const;
+		size_t				Stride() const;
+		bool				Empty() const;
+
+		size_t				TilesX() const;
+		size_t				TilesY() const;
+		CImageView<T>		Tile(size_t tx, size_t ty);
+		CImageView<const T>	Tile(size_t tx, size_t ty) const;
+
+		void				Fill(const T & value);
+
+		// src and dst have the size of the image.
+		void				CopyFrom(CImageView<const T> src);
+		void				CopyTo(CImageView<T> dst) const;
+	};
+
+	// Calls fn(y, row) for every row of a view, in bands of at least IMAGE_PARALLEL_GRAIN pixels per thread.
+	template <typename T, typename Fn>
+	void ParallelForRows(CImageView<T> view, Fn && fn);
+
+	// Calls fn(tile, x, y) for every tile of a CImage or CImageView, where x and y are the pixel coordinates of
+	// the tile's top left corner. Tiles are split across threads.
+	template <typename TImage, typename Fn>
+	void ParallelForTiles(TImage && image, Fn && fn);
+}
+
+// CImageView - Function Definitions
+
+template <typename T>
+T & UU::CImageView<T>::operator()(size_t x, size_t y) const
+{
+	return Row(y)[x];
+}
+
+template <typename T>
+T * UU::CImageView<T>::Row(size_t y) const
+{
+	return reinterpret_cast<T *>(data + y * stride);
+}
+
+template <typename T>
+UU::CSpan<T> UU::CImageView<T>::RowSpan(size_t y) const
+{
+	return CSpan<T>(Row(y), width);
+}
+
+template <typename T>
+UU::CSpan<T> UU::CImageView<T>::Pixels() const
+{
+	return CSpan<T>(reinterpret_cast<T *>(data), width * height);
+}
+
+template <typename T>
+typename UU::CImageView<T>::TByte * UU::CImageView<T>::Bytes() const
+{
+	return data;
+}
+
+template <typename T>
+size_t UU::CImageView<T>::Width() const
+{
+	return width;
+}
+
+template <typename T>
+size_t UU::CImageView<T>::Height() const
+{
+	return height;
+}
+
+template <typename T>
+size_t UU::CImageView<T>::Stride() const
+{
+	return stride;
+}
+
+template <typename T>
+bool UU::CImageView<T>::Empty() const
+{
+	return width == 0 || height == 0;
+}
+
+template <typename T>
+bool UU::CImageView<T>::IsContiguous() const
+{
+	return height <= 1 || stride == width * sizeof(T);
+}
+
+template <typename T>
+UU::CImageView<T> UU::CImageView<T>::SubView(size_t x, size_t y, size_t w, size_t h) const
+{
+	return CImageView(reinterpret_cast<T *>(data + y * stride + x * sizeof(T)), w, h, stride);
+}
+
+template <typename T>
+size_t UU::CImageView<T>::TilesX() const
+{
+	return (width + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+template <typename T>
+size_t UU::CImageView<T>::TilesY() const
+{
+	return (height + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+template <typename T>
+UU::CImageView<T> UU::CImageView<T>::Tile(size_t tx, size_t ty) const
+{
+	const size_t x = tx * TILE_SIZE;
+	const size_t y = ty * TILE_SIZE;
+
+	return SubView(x, y, width - x < TILE_SIZE ? width - x : TILE_SIZE, height - y < TILE_SIZE ? height - y : TILE_SIZE);
+}
+
+// CImage - Function Definitions
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+UU::CImage<T, layout, tile_size>::CImage(size_t w, size_t h, const T & fill, size_t stride_bytes)
+	: width(w), height(h)
+{
+	if constexpr (layout == EImageLayout::Linear)
+	{
+		stride = stride_bytes != 0 ? stride_bytes : (w * sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+		storage.resize(stride * h);
+	}
+	else
+	{
+		stride = (tile_size * sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+		storage.resize(TilesX() * TilesY() * TileBytes());
+	}
+
+	Fill(fill);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+size_t UU::CImage<T, layout, tile_size>::TileBytes() const
+{
+	return stride * tile_size;
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+size_t UU::CImage<T, layout, tile_size>::Offset(size_t x, size_t y) const
+{
+	if constexpr (layout == EImageLayout::Linear)
+		return y * stride + x * sizeof(T);
+	else
+		return ((y / tile_size) * TilesX() + x / tile_size) * TileBytes() + (y % tile_size) * stride + (x % tile_size) * sizeof(T);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+T & UU::CImage<T, layout, tile_size>::operator()(size_t x, size_t y)
+{
+	return *reinterpret_cast<T *>(storage.data() + Offset(x, y));
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+const T & UU::CImage<T, layout, tile_size>::operator()(size_t x, size_t y) const
+{
+	return *reinterpret_cast<const T *>(storage.data() + Offset(x, y));
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+template <UU::EImageLayout l, typename>
+T * UU::CImage<T, layout, tile_size>::Row(size_t y)
+{
+	return reinterpret_cast<T *>(storage.data() + y * stride);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+template <UU::EImageLayout l, typename>
+const T * UU::CImage<T, layout, tile_size>::Row(size_t y) const
+{
+	return reinterpret_cast<const T *>(storage.data() + y * stride);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+template <UU::EImageLayout l, typename>
+UU::CImageView<T> UU::CImage<T, layout, tile_size>::View()
+{
+	return CImageView<T>(reinterpret_cast<T *>(storage.data()), width, height, stride);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+template <UU::EImageLayout l, typename>
+UU::CImageView<const T> UU::CImage<T, layout, tile_size>::View() const
+{
+	return CImageView<const T>(reinterpret_cast<const T *>(storage.data()), width, height, stride);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+size_t UU::CImage<T, layout, tile_size>::Width() const
+{
+	return width;
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+size_t UU::CImage<T, layout, tile_size>::Height() const
+{
+	return height;
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+size_t UU::CImage<T, layout, tile_size>::Stride() const
+{
+	return stride;
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+bool UU::CImage<T, layout, tile_size>::Empty() const
+{
+	return width == 0 || height == 0;
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+size_t UU::CImage<T, layout, tile_size>::TilesX() const
+{
+	return (width + tile_size - 1) / tile_size;
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+size_t UU::CImage<T, layout, tile_size>::TilesY() const
+{
+	return (height + tile_size - 1) / tile_size;
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+UU::CImageView<T> UU::CImage<T, layout, tile_size>::Tile(size_t tx, size_t ty)
+{
+	const size_t x = tx * tile_size;
+	const size_t y = ty * tile_size;
+	const size_t w = width - x < tile_size ? width - x : tile_size;
+	const size_t h = height - y < tile_size ? height - y : tile_size;
+
+	return CImageView<T>(&(*this)(x, y), w, h, stride);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+UU::CImageView<const T> UU::CImage<T, layout, tile_size>::Tile(size_t tx, size_t ty) const
+{
+	const size_t x = tx * tile_size;
+	const size_t y = ty * tile_size;
+	const size_t w = width - x < tile_size ? width - x : tile_size;
+	const size_t h = height - y < tile_size ? height - y : tile_size;
+
+	return CImageView<const T>(&(*this)(x, y), w, h, stride);
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+void UU::CImage<T, layout, tile_size>::Fill(const T & value)
+{
+	ParallelForTiles(*this, [&value](CImageView<T> tile, size_t, size_t)
+	{
+		for (size_t y = 0; y < tile.Height(); ++y)
+		{
+			T * row = tile.Row(y);
+
+			for (size_t x = 0; x < tile.Width(); ++x)
+				row[x] = value;
+		}
+	});
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+void UU::CImage<T, layout, tile_size>::CopyFrom(CImageView<const T> src)
+{
+	ParallelForTiles(*this, [&src](CImageView<T> tile, size_t x, size_t y)
+	{
+		for (size_t row = 0; row < tile.Height(); ++row)
+			std::memcpy(tile.Row(row), src.Row(y + row) + x, tile.Width() * sizeof(T));
+	});
+}
+
+template <typename T, UU::EImageLayout layout, size_t tile_size>
+void UU::CImage<T, layout, tile_size>::CopyTo(CImageView<T> dst) const
+{
+	ParallelForTiles(*this, [&dst](CImageView<const T> tile, size_t x, size_t y)
+	{
+		for (size_t row = 0; row < tile.Height(); ++row)
+			std::memcpy(dst.Row(y + row) + x, tile.Row(row), tile.Width() * sizeof(T));
+	});
+}
+
+// Iteration
+
+template <typename T, typename Fn>
+void UU::ParallelForRows(CImageView<T> view, Fn && fn)
+{
+	const size_t grain = view.Width() > 0 ? (IMAGE_PARALLEL_GRAIN + view.Width() - 1) / view.Width() : 1;
+
+	ParallelFor(view.Height(), grain, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t y = begin; y < end; ++y)
+			fn(y, view.RowSpan(y));
+	});
+}
+
+template <typename TImage, typename Fn>
+void UU::ParallelForTiles(TImage && image, Fn && fn)
+{
+	constexpr size_t tile_size = std::decay_t<TImage>::TILE_SIZE;
+	const size_t tiles_x = image.TilesX();
+
+	ParallelFor(tiles_x * image.TilesY(), (IMAGE_PARALLEL_GRAIN + tile_size * tile_size - 1) / (tile_size * tile_size), [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const size_t tx = i % tiles_x;
+			const size_t ty = i / tiles_x;
+
+			fn(image.Tile(tx, ty), tx * tile_size, ty * tile_size);
+		}
+	});
+}
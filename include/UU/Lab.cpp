@@ -0,0 +1,556 @@
+#include "../UU.hpp"
+#include "Lab.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	using UU::CColour;
+	using UU::CLab;
+	using UU::CLinearColour;
+	using UU::CSpan;
+	using UU::EColourDifference;
+
+	// Scalar forms run the lane kernels on a full register and keep its first lane, so they give exactly what
+	// the whole buffer forms do.
+	using V = UU::CSimdNative<float>;
+
+	constexpr size_t CELL_SHIFT = 8 - UU::LAB_LOOKUP_BITS;
+	constexpr size_t CELL_LEVELS = size_t(1) << UU::LAB_LOOKUP_BITS;
+	constexpr size_t CELL_COUNT = CELL_LEVELS * CELL_LEVELS * CELL_LEVELS;
+
+	size_t Cell(CColour col)
+	{
+		return (size_t(col.r >> CELL_SHIFT) << (2 * UU::LAB_LOOKUP_BITS)) | (size_t(col.g >> CELL_SHIFT) << UU::LAB_LOOKUP_BITS) | size_t(col.b >> CELL_SHIFT);
+	}
+
+	// Linear sRGB to XYZ with each row divided by the D65 white, so that white comes out as 1, 1, 1, and
+	// back again.
+	constexpr float TO_XYZ[3][3] =
+	{
+		{ 0.4124564f / 0.95047f, 0.3575761f / 0.95047f, 0.1804375f / 0.95047f },
+		{ 0.2126729f, 0.7151522f, 0.0721750f },
+		{ 0.0193339f / 1.08883f, 0.1191920f / 1.08883f, 0.9503041f / 1.08883f }
+	};
+
+	constexpr float FROM_XYZ[3][3] =
+	{
+		{ 3.2404542f * 0.95047f, -1.5371385f, -0.4985314f * 1.08883f },
+		{ -0.9692660f * 0.95047f, 1.8760108f, 0.0415560f * 1.08883f },
+		{ 0.0556434f * 0.95047f, -0.2040259f, 1.0572252f * 1.08883f }
+	};
+
+	// (6/29)^3, where the cube root of the Lab curve meets its straight segment, with that segment's slope.
+	constexpr float LAB_EPSILON = 216.0f / 24389.0f;
+	constexpr float LAB_SLOPE = 841.0f / 108.0f;
+
+	// 25^7, the chroma at which CIEDE2000's a axis stretch and rotation term are halfway.
+	constexpr float CHROMA_HALF_7 = 6103515625.0f;
+
+	constexpr float DEG_TO_RAD = UU::FLT_PI / 180.0f;
+
+	float FirstLane(const V & v)
+	{
+		alignas(64) float lanes[V::LANES];
+
+		v.Store(lanes);
+
+		return lanes[0];
+	}
+
+	template <typename T>
+	T LabCurve(const T & t)
+	{
+		const T root = UU::Exp(UU::Ln(UU::Max(t, T(LAB_EPSILON))) * T(1.0f / 3.0f));
+
+		return UU::Select(t > T(LAB_EPSILON), root, UU::MulAdd(t, T(LAB_SLOPE), T(4.0f / 29.0f)));
+	}
+
+	// Linear sRGB lanes to Lab.
+	template <typename T>
+	void ToLabLanes(const T & r, const T & g, const T & b, T & l_out, T & a_out, T & b_out)
+	{
+		const T x = LabCurve(T(TO_XYZ[0][0]) * r + T(TO_XYZ[0][1]) * g + T(TO_XYZ[0][2]) * b);
+		const T y = LabCurve(T(TO_XYZ[1][0]) * r + T(TO_XYZ[1][1]) * g + T(TO_XYZ[1][2]) * b);
+		const T z = LabCurve(T(TO_XYZ[2][0]) * r + T(TO_XYZ[2][1]) * g + T(TO_XYZ[2][2]) * b);
+
+		l_out = T(116.0f) * y - T(16.0f);
+		a_out = T(500.0f) * (x - y);
+		b_out = T(200.0f) * (y - z);
+	}
+
+	template <typename T>
+	T DeltaE76Squared(const T & l1, const T & a1, const T & b1, const T & l2, const T & a2, const T & b2)
+	{
+		const T dl = l2 - l1, da = a2 - a1, db = b2 - b1;
+
+		return dl * dl + da * da + db * db;
+	}
+
+	// CIEDE2000 squared, following Sharma, Wu and Dalal, "The CIEDE2000 Color-Difference Formula:
+	// Implementation Notes, Supplementary Test Data, and Mathematical Observations". Rather than taking both
+	// hue angles, the hue difference and mean hue come from the unit hue directions, which leaves a single
+	// ATan2 for the rotation term.
+	template <typename T>
+	T DeltaE2000Squared(const T & l1, const T & a1, const T & b1, const T & l2, const T & a2, const T & b2)
+	{
+		const T zero(0.0f), one(1.0f), half(0.5f);
+
+		const T c_mean = (UU::Sqrt(a1 * a1 + b1 * b1) + UU::Sqrt(a2 * a2 + b2 * b2)) * half;
+		const T c_mean_7 = c_mean * c_mean * c_mean * c_mean * c_mean * c_mean * c_mean;
+		const T stretch = one + half * (one - UU::Sqrt(c_mean_7 / (c_mean_7 + T(CHROMA_HALF_7))));
+
+		const T a1p = a1 * stretch, a2p = a2 * stretch;
+		const T c1p = UU::Sqrt(a1p * a1p + b1 * b1), c2p = UU::Sqrt(a2p * a2p + b2 * b2);
+
+		// Unit hue directions, 0 for achromatic colours.
+		const T inverse1 = UU::Select(c1p > zero, one / c1p, zero), inverse2 = UU::Select(c2p > zero, one / c2p, zero);
+		const T u1a = a1p * inverse1, u1b = b1 * inverse1;
+		const T u2a = a2p * inverse2, u2b = b2 * inverse2;
+
+		// The chord between the unit directions is 2 sin(dh / 2), its sign the way the hue turns from 1 to 2.
+		// Hues exactly opposite have a difference of pi that the angle form leaves unwrapped, so they turn
+		// up from the lower one. They are told apart by their directions summing to exactly 0, as a cross
+		// product contracted into a fused multiply-add leaves a residue of either sign.
+		const T chord_a = u2a - u1a, chord_b = u2b - u1b;
+		const T sum_a = u1a + u2a, sum_b = u1b + u2b;
+		const T cross = u1a * u2b - u1b * u2a;
+		const auto opposite = (sum_a == zero) & (sum_b == zero);
+		const auto first_lower = (u1b > zero) | ((u1b == zero) & (u1a > zero));
+		const auto turns_back = ((opposite | (cross == zero)) & !first_lower) | ((!opposite) & (cross < zero));
+		const T chord_2 = chord_a * chord_a + chord_b * chord_b;
+		const T dhue_size = UU::Sqrt(c1p * c2p * chord_2);
+		const T dhue = UU::Select(turns_back, -dhue_size, dhue_size);
+
+		// The mean hue lies along the sum of the directions, and at right angles to the chord. Whichever of the
+		// two is longer gives it without cancellation.
+		const auto from_sum = sum_a * sum_a + sum_b * sum_b >= chord_2;
+		const T mean_a = UU::Select(from_sum, sum_a, UU::Select(turns_back, -chord_b, chord_b));
+		const T mean_b = UU::Select(from_sum, sum_b, UU::Select(turns_back, chord_a, -chord_a));
+		const T mean_2 = mean_a * mean_a + mean_b * mean_b;
+		const auto has_hue = mean_2 > zero;
+		const T inverse_length = one / UU::Sqrt(mean_2);
+
+		const T c1 = UU::Select(has_hue, mean_a * inverse_length, one);
+		const T s1 = UU::Select(has_hue, mean_b * inverse_length, zero);
+
+		const T dl = l2 - l1;
+		const T dc = c2p - c1p;
+
+		const T c2 = T(2.0f) * c1 * c1 - one, s2 = T(2.0f) * s1 * c1;
+		const T c3 = c2 * c1 - s2 * s1, s3 = s2 * c1 + c2 * s1;
+		const T c4 = T(2.0f) * c2 * c2 - one, s4 = T(2.0f) * s2 * c2;
+
+		// 1 - 0.17 cos(h - 30) + 0.24 cos(2h) + 0.32 cos(3h + 6) - 0.2 cos(4h - 63), in degrees.
+		const T weighting = one
+			- T(0.17f) * (T(0.8660254f) * c1 + T(0.5f) * s1)
+			+ T(0.24f) * c2
+			+ T(0.32f) * (T(0.9945219f) * c3 - T(0.1045285f) * s3)
+			- T(0.20f) * (T(0.4539905f) * c4 + T(0.8910065f) * s4);
+
+		// The mean hue less 275 degrees, measured from the direction at 275.
+		const T cos_275(0.0871557f), sin_275(-0.9961947f);
+		const T hue_offset = UU::ATan2(cos_275 * s1 - sin_275 * c1, cos_275 * c1 + sin_275 * s1) * T(1.0f / (25.0f * DEG_TO_RAD));
+		const T rotation = T(30.0f * DEG_TO_RAD) * UU::Exp(-hue_offset * hue_offset);
+
+		const T l_mean = (l1 + l2) * half - T(50.0f);
+		const T l_mean_2 = l_mean * l_mean;
+		const T cp_mean = (c1p + c2p) * half;
+		const T cp_mean_7 = cp_mean * cp_mean * cp_mean * cp_mean * cp_mean * cp_mean * cp_mean;
+
+		// Far from 275 degrees the angle is tiny and Sin's polynomial would go subnormal, but below 1e-3 the
+		// sine is the angle itself to float precision.
+		const T angle = T(2.0f) * rotation;
+		const T sine = UU::Select(angle < T(1e-3f), angle, UU::Sin(UU::Max(angle, T(1e-3f))));
+		const T rotation_scale = T(-2.0f) * UU::Sqrt(cp_mean_7 / (cp_mean_7 + T(CHROMA_HALF_7))) * sine;
+
+		const T tl = dl / (one + T(0.015f) * l_mean_2 / UU::Sqrt(T(20.0f) + l_mean_2));
+		const T tc = dc / (one + T(0.045f) * cp_mean);
+		const T th = dhue / (one + T(0.015f) * cp_mean * weighting);
+
+		return UU::Max(tl * tl + tc * tc + th * th + rotation_scale * tc * th, zero);
+	}
+
+	template <typename T>
+	T DifferenceSquared(const T & l1, const T & a1, const T & b1, const T & l2, const T & a2, const T & b2, EColourDifference difference)
+	{
+		return difference == EColourDifference::DeltaE76 ? DeltaE76Squared(l1, a1, b1, l2, a2, b2) : DeltaE2000Squared(l1, a1, b1, l2, a2, b2);
+	}
+
+	float DifferenceSquared(const CLab & x, const CLab & y, EColourDifference difference)
+	{
+		return FirstLane(DifferenceSquared(V(x.l), V(x.a), V(x.b), V(y.l), V(y.a), V(y.b), difference));
+	}
+
+	// The first entry at the smallest difference from lab, the same choice as a scalar scan. Entries are
+	// taken a register at a time, lanes past the end never chosen.
+	size_t NearestEntry(const std::vector<CLab> & entries, const CLab & lab, EColourDifference difference)
+	{
+		alignas(64) float l[V::LANES], a[V::LANES], b[V::LANES];
+		alignas(64) float lane_index[V::LANES], best_distance[V::LANES], best_index[V::LANES];
+
+		for (size_t j = 0; j < V::LANES; ++j)
+			lane_index[j] = static_cast<float>(j);
+
+		const V vl(lab.l), va(lab.a), vb(lab.b), step(static_cast<float>(V::LANES)), count(static_cast<float>(entries.size()));
+		V best(FLT_MAX), best_i(0.f), index = V::Load(lane_index);
+
+		for (size_t i = 0; i < entries.size(); i += V::LANES)
+		{
+			for (size_t j = 0; j < V::LANES; ++j)
+			{
+				const CLab entry = i + j < entries.size() ? entries[i + j] : CLab();
+
+				l[j] = entry.l;
+				a[j] = entry.a;
+				b[j] = entry.b;
+			}
+
+			const V d = DifferenceSquared(vl, va, vb, V::Load(l), V::Load(a), V::Load(b), difference);
+			const auto closer = (d < best) & (index < count);
+
+			best = UU::Select(closer, d, best);
+			best_i = UU::Select(closer, index, best_i);
+			index = index + step;
+		}
+
+		best.Store(best_distance);
+		best_i.Store(best_index);
+
+		size_t nearest = static_cast<size_t>(best_index[0]);
+		float distance = best_distance[0];
+
+		for (size_t j = 1; j < V::LANES; ++j)
+		{
+			const auto i = static_cast<size_t>(best_index[j]);
+
+			if (best_distance[j] < distance || (best_distance[j] == distance && i < nearest))
+			{
+				nearest = i;
+				distance = best_distance[j];
+			}
+		}
+
+		return nearest;
+	}
+
+	// out[i] = sqrt(fn(x[i], y[i])) a register at a time, the last one padded.
+	template <typename Fn>
+	void DifferenceSpan(CSpan<const CLab> x, CSpan<const CLab> y, CSpan<float> out, Fn && fn)
+	{
+		UU::ParallelFor(x.Size(), UU::LAB_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+		{
+			alignas(64) float l1[V::LANES], a1[V::LANES], b1[V::LANES];
+			alignas(64) float l2[V::LANES], a2[V::LANES], b2[V::LANES];
+			alignas(64) float d[V::LANES];
+
+			for (size_t i = begin; i < end; i += V::LANES)
+			{
+				const size_t n = std::min(V::LANES, end - i);
+
+				for (size_t j = 0; j < V::LANES; ++j)
+				{
+					const CLab p = j < n ? x[i + j] : CLab(), q = j < n ? y[i + j] : CLab();
+
+					l1[j] = p.l;
+					a1[j] = p.a;
+					b1[j] = p.b;
+					l2[j] = q.l;
+					a2[j] = q.a;
+					b2[j] = q.b;
+				}
+
+				UU::Sqrt(fn(V::Load(l1), V::Load(a1), V::Load(b1), V::Load(l2), V::Load(a2), V::Load(b2))).Store(d);
+
+				std::copy(d, d + n, &out[i]);
+			}
+		});
+	}
+}
+
+// CLab - Function Definitions
+
+float & UU::CLab::operator[](const int i)
+{
+	return reinterpret_cast<float *>(this)[i];
+}
+
+float UU::CLab::operator[](const int i) const
+{
+	return reinterpret_cast<const float *>(this)[i];
+}
+
+float * UU::CLab::Base()
+{
+	return reinterpret_cast<float *>(this);
+}
+
+float const * UU::CLab::Base() const
+{
+	return reinterpret_cast<float const *>(this);
+}
+
+void UU::CLab::CopyToArray(float * f) const
+{
+	f[0] = l;
+	f[1] = a;
+	f[2] = b;
+}
+
+bool UU::CLab::operator==(const CLab & lab) const
+{
+	return l == lab.l
+		&& a == lab.a
+		&& b == lab.b;
+}
+
+bool UU::CLab::operator!=(const CLab & lab) const
+{
+	return l != lab.l
+		|| a != lab.a
+		|| b != lab.b;
+}
+
+UU::CLab UU::CLab::FromColour(const CColour col)
+{
+	return FromLinear(CLinearColour(SrgbToLinear8(col.r), SrgbToLinear8(col.g), SrgbToLinear8(col.b)));
+}
+
+UU::CLab UU::CLab::FromLinear(const CLinearColour & col)
+{
+	V l_out, a_out, b_out;
+
+	ToLabLanes(V(col.r), V(col.g), V(col.b), l_out, a_out, b_out);
+
+	return CLab(FirstLane(l_out), FirstLane(a_out), FirstLane(b_out));
+}
+
+UU::CLinearColour UU::CLab::ToLinear() const
+{
+	constexpr float edge = 6.0f / 29.0f;
+
+	const auto inverse = [](const float f) { return f > edge ? f * f * f : (f - 4.0f / 29.0f) / LAB_SLOPE; };
+
+	const float fy = (l + 16.0f) / 116.0f;
+	const float x = inverse(fy + a / 500.0f);
+	const float y = inverse(fy);
+	const float z = inverse(fy - b / 200.0f);
+
+	return CLinearColour(
+		FROM_XYZ[0][0] * x + FROM_XYZ[0][1] * y + FROM_XYZ[0][2] * z,
+		FROM_XYZ[1][0] * x + FROM_XYZ[1][1] * y + FROM_XYZ[1][2] * z,
+		FROM_XYZ[2][0] * x + FROM_XYZ[2][1] * y + FROM_XYZ[2][2] * z);
+}
+
+UU::CColour UU::CLab::ToColour() const
+{
+	return ToLinear().ToColour();
+}
+
+float UU::CLab::Chroma() const
+{
+	return std::sqrt(a * a + b * b);
+}
+
+// Differences
+
+float UU::DeltaE76(const CLab & x, const CLab & y)
+{
+	return std::sqrt(DifferenceSquared(x, y, EColourDifference::DeltaE76));
+}
+
+float UU::DeltaE2000(const CLab & x, const CLab & y)
+{
+	return std::sqrt(DifferenceSquared(x, y, EColourDifference::DeltaE2000));
+}
+
+float UU::ColourDifference(const CLab & x, const CLab & y, const EColourDifference difference)
+{
+	return std::sqrt(DifferenceSquared(x, y, difference));
+}
+
+// Span Conversions
+
+void UU::ToLab(CSpan<const CColour> in, CSpan<CLab> out)
+{
+	ParallelFor(in.Size(), LAB_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		alignas(64) float r[V::LANES], g[V::LANES], b[V::LANES];
+		alignas(64) float l_out[V::LANES], a_out[V::LANES], b_out[V::LANES];
+
+		size_t i = begin;
+
+		for (; i + V::LANES <= end; i += V::LANES)
+		{
+			for (size_t j = 0; j < V::LANES; ++j)
+			{
+				r[j] = SrgbToLinear8(in[i + j].r);
+				g[j] = SrgbToLinear8(in[i + j].g);
+				b[j] = SrgbToLinear8(in[i + j].b);
+			}
+
+			V vl, va, vb;
+
+			ToLabLanes(V::Load(r), V::Load(g), V::Load(b), vl, va, vb);
+
+			vl.Store(l_out);
+			va.Store(a_out);
+			vb.Store(b_out);
+
+			for (size_t j = 0; j < V::LANES; ++j)
+				out[i + j] = CLab(l_out[j], a_out[j], b_out[j]);
+		}
+
+		for (; i < end; ++i)
+			out[i] = CLab::FromColour(in[i]);
+	});
+}
+
+void UU::DeltaE76(CSpan<const CLab> x, CSpan<const CLab> y, CSpan<float> out)
+{
+	DifferenceSpan(x, y, out, [](const auto & l1, const auto & a1, const auto & b1, const auto & l2, const auto & a2, const auto & b2)
+	{
+		return DeltaE76Squared(l1, a1, b1, l2, a2, b2);
+	});
+}
+
+void UU::DeltaE2000(CSpan<const CLab> x, CSpan<const CLab> y, CSpan<float> out)
+{
+	DifferenceSpan(x, y, out, [](const auto & l1, const auto & a1, const auto & b1, const auto & l2, const auto & a2, const auto & b2)
+	{
+		return DeltaE2000Squared(l1, a1, b1, l2, a2, b2);
+	});
+}
+
+// CLabPalette - Function Definitions
+
+UU::CLabPalette::CLabPalette(CSpan<const CColour> palette, const EColourDifference difference)
+{
+	Build(palette, difference);
+}
+
+void UU::CLabPalette::Build(CSpan<const CColour> palette, const EColourDifference difference)
+{
+	this->difference = difference;
+
+	colours.assign(palette.begin(), palette.begin() + std::min(palette.Size(), PALETTE_MAX_SIZE));
+	labs.resize(colours.size());
+	lookup.clear();
+
+	if (colours.empty())
+		return;
+
+	ToLab(Colours(), CSpan<CLab>(labs.data(), labs.size()));
+
+	lookup.resize(CELL_COUNT);
+
+	ParallelFor(CELL_COUNT, LAB_PARALLEL_GRAIN / 64, [&](size_t, size_t begin, size_t end)
+	{
+		// Cell levels 4k to 4k + 3 centre on 4k + 1.5.
+		constexpr float half = float(size_t(1) << CELL_SHIFT) / 2 - 0.5f;
+
+		// Cell centres fall between 8 bit levels, so they take the exact sRGB curve rather than the table.
+		const auto decode = [](size_t level) { return SrgbToLinear((float(level << CELL_SHIFT) + half) / 255.0f); };
+
+		for (size_t cell = begin; cell < end; ++cell)
+		{
+			const CLinearColour centre(
+				decode(cell >> (2 * LAB_LOOKUP_BITS)),
+				decode((cell >> LAB_LOOKUP_BITS) & (CELL_LEVELS - 1)),
+				decode(cell & (CELL_LEVELS - 1)));
+
+			lookup[cell] = static_cast<uint8_t>(NearestEntry(labs, CLab::FromLinear(centre), difference));
+		}
+	});
+}
+
+void UU::CLabPalette::Clear()
+{
+	colours.clear();
+	labs.clear();
+	lookup.clear();
+}
+
+uint8_t UU::CLabPalette::Nearest(const CColour col) const
+{
+	if (lookup.empty())
+		return 0;
+
+	return lookup[Cell(col)];
+}
+
+uint8_t UU::CLabPalette::NearestExact(const CColour col) const
+{
+	return static_cast<uint8_t>(NearestEntry(labs, CLab::FromColour(col), difference));
+}
+
+void UU::CLabPalette::Nearest(CSpan<const CColour> in, CSpan<uint8_t> out) const
+{
+	if (Empty())
+	{
+		std::fill(out.begin(), out.end(), uint8_t(0));
+		return;
+	}
+
+	ParallelFor(in.Size(), LAB_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			out[i] = lookup[Cell(in[i])];
+	});
+}
+
+const UU::CColour & UU::CLabPalette::operator[](size_t i) const
+{
+	return colours[i];
+}
+
+const UU::CLab & UU::CLabPalette::Lab(size_t i) const
+{
+	return labs[i];
+}
+
+UU::CSpan<const UU::CColour> UU::CLabPalette::Colours() const
+{
+	return CSpan<const CColour>(colours.data(), colours.size());
+}
+
+UU::EColourDifference UU::CLabPalette::Difference() const
+{
+	return difference;
+}
+
+size_t UU::CLabPalette::Size() const
+{
+	return colours.size();
+}
+
+bool UU::CLabPalette::Empty() const
+{
+	return colours.empty();
+}
+
+// Quantisation
+
+void UU::Quantise(CImageView<const CColour> in, const CLabPalette & palette, CImageView<uint8_t> out)
+{
+	if (palette.Empty())
+	{
+		ParallelForRows(out, [&](size_t, CSpan<uint8_t> row) { std::fill(row.begin(), row.end(), uint8_t(0)); });
+		return;
+	}
+
+	ParallelForRows(out, [&](size_t y, CSpan<uint8_t> row)
+	{
+		const CColour * src = in.Row(y);
+
+		for (size_t x = 0; x < row.Size(); ++x)
+			row[x] = palette.Nearest(src[x]);
+	});
+}
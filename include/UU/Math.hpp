@@ -4,10 +4,15 @@
 	#error "Please only include UU.hpp for now"
 #endif
 
-#include <vector>
 #include <corecrt_math.h>
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
 namespace UU
 {
 	constexpr float		FLT_PI = 3.141592653f;
@@ -33,16 +38,16 @@ namespace UU
 	template <typename T>
 	T Abs(T val);
 
-	template <typename T>
+	template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
 	T Min(T val);
 
 	template <typename T, typename U>
 	auto Min(T a, U b) -> std::common_type_t<T, U>;
 	
 	template <typename T, typename U, typename... Ts>
-	auto Min(T val1, T val2, Ts... vals) -> std::common_type_t<T, U, Ts...>;
+	auto Min(T val1, U val2, Ts... vals) -> std::common_type_t<T, U, Ts...>;
 
-	template <typename T>
+	template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
 	T Max(T val);
 
 	template <typename T, typename U>
@@ -69,7 +74,7 @@ namespace UU
 	template <typename T>
 	T Tan(T val);
 	
-	template <typename T>
+	template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
 	void SinCos(T val, T& sin_val, T& cos_val);
 
 	template <typename T>
@@ -111,6 +116,20 @@ namespace UU
 	template <typename T>
 	T Round(T val);
 
+	enum class ERounding : uint8_t
+	{
+		// To nearest, ties to even.
+		Nearest,
+		Floor,
+		Ceil,
+		Trunc
+	};
+
+	// val rounded as requested and converted to TInt, saturating at the range of TInt with NaN converting to 0.
+	// Rounds with comparisons, neither libm nor the rounding mode of the FP environment is involved.
+	template <typename TInt = int32_t, ERounding rounding = ERounding::Nearest, typename T>
+	TInt RoundToInt(T val);
+
 	template <typename T>
 	bool IsNormal(T val);
 
@@ -123,7 +142,8 @@ namespace UU
 	template <typename T>
 	bool IsInf(T val);
 
-	template<typename T, typename... Ts>
+	// sqrt(val1^2 + vals^2...) without overflow or underflow in the squares. Integral arguments are evaluated in double.
+	template<typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>, typename... Ts>
 	T Hypot(T val1, Ts... vals);
 
 	template<typename T>
@@ -131,6 +151,12 @@ namespace UU
 
 	template<typename T>
 	T DegToRad(T angle);
+
+	template <typename T>
+	size_t CountTrailingZeros(T val);
+
+	template <typename T>
+	size_t CountLeadingZeros(T val);
 }
 
 template <typename T>
@@ -148,7 +174,7 @@ T UU::Abs(const T val)
 	return val < T(0) ? -val : val;
 }
 
-template<typename T>
+template<typename T, typename>
 T UU::Min(T val)
 {
 	return val;
@@ -161,15 +187,18 @@ auto UU::Min(T a, U b) -> std::common_type_t<T, U>
 }
 
 template<typename T, typename U, typename ... Ts>
-auto UU::Min(T val1, T val2, Ts... vals) -> std::common_type_t<T, U, Ts...>
+auto UU::Min(T val1, U val2, Ts... vals) -> std::common_type_t<T, U, Ts...>
 {
-	if (val1 < val2)
-		return Min(static_cast<std::common_type_t<T, U>>(val1), vals...);
+	using TResult = std::common_type_t<T, U, Ts...>;
+
+	TResult result = Min(static_cast<TResult>(val1), static_cast<TResult>(val2));
+
+	((result = Min(result, static_cast<TResult>(vals))), ...);
 
-	return Min(static_cast<std::common_type_t<T, U>>(val1) >(val2), vals...);
+	return result;
 }
 
-template<typename T>
+template<typename T, typename>
 T UU::Max(const T val)
 {
 	return val;
@@ -184,10 +213,13 @@ auto UU::Max(T a, U b) -> std::common_type_t<T, U>
 template<typename T, typename U, typename ... Ts>
 auto UU::Max(T val1, U val2, Ts... vals) -> std::common_type_t<T, U, Ts...>
 {
-	if (val1 > val2)
-		return Max(static_cast<std::common_type_t<T, U>>(val1), vals...);
+	using TResult = std::common_type_t<T, U, Ts...>;
+
+	TResult result = Max(static_cast<TResult>(val1), static_cast<TResult>(val2));
 
-	return Max(static_cast<std::common_type_t<T, U>>(val2), vals...);
+	((result = Max(result, static_cast<TResult>(vals))), ...);
+
+	return result;
 }
 
 template <typename T>
@@ -229,13 +261,6 @@ T UU::Tan(T val)
 	return static_cast<T>(tan(val));
 }
 
-template<typename T>
-void UU::SinCos(T val, T& sin_val, T& cos_val)
-{
-	sin_val = Sin(val);
-	cos_val = Cos(val);
-}
-
 template<typename T>
 T UU::ASin(T val)
 {
@@ -326,6 +351,56 @@ T UU::Round(T val)
 	return static_cast<T>(round(val));
 }
 
+template <typename TInt, UU::ERounding rounding, typename T>
+TInt UU::RoundToInt(T val)
+{
+	static_assert(std::is_integral<TInt>::value && std::is_floating_point<T>::value);
+
+	using L = std::numeric_limits<TInt>;
+
+	// From 2^(digits - 1) on every value is integral, which also passes infinities and NaN through.
+	constexpr T integral = T(uint64_t(1) << (std::numeric_limits<T>::digits - 1));
+
+	T r = val;
+
+	if (Abs(val) < integral)
+	{
+		const T t = static_cast<T>(static_cast<int64_t>(val));
+		const T floor = t > val ? t - T(1) : t;
+
+		if constexpr (rounding == ERounding::Nearest)
+		{
+			const T diff = val - floor;
+
+			r = diff > T(0.5) || (diff == T(0.5) && (static_cast<int64_t>(floor) & 1)) ? floor + T(1) : floor;
+		}
+		else if constexpr (rounding == ERounding::Floor)
+		{
+			r = floor;
+		}
+		else if constexpr (rounding == ERounding::Ceil)
+		{
+			r = t < val ? t + T(1) : t;
+		}
+		else
+		{
+			r = t;
+		}
+	}
+
+	if (r != r)
+		return TInt(0);
+
+	// Both limits are powers of two and exact in T.
+	if (r >= T(2) * T(uint64_t(1) << (L::digits - 1)))
+		return L::max();
+
+	if (r < static_cast<T>(L::min()))
+		return L::min();
+
+	return static_cast<TInt>(r);
+}
+
 template <typename T>
 bool UU::IsNormal(const T val)
 {
@@ -362,40 +437,34 @@ bool UU::IsInf(T val)
 	return isinf(val);
 }
 
-template<typename T, typename ... Ts>
+template<typename T, typename, typename ... Ts>
 T UU::Hypot(T val1, Ts... vals)
 {
-	val1 = Abs(val1);
-	T max_value = Max(Abs(val1), Abs(std::forward<Ts>(vals))...);
+	using TCalc = std::conditional_t<std::is_floating_point<T>::value, T, double>;
 
-	if (max_value == T(0))
+	// An infinite argument wins over NaN, as in std::hypot.
+	if (IsInf(val1) || (IsInf(vals) || ...))
+		return static_cast<T>(std::numeric_limits<TCalc>::infinity());
+
+	if (IsNan(val1) || (IsNan(vals) || ...))
+		return static_cast<T>(std::numeric_limits<TCalc>::quiet_NaN());
+
+	TCalc max_value = static_cast<TCalc>(Abs(val1));
+
+	((max_value = Max(max_value, static_cast<TCalc>(Abs(vals)))), ...);
+
+	if (max_value == TCalc(0))
 		return T(0);
 
-	if constexpr (std::is_integral<T>::value)
+	// Dividing by the largest magnitude keeps every square in [0, 1].
+	const auto scaled_sqr = [max_value](auto val)
 	{
-		double val = 0.0;
-		std::vector<double> vec = {static_cast<double>(val1), static_cast<double>(vals)...};
-		for(double & i : vec)
-		{
-			i /= max_value;
-			i *= i;
-			val += i;
-		}
-		val = Sqrt(val);
+		const TCalc s = static_cast<TCalc>(Abs(val)) / max_value;
 
-		return static_cast<T>(max_value * val);
-	} else {
-		T val = T(0);
-		std::vector<T> vec = {val1, vals...};
-		for (size_t i = 0; i < vec.size(); ++i)
-		{
-			vec[i] /= max_value;
-			vec[i] *= vec[i];
-			val += vec[i];
-		}
-		val = Sqrt(val);
-		return static_cast<T>(max_value * val);
-	}
+		return s * s;
+	};
+
+	return static_cast<T>(max_value * Sqrt((scaled_sqr(val1) + ... + scaled_sqr(vals))));
 }
 
 template<typename T>
@@ -410,5 +479,58 @@ T UU::RadToDeg(T angle)
 	return angle * T(180.f / FLT_PI);
 }
 
+template <typename T>
+size_t UU::CountTrailingZeros(T val)
+{
+	static_assert(std::is_integral<T>::value && sizeof(T) <= 8);
+
+	if (val == T(0))
+		return sizeof(T) * 8;
+
+#if defined(_MSC_VER)
+	unsigned long index;
+
+	if constexpr (sizeof(T) <= 4)
+		_BitScanForward(&index, static_cast<unsigned long>(val));
+	else
+		_BitScanForward64(&index, static_cast<unsigned __int64>(val));
+
+	return index;
+#else
+	if constexpr (sizeof(T) <= 4)
+		return __builtin_ctz(static_cast<unsigned int>(val));
+	else
+		return __builtin_ctzll(static_cast<unsigned long long>(val));
+#endif
+}
+
+template <typename T>
+size_t UU::CountLeadingZeros(T val)
+{
+	static_assert(std::is_integral<T>::value && sizeof(T) <= 8);
+
+	constexpr size_t bits = sizeof(T) * 8;
+
+	if (val == T(0))
+		return bits;
+
+#if defined(_MSC_VER)
+	unsigned long index;
+
+	if constexpr (sizeof(T) <= 4)
+		_BitScanReverse(&index, static_cast<unsigned long>(static_cast<std::make_unsigned_t<T>>(val)));
+	else
+		_BitScanReverse64(&index, static_cast<unsigned __int64>(val));
+
+	return bits - 1 - index;
+#else
+	if constexpr (sizeof(T) <= 4)
+		return __builtin_clz(static_cast<unsigned int>(static_cast<std::make_unsigned_t<T>>(val))) - (32 - bits);
+	else
+		return __builtin_clzll(static_cast<unsigned long long>(val));
+#endif
+}
+
 #include "Vector.hpp"
-#include "Matrix.hpp"
\ No newline at end of file
+#include "Matrix.hpp"
+#include "MathSimd.hpp"
\ No newline at end of file
@@ -0,0 +1,1620 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Parallel.hpp"
+#include "Simd.hpp"
+#include "Span.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace UU
+{
+	// Array forms of the transcendental functions. out must hold at least as many elements as the
+	// input and may alias it. Arrays above MATH_PARALLEL_GRAIN elements are split across hardware threads.
+	//
+	// Largest error in ulp seen against a long double reference over randomly sampled inputs:
+	//
+	//	            float   double
+	//	Sin, Cos    1.6     1.5     |x| <= TRIG_SIMD_RANGE, larger or non-finite lanes go through libm
+	//	Exp         1.0     1.8     including gradual underflow
+	//	Ln          0.9     0.9     including subnormal inputs
+	//	Pow         0.6     see below
+	//	ATan2       3.1     1.7
+	//
+	// Float Pow is evaluated in double. Double Pow is exp(y * ln(x)) without extra precision, so its error
+	// grows by about one ulp per unit of |y * ln(x)|, e.g. 2.5 ulp for x, y in [0.5, 2] and up to ~700 near overflow.
+	void Sin(CSpan<const float> in, CSpan<float> out);
+	void Sin(CSpan<const double> in, CSpan<double> out);
+	void Cos(CSpan<const float> in, CSpan<float> out);
+	void Cos(CSpan<const double> in, CSpan<double> out);
+
+	// Fills both outputs from a single range reduction per element.
+	void SinCos(CSpan<const float> in, CSpan<float> sin_out, CSpan<float> cos_out);
+	void SinCos(CSpan<const double> in, CSpan<double> sin_out, CSpan<double> cos_out);
+
+	void Exp(CSpan<const float> in, CSpan<float> out);
+	void Exp(CSpan<const double> in, CSpan<double> out);
+	void Ln(CSpan<const float> in, CSpan<float> out);
+	void Ln(CSpan<const double> in, CSpan<double> out);
+	void Pow(CSpan<const float> base, CSpan<const float> exponent, CSpan<float> out);
+	void Pow(CSpan<const double> base, CSpan<const double> exponent, CSpan<double> out);
+	void ATan2(CSpan<const float> y, CSpan<const float> x, CSpan<float> out);
+	void ATan2(CSpan<const double> y, CSpan<const double> x, CSpan<double> out);
+
+	// Element-wise sqrt(x^2 + y^2) without overflow or underflow in the squares, within 0.5 ulp for float and 1.2 for double.
+	void Hypot(CSpan<const float> x, CSpan<const float> y, CSpan<float> out);
+	void Hypot(CSpan<const double> x, CSpan<const double> y, CSpan<double> out);
+
+	// How the span reductions accumulate, float elements are always accumulated in double. Naive keeps running
+	// sums in several vectors and its error bound grows linearly with the element count. Pairwise adds blocks of
+	// PAIRWISE_BLOCK elements in a balanced tree, so the bound grows with log2 of the count. Compensated carries a
+	// Neumaier correction in every lane and has a bound independent of the count; with UU_FMA it also recovers the
+	// rounding error of each double product, as if Dot was computed in twice the precision.
+	enum class ESummation : uint8_t
+	{
+		Naive,
+		Pairwise,
+		Compensated
+	};
+
+	// Euclidean length of the whole array, infinite if any element is and NaN otherwise if any element is.
+	// Float squares are summed in double, where they can neither overflow nor underflow. With Naive summation
+	// double elements are summed in blocks of NORM_BLOCK scaled by a power of two of the block's largest
+	// magnitude, otherwise all are scaled by the power of two of the largest magnitude found in a first pass.
+	float Norm(CSpan<const float> values, ESummation summation = ESummation::Naive);
+	double Norm(CSpan<const double> values, ESummation summation = ESummation::Naive);
+
+	// Sum of a[i] * b[i], split across hardware threads above MATH_REDUCE_PARALLEL_GRAIN elements.
+	float Dot(CSpan<const float> a, CSpan<const float> b, ESummation summation = ESummation::Naive);
+	double Dot(CSpan<const double> a, CSpan<const double> b, ESummation summation = ESummation::Naive);
+
+	// Whole array reductions, split across hardware threads above MATH_REDUCE_PARALLEL_GRAIN elements.
+	// Min, Max, MinMax, ArgMin and ArgMax skip NaN elements like std::fmin and std::fmax, the result is NaN only
+	// when the array holds no number and ArgMin and ArgMax then return values.Size(). The Arg forms return the
+	// first index of the extreme, -0 and +0 compare equal. Sum follows IEEE addition, so any NaN element gives NaN,
+	// and accumulates float elements in double.
+	float Min(CSpan<const float> values);
+	double Min(CSpan<const double> values);
+	float Max(CSpan<const float> values);
+	double Max(CSpan<const double> values);
+	void MinMax(CSpan<const float> values, float & min, float & max);
+	void MinMax(CSpan<const double> values, double & min, double & max);
+	size_t ArgMin(CSpan<const float> values);
+	size_t ArgMin(CSpan<const double> values);
+	size_t ArgMax(CSpan<const float> values);
+	size_t ArgMax(CSpan<const double> values);
+	float Sum(CSpan<const float> values, ESummation summation = ESummation::Naive);
+	double Sum(CSpan<const double> values, ESummation summation = ESummation::Naive);
+
+	// Element-wise Clamp(in[i], min, max) and Lerp(a[i], b[i], factor), NaN elements stay NaN.
+	void Clamp(CSpan<const float> in, float min, float max, CSpan<float> out);
+	void Clamp(CSpan<const double> in, double min, double max, CSpan<double> out);
+	void Lerp(CSpan<const float> a, CSpan<const float> b, float factor, CSpan<float> out);
+	void Lerp(CSpan<const double> a, CSpan<const double> b, double factor, CSpan<double> out);
+
+	// Element-wise RoundToInt into int32_t, rounding explicitly in every lane without touching the MXCSR, and the
+	// conversion back, exact for |in| <= 2^24.
+	void RoundToInt(CSpan<const float> in, CSpan<int32_t> out, ERounding rounding = ERounding::Nearest);
+	void RoundToInt(CSpan<const double> in, CSpan<int32_t> out, ERounding rounding = ERounding::Nearest);
+	void ToFloat(CSpan<const int32_t> in, CSpan<float> out);
+
+	// Register forms of the same kernels, e.g. Sin(CSimd8f(_mm256_loadu_ps(p))).
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Sin(const CSimd<T, lanes> & x);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Cos(const CSimd<T, lanes> & x);
+	template <typename T, size_t lanes>
+	void SinCos(const CSimd<T, lanes> & x, CSimd<T, lanes> & sin_val, CSimd<T, lanes> & cos_val);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Exp(const CSimd<T, lanes> & x);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Ln(const CSimd<T, lanes> & x);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Pow(const CSimd<T, lanes> & base, const CSimd<T, lanes> & exponent);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> ATan2(const CSimd<T, lanes> & y, const CSimd<T, lanes> & x);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Hypot(const CSimd<T, lanes> & x, const CSimd<T, lanes> & y);
+	template <ERounding rounding, typename T, size_t lanes>
+	void RoundToInt(const CSimd<T, lanes> & x, int32_t * out);
+
+	constexpr size_t MATH_PARALLEL_GRAIN = 1 << 16;
+	constexpr size_t NORM_BLOCK = 1024;
+	constexpr size_t MATH_REDUCE_PARALLEL_GRAIN = 1 << 20;
+	constexpr size_t PAIRWISE_BLOCK = 1024;
+
+	// Largest |x| the vector Sin and Cos reduce themselves. The three part split of pi/2 stays exact up to
+	// 2^28 and the float quadrant has to remain an exact float.
+	template <typename T>
+	constexpr T TRIG_SIMD_RANGE = sizeof(T) == sizeof(float) ? T(1 << 24) : T(1 << 28);
+}
+
+namespace UU
+{
+	namespace Detail
+	{
+		// Reduces x to r in [-pi/4, pi/4] with x = q * pi/2 + r. Float lanes are reduced in double, a
+		// float Cody-Waite split loses most of the result's bits when x is close to a multiple of pi/2.
+		template <typename T, size_t lanes>
+		CSimd<T, lanes> ReduceHalfPi(const CSimd<T, lanes> & x, CSimd<T, lanes> & q)
+		{
+			using V = CSimd<T, lanes>;
+
+			if constexpr (sizeof(T) == sizeof(float) && lanes == 1)
+			{
+				CSimd<double, 1> q_double;
+
+				const CSimd<double, 1> r = ReduceHalfPi(CSimd<double, 1>(x.v[0]), q_double);
+
+				q = CSimd<float, 1>(static_cast<float>(q_double.v[0]));
+
+				return CSimd<float, 1>(static_cast<float>(r.v[0]));
+			}
+			else if constexpr (sizeof(T) == sizeof(float))
+			{
+				CSimd<double, lanes / 2> q_low, q_high;
+
+				const auto r_low = ReduceHalfPi(WidenLow(x), q_low);
+				const auto r_high = ReduceHalfPi(WidenHigh(x), q_high);
+
+				q = Narrow(q_low, q_high);
+
+				return Narrow(r_low, r_high);
+			}
+			else
+			{
+				q = Round(x * V(0.63661977236758134308));
+
+				V r = MulAdd(q, V(-1.57079625129699707031), x);
+				r = MulAdd(q, V(-7.54978941586159635336e-8), r);
+				return MulAdd(q, V(-5.39030285815811905290e-15), r);
+			}
+		}
+
+		// Minimax sin and cos on [-pi/4, pi/4], r2 = r * r.
+		template <typename T, size_t lanes>
+		CSimd<T, lanes> SinPoly(const CSimd<T, lanes> & r, const CSimd<T, lanes> & r2)
+		{
+			using V = CSimd<T, lanes>;
+
+			V p;
+
+			if constexpr (sizeof(T) == sizeof(float))
+			{
+				p = MulAdd(V(-1.9515295891e-4f), r2, V(8.3321608736e-3f));
+				p = MulAdd(p, r2, V(-1.6666654611e-1f));
+			}
+			else
+			{
+				p = MulAdd(V(1.58969099521155010221e-10), r2, V(-2.50507602534068634195e-8));
+				p = MulAdd(p, r2, V(2.75573137070700676789e-6));
+				p = MulAdd(p, r2, V(-1.98412698298579493134e-4));
+				p = MulAdd(p, r2, V(8.33333333332248946124e-3));
+				p = MulAdd(p, r2, V(-1.66666666666666324348e-1));
+			}
+
+			return MulAdd(p * r2, r, r);
+		}
+
+		template <typename T, size_t lanes>
+		CSimd<T, lanes> CosPoly(const CSimd<T, lanes> & r2)
+		{
+			using V = CSimd<T, lanes>;
+
+			V p;
+
+			if constexpr (sizeof(T) == sizeof(float))
+			{
+				p = MulAdd(V(2.443315711809948e-5f), r2, V(-1.388731625493765e-3f));
+				p = MulAdd(p, r2, V(4.166664568298827e-2f));
+			}
+			else
+			{
+				p = MulAdd(V(-1.13596475577881948265e-11), r2, V(2.08757232129817482790e-9));
+				p = MulAdd(p, r2, V(-2.75573143513906633035e-7));
+				p = MulAdd(p, r2, V(2.48015872894767294178e-5));
+				p = MulAdd(p, r2, V(-1.38888888888741095749e-3));
+				p = MulAdd(p, r2, V(4.16666666666666019037e-2));
+			}
+
+			// 1 - r2 / 2 is summed last so the small terms are not lost against it.
+			const V h = V(T(0.5)) * r2;
+			const V w = V(T(1)) - h;
+
+			return w + (((V(T(1)) - w) - h) + r2 * r2 * p);
+		}
+
+		// exp(y * ln(x)) for x >= 0, evaluated in double with just enough terms for a float result.
+		template <size_t lanes>
+		CSimd<double, lanes> PowFloatLanes(const CSimd<double, lanes> & x, const CSimd<double, lanes> & y)
+		{
+			using V = CSimd<double, lanes>;
+
+			constexpr double inf = std::numeric_limits<double>::infinity();
+
+			V e;
+			V m = Frexp(x, e);
+
+			const auto big = m > V(1.41421356237309504880);
+			m = Select(big, m * V(0.5), m);
+			e = Select(big, e + V(1.0), e);
+
+			// ln(m) = 2 atanh(s) with s = (m - 1) / (m + 1), |s| < 0.172.
+			const V f = m - V(1.0);
+			const V s = f / (V(2.0) + f);
+			const V z = s * s;
+
+			V p = MulAdd(V(1.0 / 11.0), z, V(1.0 / 9.0));
+			p = MulAdd(p, z, V(1.0 / 7.0));
+			p = MulAdd(p, z, V(1.0 / 5.0));
+			p = MulAdd(p, z, V(1.0 / 3.0));
+			p = MulAdd(p, z, V(1.0));
+
+			V ln = MulAdd(e, V(0.69314718055994530942), V(2.0) * s * p);
+			ln = Select(x == V(inf), x, ln);
+			ln = Select(x == V(0.0), V(-inf), ln);
+			ln = Select(x != x, x, ln);
+
+			const V t = y * ln;
+			const V tc = Min(Max(t, V(-104.0)), V(89.0));
+			const V n = Round(tc * V(1.44269504088896340736));
+
+			V r = MulAdd(n, V(-6.93147180369123816490e-1), tc);
+			r = MulAdd(n, V(-1.90821492927058770002e-10), r);
+
+			// Taylor series to r^8, |r| < 0.347 leaves a relative error below 2^-32.
+			V q = MulAdd(V(1.0 / 40320.0), r, V(1.0 / 5040.0));
+			q = MulAdd(q, r, V(1.0 / 720.0));
+			q = MulAdd(q, r, V(1.0 / 120.0));
+			q = MulAdd(q, r, V(1.0 / 24.0));
+			q = MulAdd(q, r, V(1.0 / 6.0));
+			q = MulAdd(q, r, V(0.5));
+			q = MulAdd(q, r, V(1.0));
+			q = MulAdd(q, r, V(1.0));
+
+			V result = q * Pow2i(n);
+			result = Select(t > V(89.0), V(inf), result);
+			result = Select(t < V(-104.0), V(0.0), result);
+
+			return Select(t != t, t, result);
+		}
+
+		// Recomputes the lanes outside `ok` with the scalar fallback.
+		template <typename T, size_t lanes, typename Fn>
+		CSimd<T, lanes> PatchLanes(const CSimd<T, lanes> & result, const CSimd<T, lanes> & x, const CSimdMask<T, lanes> & ok, Fn && fn)
+		{
+			const uint32_t bits = MoveMask(ok);
+
+			if (bits == (uint32_t(1) << lanes) - 1)
+				return result;
+
+			T xs[lanes], rs[lanes];
+
+			x.Store(xs);
+			result.Store(rs);
+
+			for (size_t i = 0; i < lanes; ++i)
+			{
+				if (!(bits & (uint32_t(1) << i)))
+					rs[i] = fn(xs[i]);
+			}
+
+			return CSimd<T, lanes>::Load(rs);
+		}
+
+		template <typename T, typename Fn>
+		void SimdTransform(CSpan<const T> in, CSpan<T> out, Fn && fn)
+		{
+			using V = CSimdNative<T>;
+
+			ParallelFor(in.Size(), MATH_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+			{
+				size_t i = begin;
+
+				for (; i + V::LANES <= end; i += V::LANES)
+					fn(V::Load(in.Data() + i)).Store(out.Data() + i);
+
+				if (i < end)
+				{
+					T a[V::LANES];
+
+					for (size_t l = 0; l < V::LANES; ++l)
+						a[l] = i + l < end ? in[i + l] : T(1);
+
+					fn(V::Load(a)).Store(a);
+
+					for (size_t l = 0; i + l < end; ++l)
+						out[i + l] = a[l];
+				}
+			});
+		}
+
+		template <typename T>
+		void SimdSinCos(CSpan<const T> in, CSpan<T> sin_out, CSpan<T> cos_out)
+		{
+			using V = CSimdNative<T>;
+
+			ParallelFor(in.Size(), MATH_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+			{
+				size_t i = begin;
+				V s, c;
+
+				for (; i + V::LANES <= end; i += V::LANES)
+				{
+					SinCos(V::Load(in.Data() + i), s, c);
+					s.Store(sin_out.Data() + i);
+					c.Store(cos_out.Data() + i);
+				}
+
+				if (i < end)
+				{
+					T a[V::LANES], b[V::LANES];
+
+					for (size_t l = 0; l < V::LANES; ++l)
+						a[l] = i + l < end ? in[i + l] : T(0);
+
+					SinCos(V::Load(a), s, c);
+					s.Store(a);
+					c.Store(b);
+
+					for (size_t l = 0; i + l < end; ++l)
+					{
+						sin_out[i + l] = a[l];
+						cos_out[i + l] = b[l];
+					}
+				}
+			});
+		}
+
+		template <typename T, typename Fn>
+		void SimdTransform(CSpan<const T> in0, CSpan<const T> in1, CSpan<T> out, Fn && fn)
+		{
+			using V = CSimdNative<T>;
+
+			ParallelFor(in0.Size(), MATH_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+			{
+				size_t i = begin;
+
+				for (; i + V::LANES <= end; i += V::LANES)
+					fn(V::Load(in0.Data() + i), V::Load(in1.Data() + i)).Store(out.Data() + i);
+
+				if (i < end)
+				{
+					T a[V::LANES], b[V::LANES];
+
+					for (size_t l = 0; l < V::LANES; ++l)
+					{
+						a[l] = i + l < end ? in0[i + l] : T(1);
+						b[l] = i + l < end ? in1[i + l] : T(1);
+					}
+
+					fn(V::Load(a), V::Load(b)).Store(a);
+
+					for (size_t l = 0; i + l < end; ++l)
+						out[i + l] = a[l];
+				}
+			});
+		}
+
+		// Sum of the squares of count floats, accumulated in double.
+		inline double SumSquares(const float * values, size_t count)
+		{
+			using V = CSimdNative<float>;
+			using D = CSimd<double, V::LANES / 2>;
+
+			D acc[4] = { D(0.0), D(0.0), D(0.0), D(0.0) };
+			size_t i = 0;
+
+			for (; i + 2 * V::LANES <= count; i += 2 * V::LANES)
+			{
+				const V a = V::Load(values + i);
+				const V b = V::Load(values + i + V::LANES);
+
+				const D a_low = WidenLow(a), a_high = WidenHigh(a);
+				const D b_low = WidenLow(b), b_high = WidenHigh(b);
+
+				acc[0] = MulAdd(a_low, a_low, acc[0]);
+				acc[1] = MulAdd(a_high, a_high, acc[1]);
+				acc[2] = MulAdd(b_low, b_low, acc[2]);
+				acc[3] = MulAdd(b_high, b_high, acc[3]);
+			}
+
+			double lanes[D::LANES];
+			double sum = 0.0;
+
+			((acc[0] + acc[1]) + (acc[2] + acc[3])).Store(lanes);
+
+			for (const double v : lanes)
+				sum += v;
+
+			for (; i < count; ++i)
+				sum += static_cast<double>(values[i]) * static_cast<double>(values[i]);
+
+			return sum;
+		}
+
+		// Adds block_sum * 2^(2 * block_exponent) to sum * 2^(2 * exponent), keeping the larger exponent.
+		inline void AddScaledSquares(double & sum, int & exponent, double block_sum, int block_exponent)
+		{
+			if (block_sum == 0.0)
+				return;
+
+			if (sum == 0.0 || block_exponent > exponent)
+			{
+				sum = std::ldexp(sum, 2 * (exponent - block_exponent)) + block_sum;
+				exponent = block_exponent;
+			}
+			else
+			{
+				sum += std::ldexp(block_sum, 2 * (block_exponent - exponent));
+			}
+		}
+
+		// Sum of the squares of count doubles as sum * 2^(2 * exponent). Each NORM_BLOCK is scaled by the
+		// power of two that brings its largest magnitude into [0.5, 1) while the block is still in cache.
+		inline void SumSquares(const double * values, size_t count, double & sum, int & exponent)
+		{
+			using V = CSimdNative<double>;
+
+			sum = 0.0;
+			exponent = 0;
+
+			for (size_t block = 0; block < count; block += NORM_BLOCK)
+			{
+				const double * p = values + block;
+				const size_t n = count - block < NORM_BLOCK ? count - block : NORM_BLOCK;
+
+				V big(0.0);
+				size_t i = 0;
+
+				for (; i + V::LANES <= n; i += V::LANES)
+					big = Max(big, Abs(V::Load(p + i)));
+
+				double lanes[V::LANES];
+				double m = 0.0;
+
+				big.Store(lanes);
+
+				for (const double v : lanes)
+					m = v > m ? v : m;
+
+				for (; i < n; ++i)
+					m = std::fabs(p[i]) > m ? std::fabs(p[i]) : m;
+
+				// Infinite blocks stay unscaled, subnormal ones stop at 2^1021 so the scale itself is finite.
+				int e = 0;
+
+				if (m > 0.0 && m <= std::numeric_limits<double>::max())
+					std::frexp(m, &e);
+
+				e = e < -1021 ? -1021 : e;
+
+				const double scale_value = std::ldexp(1.0, -e);
+				const V scale(scale_value);
+				V acc[2] = { V(0.0), V(0.0) };
+
+				for (i = 0; i + 2 * V::LANES <= n; i += 2 * V::LANES)
+				{
+					const V a = V::Load(p + i) * scale;
+					const V b = V::Load(p + i + V::LANES) * scale;
+
+					acc[0] = MulAdd(a, a, acc[0]);
+					acc[1] = MulAdd(b, b, acc[1]);
+				}
+
+				double block_sum = 0.0;
+
+				(acc[0] + acc[1]).Store(lanes);
+
+				for (const double v : lanes)
+					block_sum += v;
+
+				for (; i < n; ++i)
+				{
+					const double a = p[i] * scale_value;
+
+					block_sum += a * a;
+				}
+
+				AddScaledSquares(sum, exponent, block_sum, e);
+			}
+		}
+
+		// Smallest and largest non-NaN element of values[0, count), +inf and -inf when there is none.
+		// Min(x, acc) and Max(x, acc) return acc for the NaN lanes of x.
+		template <bool want_min, bool want_max, typename T>
+		void Extremes(const T * values, size_t count, T & min, T & max)
+		{
+			using V = CSimdNative<T>;
+
+			constexpr T inf = std::numeric_limits<T>::infinity();
+
+			V lo[2] = { V(inf), V(inf) };
+			V hi[2] = { V(-inf), V(-inf) };
+			size_t i = 0;
+
+			for (; i + 2 * V::LANES <= count; i += 2 * V::LANES)
+			{
+				const V a = V::Load(values + i);
+				const V b = V::Load(values + i + V::LANES);
+
+				if constexpr (want_min)
+				{
+					lo[0] = Min(a, lo[0]);
+					lo[1] = Min(b, lo[1]);
+				}
+
+				if constexpr (want_max)
+				{
+					hi[0] = Max(a, hi[0]);
+					hi[1] = Max(b, hi[1]);
+				}
+			}
+
+			T lanes_lo[V::LANES], lanes_hi[V::LANES];
+
+			Min(lo[0], lo[1]).Store(lanes_lo);
+			Max(hi[0], hi[1]).Store(lanes_hi);
+
+			min = inf;
+			max = -inf;
+
+			for (size_t l = 0; l < V::LANES; ++l)
+			{
+				min = lanes_lo[l] < min ? lanes_lo[l] : min;
+				max = lanes_hi[l] > max ? lanes_hi[l] : max;
+			}
+
+			for (; i < count; ++i)
+			{
+				min = values[i] < min ? values[i] : min;
+				max = values[i] > max ? values[i] : max;
+			}
+		}
+
+		// Index of the first element equal to value, count when there is none.
+		template <typename T>
+		size_t FindFirst(const T * values, size_t count, T value)
+		{
+			using V = CSimdNative<T>;
+
+			const V target(value);
+			size_t i = 0;
+
+			for (; i + V::LANES <= count; i += V::LANES)
+			{
+				const uint32_t bits = MoveMask(V::Load(values + i) == target);
+
+				if (bits != 0)
+					return i + CountTrailingZeros(bits);
+			}
+
+			for (; i < count; ++i)
+			{
+				if (values[i] == value)
+					return i;
+			}
+
+			return count;
+		}
+
+		// First index of the smallest or largest non-NaN element, count when there is none. Each block is
+		// searched for its extreme right after finding it, while the block is still in cache.
+		template <bool is_max, typename T>
+		size_t ArgExtreme(const T * values, size_t count)
+		{
+			constexpr size_t block_size = 2048;
+
+			size_t best = count;
+			T best_value = T(0);
+
+			for (size_t block = 0; block < count; block += block_size)
+			{
+				const size_t n = count - block < block_size ? count - block : block_size;
+
+				T min, max;
+
+				Extremes<!is_max, is_max>(values + block, n, min, max);
+
+				const T v = is_max ? max : min;
+
+				if (best == count || (is_max ? v > best_value : v < best_value))
+				{
+					const size_t at = FindFirst(values + block, n, v);
+
+					if (at < n)
+					{
+						best = block + at;
+						best_value = v;
+					}
+				}
+			}
+
+			return best;
+		}
+
+		template <bool want_min, bool want_max, typename T>
+		void ParallelExtremes(CSpan<const T> values, T & min, T & max)
+		{
+			constexpr T inf = std::numeric_limits<T>::infinity();
+
+			const size_t chunks = ParallelChunkCount(values.Size(), MATH_REDUCE_PARALLEL_GRAIN);
+
+			std::vector<T> mins(chunks), maxs(chunks);
+
+			ParallelFor(values.Size(), MATH_REDUCE_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+			{
+				Extremes<want_min, want_max>(values.Data() + begin, end - begin, mins[chunk], maxs[chunk]);
+			});
+
+			min = inf;
+			max = -inf;
+
+			for (size_t c = 0; c < chunks; ++c)
+			{
+				min = mins[c] < min ? mins[c] : min;
+				max = maxs[c] > max ? maxs[c] : max;
+			}
+
+			// The starting infinities only survive on their own when the array holds no number.
+			if (want_min && min == inf && FindFirst(values.Data(), values.Size(), inf) == values.Size())
+				min = std::numeric_limits<T>::quiet_NaN();
+
+			if (want_max && max == -inf && FindFirst(values.Data(), values.Size(), -inf) == values.Size())
+				max = std::numeric_limits<T>::quiet_NaN();
+		}
+
+		template <bool is_max, typename T>
+		size_t ParallelArgExtreme(CSpan<const T> values)
+		{
+			const size_t chunks = ParallelChunkCount(values.Size(), MATH_REDUCE_PARALLEL_GRAIN);
+
+			std::vector<size_t> parts(chunks);
+
+			ParallelFor(values.Size(), MATH_REDUCE_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+			{
+				const size_t at = ArgExtreme<is_max>(values.Data() + begin, end - begin);
+
+				parts[chunk] = at < end - begin ? begin + at : values.Size();
+			});
+
+			// Chunks are in index order, so keeping the first strictly better value keeps the first index.
+			size_t best = values.Size();
+
+			for (const size_t at : parts)
+			{
+				if (at != values.Size() && (best == values.Size() || (is_max ? values[at] > values[best] : values[at] < values[best])))
+					best = at;
+			}
+
+			return best;
+		}
+
+		enum class EReduceTerm : uint8_t
+		{
+			Value,
+			Product,
+			ScaledSquare
+		};
+
+		// Double vectors holding half a native float vector, or a native double vector.
+		template <typename T>
+		using CSimdWide = CSimd<double, sizeof(T) == sizeof(float) ? CSimdNative<float>::LANES / 2 : CSimdNative<double>::LANES>;
+
+		// Loads 2 * CSimdWide<T>::LANES elements at p, widened to double.
+		template <typename T>
+		void LoadWide(const T * p, CSimdWide<T> & low, CSimdWide<T> & high)
+		{
+			if constexpr (sizeof(T) == sizeof(float))
+			{
+				const CSimdNative<float> v = CSimdNative<float>::Load(p);
+
+				low = WidenLow(v);
+				high = WidenHigh(v);
+			}
+			else
+			{
+				low = CSimdWide<T>::Load(p);
+				high = CSimdWide<T>::Load(p + CSimdWide<T>::LANES);
+			}
+		}
+
+		// Neumaier's step, sum + x with the rounding error of the addition collected in compensation.
+		template <typename D>
+		void CompensatedAdd(D & sum, D & compensation, const D & x)
+		{
+			const D t = sum + x;
+
+			compensation = compensation + Select(Abs(sum) >= Abs(x), (sum - t) + x, (x - t) + sum);
+			sum = t;
+		}
+
+		inline void CompensatedAdd(double & sum, double & compensation, double x)
+		{
+			const double t = sum + x;
+
+			compensation += std::fabs(sum) >= std::fabs(x) ? (sum - t) + x : (x - t) + sum;
+			sum = t;
+		}
+
+		// Accumulates the terms of elements [begin, end) as sum + compensation, in double for float elements.
+		// Terms are a[i], a[i] * b[i] or (a[i] * scale)^2, summed in four vectors of lanes each.
+		template <ESummation summation, EReduceTerm term, typename T>
+		void AccumulateRange(const T * a, const T * b, double scale, size_t begin, size_t end, double & sum, double & compensation)
+		{
+			using D = CSimdWide<T>;
+
+			constexpr size_t step = 4 * D::LANES;
+
+			if (summation == ESummation::Pairwise && end - begin > PAIRWISE_BLOCK)
+			{
+				// Splitting on a multiple of the step keeps both halves on full vectors.
+				const size_t middle = begin + (end - begin) / 2 / step * step;
+
+				double low_sum, low_compensation, high_sum, high_compensation;
+
+				AccumulateRange<summation, term>(a, b, scale, begin, middle, low_sum, low_compensation);
+				AccumulateRange<summation, term>(a, b, scale, middle, end, high_sum, high_compensation);
+
+				sum = low_sum + high_sum;
+				compensation = 0.0;
+
+				return;
+			}
+
+			D s[4] = { D(0.0), D(0.0), D(0.0), D(0.0) };
+			D c[4] = { D(0.0), D(0.0), D(0.0), D(0.0) };
+			const D scale_v(scale);
+			size_t i = begin;
+
+			for (; i + step <= end; i += step)
+			{
+				D x[4], y[4];
+
+				LoadWide(a + i, x[0], x[1]);
+				LoadWide(a + i + 2 * D::LANES, x[2], x[3]);
+
+				if constexpr (term == EReduceTerm::Product)
+				{
+					LoadWide(b + i, y[0], y[1]);
+					LoadWide(b + i + 2 * D::LANES, y[2], y[3]);
+				}
+
+				for (size_t k = 0; k < 4; ++k)
+				{
+					if constexpr (term == EReduceTerm::ScaledSquare)
+					{
+						x[k] = x[k] * scale_v;
+						y[k] = x[k];
+					}
+
+					if constexpr (term == EReduceTerm::Value)
+					{
+						if constexpr (summation == ESummation::Compensated)
+							CompensatedAdd(s[k], c[k], x[k]);
+						else
+							s[k] = s[k] + x[k];
+					}
+					else if constexpr (summation == ESummation::Compensated)
+					{
+						const D p = x[k] * y[k];
+
+						CompensatedAdd(s[k], c[k], p);
+
+#if defined(UU_FMA)
+						// The exact rounding error of a double product, float products are exact in double.
+						if constexpr (sizeof(T) == sizeof(double))
+							c[k] = c[k] + MulAdd(x[k], y[k], -p);
+#endif
+					}
+					else
+					{
+						s[k] = MulAdd(x[k], y[k], s[k]);
+					}
+				}
+			}
+
+			double lanes[D::LANES];
+
+			sum = 0.0;
+			compensation = 0.0;
+
+			if constexpr (summation == ESummation::Compensated)
+			{
+				for (size_t k = 0; k < 4; ++k)
+				{
+					s[k].Store(lanes);
+
+					for (const double v : lanes)
+						CompensatedAdd(sum, compensation, v);
+
+					c[k].Store(lanes);
+
+					for (const double v : lanes)
+						compensation += v;
+				}
+			}
+			else
+			{
+				((s[0] + s[1]) + (s[2] + s[3])).Store(lanes);
+
+				for (const double v : lanes)
+					sum += v;
+			}
+
+			for (; i < end; ++i)
+			{
+				double x = static_cast<double>(a[i]);
+				double y = 1.0;
+
+				if constexpr (term == EReduceTerm::Product)
+					y = static_cast<double>(b[i]);
+
+				if constexpr (term == EReduceTerm::ScaledSquare)
+				{
+					x *= scale;
+					y = x;
+				}
+
+				const double p = x * y;
+
+				if constexpr (summation == ESummation::Compensated)
+				{
+					CompensatedAdd(sum, compensation, p);
+
+#if defined(UU_FMA)
+					if constexpr (term != EReduceTerm::Value && sizeof(T) == sizeof(double))
+						compensation += std::fma(x, y, -p);
+#endif
+				}
+				else
+				{
+					sum += p;
+				}
+			}
+		}
+
+		// Chunk results are merged in index order with compensation, so the result does not depend on the thread count.
+		template <ESummation summation, EReduceTerm term, typename T>
+		double ParallelAccumulate(const T * a, const T * b, double scale, size_t count)
+		{
+			const size_t chunks = ParallelChunkCount(count, MATH_REDUCE_PARALLEL_GRAIN);
+
+			std::vector<double> sums(chunks), compensations(chunks);
+
+			ParallelFor(count, MATH_REDUCE_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+			{
+				AccumulateRange<summation, term>(a, b, scale, begin, end, sums[chunk], compensations[chunk]);
+			});
+
+			double sum = 0.0, compensation = 0.0;
+
+			for (size_t c = 0; c < chunks; ++c)
+			{
+				CompensatedAdd(sum, compensation, sums[c]);
+				compensation += compensations[c];
+			}
+
+			return sum + compensation;
+		}
+
+		template <EReduceTerm term, typename T>
+		double Accumulate(const T * a, const T * b, double scale, size_t count, ESummation summation)
+		{
+			switch (summation)
+			{
+			case ESummation::Pairwise:
+				return ParallelAccumulate<ESummation::Pairwise, term>(a, b, scale, count);
+			case ESummation::Compensated:
+				return ParallelAccumulate<ESummation::Compensated, term>(a, b, scale, count);
+			default:
+				return ParallelAccumulate<ESummation::Naive, term>(a, b, scale, count);
+			}
+		}
+
+		template <ERounding rounding, typename T, size_t lanes>
+		CSimd<T, lanes> RoundLanes(const CSimd<T, lanes> & x)
+		{
+			if constexpr (rounding == ERounding::Nearest)
+				return Round(x);
+			else if constexpr (rounding == ERounding::Floor)
+				return Floor(x);
+			else if constexpr (rounding == ERounding::Ceil)
+				return Ceil(x);
+			else
+				return Trunc(x);
+		}
+
+		template <ERounding rounding, typename T>
+		void ParallelRoundToInt(CSpan<const T> in, CSpan<int32_t> out)
+		{
+			using V = CSimdNative<T>;
+
+			ParallelFor(in.Size(), MATH_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+			{
+				size_t i = begin;
+
+				for (; i + V::LANES <= end; i += V::LANES)
+					StoreInt32(RoundLanes<rounding>(V::Load(in.Data() + i)), out.Data() + i);
+
+				for (; i < end; ++i)
+					out[i] = RoundToInt<int32_t, rounding>(in[i]);
+			});
+		}
+
+		template <typename T>
+		void ParallelRoundToInt(CSpan<const T> in, CSpan<int32_t> out, ERounding rounding)
+		{
+			switch (rounding)
+			{
+			case ERounding::Floor:
+				return ParallelRoundToInt<ERounding::Floor>(in, out);
+			case ERounding::Ceil:
+				return ParallelRoundToInt<ERounding::Ceil>(in, out);
+			case ERounding::Trunc:
+				return ParallelRoundToInt<ERounding::Trunc>(in, out);
+			default:
+				return ParallelRoundToInt<ERounding::Nearest>(in, out);
+			}
+		}
+
+		// The sum of squares is NaN when an infinite element meets a NaN one, std::hypot returns infinity for those.
+		template <typename T>
+		T NormSpecialCases(T norm, CSpan<const T> values)
+		{
+			if (norm == norm)
+				return norm;
+
+			for (const T v : values)
+			{
+				if (std::fabs(v) == std::numeric_limits<T>::infinity())
+					return std::numeric_limits<T>::infinity();
+			}
+
+			return norm;
+		}
+
+		// Norm with every element scaled by the power of two that brings the largest magnitude into [0.5, 1),
+		// found in a first pass. Float squares need no scaling in double.
+		template <typename T>
+		T ScaledNorm(CSpan<const T> values, ESummation summation)
+		{
+			int e = 0;
+
+			if constexpr (sizeof(T) == sizeof(double))
+			{
+				T min, max;
+
+				ParallelExtremes<true, true>(values, min, max);
+
+				const T big = -min > max ? -min : max;
+
+				if (big == std::numeric_limits<T>::infinity())
+					return big;
+
+				if (big > T(0))
+					std::frexp(big, &e);
+
+				e = e < -1021 ? -1021 : e;
+			}
+
+			const double sum = Accumulate<EReduceTerm::ScaledSquare>(values.Data(), values.Data(), std::ldexp(1.0, -e), values.Size(), summation);
+
+			return NormSpecialCases(static_cast<T>(std::ldexp(std::sqrt(sum), e)), values);
+		}
+	}
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Sin(const CSimd<T, lanes> & x)
+{
+	using V = CSimd<T, lanes>;
+
+	V q;
+	const V r = Detail::ReduceHalfPi(x, q);
+	const V r2 = r * r;
+
+	// sin(q * pi/2 + r) cycles through sin r, cos r, -sin r, -cos r.
+	V result = Select(TestBit(q, 1), Detail::CosPoly(r2), Detail::SinPoly(r, r2));
+	result = Select(TestBit(q, 2), -result, result);
+	result = Select(x == V(T(0)), x, result);
+
+	return Detail::PatchLanes(result, x, Abs(x) <= V(TRIG_SIMD_RANGE<T>), [](T v) { return std::sin(v); });
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Cos(const CSimd<T, lanes> & x)
+{
+	using V = CSimd<T, lanes>;
+
+	V q;
+	const V r = Detail::ReduceHalfPi(x, q);
+	const V r2 = r * r;
+
+	// cos(q * pi/2 + r) cycles through cos r, -sin r, -cos r, sin r.
+	V result = Select(TestBit(q, 1), Detail::SinPoly(r, r2), Detail::CosPoly(r2));
+	result = Select(TestBit(q + V(T(1)), 2), -result, result);
+
+	return Detail::PatchLanes(result, x, Abs(x) <= V(TRIG_SIMD_RANGE<T>), [](T v) { return std::cos(v); });
+}
+
+template <typename T, size_t lanes>
+void UU::SinCos(const CSimd<T, lanes> & x, CSimd<T, lanes> & sin_val, CSimd<T, lanes> & cos_val)
+{
+	using V = CSimd<T, lanes>;
+
+	V q;
+	const V r = Detail::ReduceHalfPi(x, q);
+	const V r2 = r * r;
+	const V s = Detail::SinPoly(r, r2);
+	const V c = Detail::CosPoly(r2);
+
+	const auto odd = TestBit(q, 1);
+
+	V sv = Select(odd, c, s);
+	V cv = Select(odd, s, c);
+
+	sv = Select(TestBit(q, 2), -sv, sv);
+	sv = Select(x == V(T(0)), x, sv);
+	cv = Select(TestBit(q + V(T(1)), 2), -cv, cv);
+
+	const auto ok = Abs(x) <= V(TRIG_SIMD_RANGE<T>);
+
+	sin_val = Detail::PatchLanes(sv, x, ok, [](T v) { return std::sin(v); });
+	cos_val = Detail::PatchLanes(cv, x, ok, [](T v) { return std::cos(v); });
+}
+
+template <typename T, typename>
+void UU::SinCos(T val, T & sin_val, T & cos_val)
+{
+	if constexpr (std::is_same<T, float>::value || std::is_same<T, double>::value)
+	{
+		if (!(Abs(val) <= TRIG_SIMD_RANGE<T>))
+		{
+			sin_val = static_cast<T>(sin(val));
+			cos_val = static_cast<T>(cos(val));
+			return;
+		}
+
+		using V = CSimd<T, 1>;
+
+		V q;
+		const V r = Detail::ReduceHalfPi(V(val), q);
+		const V r2 = r * r;
+
+		// Quadrant selection by index and sign multiply, data dependent branches here mispredict on every call.
+		const T sc[2] = { Detail::SinPoly(r, r2).v[0], Detail::CosPoly(r2).v[0] };
+		const int64_t n = static_cast<int64_t>(q.v[0]);
+
+		sin_val = val == T(0) ? val : sc[n & 1] * T(1 - (n & 2));
+		cos_val = sc[(n & 1) ^ 1] * T(1 - ((n + 1) & 2));
+	}
+	else
+	{
+		sin_val = Sin(val);
+		cos_val = Cos(val);
+	}
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Exp(const CSimd<T, lanes> & x)
+{
+	using V = CSimd<T, lanes>;
+
+	constexpr bool is_float = sizeof(T) == sizeof(float);
+	constexpr T hi = is_float ? T(88.72283935546875) : T(709.782712893384);
+	constexpr T lo = is_float ? T(-103.97208404541015625) : T(-745.1332191019412);
+
+	const V xc = Min(Max(x, V(lo)), V(hi));
+	const V n = Round(xc * V(T(1.44269504088896340736)));
+
+	V p;
+
+	if constexpr (is_float)
+	{
+		V r = MulAdd(n, V(-0.693359375f), xc);
+		r = MulAdd(n, V(2.12194440e-4f), r);
+
+		p = MulAdd(V(1.9875691500e-4f), r, V(1.3981999507e-3f));
+		p = MulAdd(p, r, V(8.3334519073e-3f));
+		p = MulAdd(p, r, V(4.1665795894e-2f));
+		p = MulAdd(p, r, V(1.6666665459e-1f));
+		p = MulAdd(p, r, V(5.0000001201e-1f));
+		p = MulAdd(p, r * r, r) + V(1.f);
+	}
+	else
+	{
+		V r = MulAdd(n, V(-6.93145751953125e-1), xc);
+		r = MulAdd(n, V(-1.42860682030941723212e-6), r);
+
+		// Pade form exp(r) = 1 + 2 r P(r^2) / (Q(r^2) - r P(r^2)).
+		const V r2 = r * r;
+		const V px = r * MulAdd(MulAdd(V(1.26177193074810590878e-4), r2, V(3.02994407707441961300e-2)), r2, V(1.0));
+		const V qx = MulAdd(MulAdd(MulAdd(V(3.00198505138664455042e-6), r2, V(2.52448340349684104192e-3)), r2,
+			V(2.27265548208155028766e-1)), r2, V(2.0));
+
+		p = MulAdd(V(2.0), px / (qx - px), V(1.0));
+	}
+
+	// Scaling in two halves keeps both powers normal down to the subnormal results.
+	const V n1 = Floor(n * V(T(0.5)));
+	V result = p * Pow2i(n1) * Pow2i(n - n1);
+
+	result = Select(x > V(hi), V(std::numeric_limits<T>::infinity()), result);
+	result = Select(x < V(lo), V(T(0)), result);
+
+	return Select(x != x, x, result);
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Ln(const CSimd<T, lanes> & x)
+{
+	using V = CSimd<T, lanes>;
+
+	constexpr bool is_float = sizeof(T) == sizeof(float);
+
+	// Subnormals are scaled into the normal range first.
+	const auto tiny = x < V(std::numeric_limits<T>::min());
+	const V xs = Select(tiny, x * V(is_float ? T(33554432.0) : T(18014398509481984.0)), x);
+
+	V e;
+	V m = Frexp(xs, e);
+
+	e = Select(tiny, e - V(is_float ? T(25) : T(54)), e);
+
+	// Centre the mantissa on 1 so that f = m - 1 lies in [sqrt(1/2) - 1, sqrt(2) - 1].
+	const auto big = m > V(T(1.41421356237309504880));
+	m = Select(big, m * V(T(0.5)), m);
+	e = Select(big, e + V(T(1)), e);
+
+	const V f = m - V(T(1));
+
+	V result;
+
+	if constexpr (is_float)
+	{
+		const V z = f * f;
+
+		V p = MulAdd(V(7.0376836292e-2f), f, V(-1.1514610310e-1f));
+		p = MulAdd(p, f, V(1.1676998740e-1f));
+		p = MulAdd(p, f, V(-1.2420140846e-1f));
+		p = MulAdd(p, f, V(1.4249322787e-1f));
+		p = MulAdd(p, f, V(-1.6668057665e-1f));
+		p = MulAdd(p, f, V(2.0000714765e-1f));
+		p = MulAdd(p, f, V(-2.4999993993e-1f));
+		p = MulAdd(p, f, V(3.3333331174e-1f));
+
+		V y = p * f * z;
+		y = MulAdd(e, V(-2.12194440e-4f), y);
+		y = MulAdd(z, V(-0.5f), y);
+
+		result = MulAdd(e, V(0.693359375f), f + y);
+	}
+	else
+	{
+		const V s = f / (V(2.0) + f);
+		const V z = s * s;
+
+		V r = MulAdd(V(1.479819860511658591e-1), z, V(1.531383769920937332e-1));
+		r = MulAdd(r, z, V(1.818357216161805012e-1));
+		r = MulAdd(r, z, V(2.222219843214978396e-1));
+		r = MulAdd(r, z, V(2.857142874366239149e-1));
+		r = MulAdd(r, z, V(3.999999999940941908e-1));
+		r = MulAdd(r, z, V(6.666666666666735130e-1));
+		r = r * z;
+
+		const V hfsq = V(0.5) * f * f;
+
+		result = e * V(6.93147180369123816490e-1) - ((hfsq - MulAdd(s, hfsq + r, e * V(1.90821492927058770002e-10))) - f);
+	}
+
+	result = Select(x == V(std::numeric_limits<T>::infinity()), x, result);
+	result = Select(x == V(T(0)), V(-std::numeric_limits<T>::infinity()), result);
+	result = Select(x < V(T(0)), V(std::numeric_limits<T>::quiet_NaN()), result);
+
+	return Select(x != x, x, result);
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Pow(const CSimd<T, lanes> & base, const CSimd<T, lanes> & exponent)
+{
+	using V = CSimd<T, lanes>;
+
+	V result;
+
+	if constexpr (sizeof(T) == sizeof(float))
+	{
+		result = Narrow(Detail::PowFloatLanes(Abs(WidenLow(base)), WidenLow(exponent)),
+			Detail::PowFloatLanes(Abs(WidenHigh(base)), WidenHigh(exponent)));
+	}
+	else
+	{
+		result = Exp(exponent * Ln(Abs(base)));
+	}
+
+	constexpr T inf = std::numeric_limits<T>::infinity();
+
+	// Negative bases are only defined for integral exponents, odd ones keep the sign (also of -0 and -inf).
+	const V half = exponent * V(T(0.5));
+	const auto integral = Round(exponent) == exponent;
+	const auto odd = integral & (Round(half) != half);
+	const auto negative = base < V(T(0));
+
+	result = Select(odd & (CopySign(V(T(1)), base) < V(T(0))), -result, result);
+	result = Select(negative & (base > V(-inf)) & !integral & (exponent == exponent), V(std::numeric_limits<T>::quiet_NaN()), result);
+
+	// x^0 = 1^y = (-1)^+-inf = 1, even for NaN x or y.
+	const auto one = (exponent == V(T(0))) | (base == V(T(1))) | ((base == V(T(-1))) & (Abs(exponent) == V(inf)));
+
+	return Select(one, V(T(1)), result);
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::ATan2(const CSimd<T, lanes> & y, const CSimd<T, lanes> & x)
+{
+	using V = CSimd<T, lanes>;
+
+	constexpr T inf = std::numeric_limits<T>::infinity();
+
+	const V ax = Abs(x), ay = Abs(y);
+	const V lo = Min(ax, ay), hi = Max(ax, ay);
+
+	// a = lo / hi in [0, 1], with 0 / 0 taken as 0 and inf / inf as 1.
+	V a = lo / hi;
+	a = Select(hi == V(T(0)), V(T(0)), a);
+	a = Select(lo == V(inf), V(T(1)), a);
+
+	V result;
+
+	if constexpr (sizeof(T) == sizeof(float))
+	{
+		// atan(a) = pi/4 + atan((a - 1) / (a + 1)) brings the argument into [-tan(pi/8), tan(pi/8)].
+		const auto big = a > V(0.414213562373095f);
+		const V t = Select(big, (a - V(1.f)) / (a + V(1.f)), a);
+		const V z = t * t;
+
+		V p = MulAdd(V(8.05374449538e-2f), z, V(-1.38776856032e-1f));
+		p = MulAdd(p, z, V(1.99777106478e-1f));
+		p = MulAdd(p, z, V(-3.33329491539e-1f));
+
+		result = MulAdd(p * z, t, t) + Select(big, V(0.785398163397448f), V(0.f));
+	}
+	else
+	{
+		const auto big = a > V(0.66);
+		const V t = Select(big, (a - V(1.0)) / (a + V(1.0)), a);
+		const V z = t * t;
+
+		V p = MulAdd(V(-8.750608600031904122785e-1), z, V(-1.615753718733365076637e1));
+		p = MulAdd(p, z, V(-7.500855792314704667340e1));
+		p = MulAdd(p, z, V(-1.228866684490136173410e2));
+		p = MulAdd(p, z, V(-6.485021904942025371773e1));
+
+		V q = z + V(2.485846490142306297962e1);
+		q = MulAdd(q, z, V(1.650270098316988542046e2));
+		q = MulAdd(q, z, V(4.328810604912902668951e2));
+		q = MulAdd(q, z, V(4.853903996359136964868e2));
+		q = MulAdd(q, z, V(1.945506571482613964425e2));
+
+		// pi/4 carries the low bits of pi/4 separately.
+		result = MulAdd(t * z, p / q, t) + Select(big, V(3.061616997868382943065e-17), V(0.0)) +
+			Select(big, V(7.85398163397448309616e-1), V(0.0));
+	}
+
+	result = Select(ay > ax, V(T(1.57079632679489661923)) - result, result);
+	result = Select(CopySign(V(T(1)), x) < V(T(0)), V(T(3.14159265358979323846)) - result, result);
+	result = CopySign(result, y);
+
+	return Select((x != x) | (y != y), x + y, result);
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Hypot(const CSimd<T, lanes> & x, const CSimd<T, lanes> & y)
+{
+	using V = CSimd<T, lanes>;
+
+	constexpr T inf = std::numeric_limits<T>::infinity();
+
+	const V ax = Abs(x), ay = Abs(y);
+	V result;
+
+	if constexpr (sizeof(T) == sizeof(float) && lanes == 1)
+	{
+		const double a = ax.v[0], b = ay.v[0];
+
+		result = V(static_cast<float>(std::sqrt(a * a + b * b)));
+	}
+	else if constexpr (sizeof(T) == sizeof(float))
+	{
+		// Float squares are exact in double and their sum cannot overflow.
+		const auto hypot_lanes = [](const auto & a, const auto & b) { return Sqrt(MulAdd(a, a, b * b)); };
+
+		result = Narrow(hypot_lanes(WidenLow(ax), WidenLow(ay)), hypot_lanes(WidenHigh(ax), WidenHigh(ay)));
+	}
+	else
+	{
+		// Scaling by a power of two is exact and brings the larger operand's square into range.
+		const V big = Max(ax, ay);
+		const auto huge = big > V(1e150);
+		const auto tiny = big < V(1e-150);
+
+		const V scale = Select(huge, Pow2i(V(-600.0)), Select(tiny, Pow2i(V(600.0)), V(1.0)));
+		const V unscale = Select(huge, Pow2i(V(600.0)), Select(tiny, Pow2i(V(-600.0)), V(1.0)));
+
+		const V sx = ax * scale, sy = ay * scale;
+
+		result = Sqrt(MulAdd(sx, sx, sy * sy)) * unscale;
+	}
+
+	// An infinite operand wins over NaN, as in std::hypot.
+	return Select((ax == V(inf)) | (ay == V(inf)), V(inf), result);
+}
+
+template <UU::ERounding rounding, typename T, size_t lanes>
+void UU::RoundToInt(const CSimd<T, lanes> & x, int32_t * out)
+{
+	StoreInt32(Detail::RoundLanes<rounding>(x), out);
+}
+
+inline void UU::Sin(CSpan<const float> in, CSpan<float> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<float> & x) { return Sin(x); });
+}
+
+inline void UU::Sin(CSpan<const double> in, CSpan<double> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<double> & x) { return Sin(x); });
+}
+
+inline void UU::Cos(CSpan<const float> in, CSpan<float> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<float> & x) { return Cos(x); });
+}
+
+inline void UU::Cos(CSpan<const double> in, CSpan<double> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<double> & x) { return Cos(x); });
+}
+
+inline void UU::SinCos(CSpan<const float> in, CSpan<float> sin_out, CSpan<float> cos_out)
+{
+	Detail::SimdSinCos(in, sin_out, cos_out);
+}
+
+inline void UU::SinCos(CSpan<const double> in, CSpan<double> sin_out, CSpan<double> cos_out)
+{
+	Detail::SimdSinCos(in, sin_out, cos_out);
+}
+
+inline void UU::Exp(CSpan<const float> in, CSpan<float> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<float> & x) { return Exp(x); });
+}
+
+inline void UU::Exp(CSpan<const double> in, CSpan<double> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<double> & x) { return Exp(x); });
+}
+
+inline void UU::Ln(CSpan<const float> in, CSpan<float> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<float> & x) { return Ln(x); });
+}
+
+inline void UU::Ln(CSpan<const double> in, CSpan<double> out)
+{
+	Detail::SimdTransform(in, out, [](const CSimdNative<double> & x) { return Ln(x); });
+}
+
+inline void UU::Pow(CSpan<const float> base, CSpan<const float> exponent, CSpan<float> out)
+{
+	Detail::SimdTransform(base, exponent, out, [](const CSimdNative<float> & b, const CSimdNative<float> & e) { return Pow(b, e); });
+}
+
+inline void UU::Pow(CSpan<const double> base, CSpan<const double> exponent, CSpan<double> out)
+{
+	Detail::SimdTransform(base, exponent, out, [](const CSimdNative<double> & b, const CSimdNative<double> & e) { return Pow(b, e); });
+}
+
+inline void UU::ATan2(CSpan<const float> y, CSpan<const float> x, CSpan<float> out)
+{
+	Detail::SimdTransform(y, x, out, [](const CSimdNative<float> & a, const CSimdNative<float> & b) { return ATan2(a, b); });
+}
+
+inline void UU::ATan2(CSpan<const double> y, CSpan<const double> x, CSpan<double> out)
+{
+	Detail::SimdTransform(y, x, out, [](const CSimdNative<double> & a, const CSimdNative<double> & b) { return ATan2(a, b); });
+}
+
+inline void UU::Hypot(CSpan<const float> x, CSpan<const float> y, CSpan<float> out)
+{
+	Detail::SimdTransform(x, y, out, [](const CSimdNative<float> & a, const CSimdNative<float> & b) { return Hypot(a, b); });
+}
+
+inline void UU::Hypot(CSpan<const double> x, CSpan<const double> y, CSpan<double> out)
+{
+	Detail::SimdTransform(x, y, out, [](const CSimdNative<double> & a, const CSimdNative<double> & b) { return Hypot(a, b); });
+}
+
+inline float UU::Norm(CSpan<const float> values, ESummation summation)
+{
+	if (summation != ESummation::Naive)
+		return Detail::ScaledNorm(values, summation);
+
+	std::vector<double> parts(ParallelChunkCount(values.Size(), MATH_PARALLEL_GRAIN));
+
+	ParallelFor(values.Size(), MATH_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+	{
+		parts[chunk] = Detail::SumSquares(values.Data() + begin, end - begin);
+	});
+
+	double sum = 0.0;
+
+	for (const double part : parts)
+		sum += part;
+
+	return Detail::NormSpecialCases(static_cast<float>(std::sqrt(sum)), values);
+}
+
+inline double UU::Norm(CSpan<const double> values, ESummation summation)
+{
+	if (summation != ESummation::Naive)
+		return Detail::ScaledNorm(values, summation);
+
+	const size_t chunks = ParallelChunkCount(values.Size(), MATH_PARALLEL_GRAIN);
+
+	std::vector<double> sums(chunks);
+	std::vector<int> exponents(chunks);
+
+	ParallelFor(values.Size(), MATH_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+	{
+		Detail::SumSquares(values.Data() + begin, end - begin, sums[chunk], exponents[chunk]);
+	});
+
+	double sum = 0.0;
+	int exponent = 0;
+
+	for (size_t c = 0; c < chunks; ++c)
+		Detail::AddScaledSquares(sum, exponent, sums[c], exponents[c]);
+
+	return Detail::NormSpecialCases(std::ldexp(std::sqrt(sum), exponent), values);
+}
+
+inline float UU::Min(CSpan<const float> values)
+{
+	float min, max;
+
+	Detail::ParallelExtremes<true, false>(values, min, max);
+
+	return min;
+}
+
+inline double UU::Min(CSpan<const double> values)
+{
+	double min, max;
+
+	Detail::ParallelExtremes<true, false>(values, min, max);
+
+	return min;
+}
+
+inline float UU::Max(CSpan<const float> values)
+{
+	float min, max;
+
+	Detail::ParallelExtremes<false, true>(values, min, max);
+
+	return max;
+}
+
+inline double UU::Max(CSpan<const double> values)
+{
+	double min, max;
+
+	Detail::ParallelExtremes<false, true>(values, min, max);
+
+	return max;
+}
+
+inline void UU::MinMax(CSpan<const float> values, float & min, float & max)
+{
+	Detail::ParallelExtremes<true, true>(values, min, max);
+}
+
+inline void UU::MinMax(CSpan<const double> values, double & min, double & max)
+{
+	Detail::ParallelExtremes<true, true>(values, min, max);
+}
+
+inline size_t UU::ArgMin(CSpan<const float> values)
+{
+	return Detail::ParallelArgExtreme<false>(values);
+}
+
+inline size_t UU::ArgMin(CSpan<const double> values)
+{
+	return Detail::ParallelArgExtreme<false>(values);
+}
+
+inline size_t UU::ArgMax(CSpan<const float> values)
+{
+	return Detail::ParallelArgExtreme<true>(values);
+}
+
+inline size_t UU::ArgMax(CSpan<const double> values)
+{
+	return Detail::ParallelArgExtreme<true>(values);
+}
+
+inline float UU::Sum(CSpan<const float> values, ESummation summation)
+{
+	return static_cast<float>(Detail::Accumulate<Detail::EReduceTerm::Value>(values.Data(), values.Data(), 1.0, values.Size(), summation));
+}
+
+inline double UU::Sum(CSpan<const double> values, ESummation summation)
+{
+	return Detail::Accumulate<Detail::EReduceTerm::Value>(values.Data(), values.Data(), 1.0, values.Size(), summation);
+}
+
+inline float UU::Dot(CSpan<const float> a, CSpan<const float> b, ESummation summation)
+{
+	return static_cast<float>(Detail::Accumulate<Detail::EReduceTerm::Product>(a.Data(), b.Data(), 1.0, a.Size(), summation));
+}
+
+inline double UU::Dot(CSpan<const double> a, CSpan<const double> b, ESummation summation)
+{
+	return Detail::Accumulate<Detail::EReduceTerm::Product>(a.Data(), b.Data(), 1.0, a.Size(), summation);
+}
+
+inline void UU::Clamp(CSpan<const float> in, float min, float max, CSpan<float> out)
+{
+	using V = CSimdNative<float>;
+
+	// Max returns its second operand for NaN lanes, which keeps NaN inputs in place.
+	Detail::SimdTransform(in, out, [min, max](const V & x) { return Min(V(max), Max(V(min), x)); });
+}
+
+inline void UU::Clamp(CSpan<const double> in, double min, double max, CSpan<double> out)
+{
+	using V = CSimdNative<double>;
+
+	Detail::SimdTransform(in, out, [min, max](const V & x) { return Min(V(max), Max(V(min), x)); });
+}
+
+inline void UU::Lerp(CSpan<const float> a, CSpan<const float> b, float factor, CSpan<float> out)
+{
+	using V = CSimdNative<float>;
+
+	Detail::SimdTransform(a, b, out, [factor](const V & x, const V & y) { return MulAdd(y - x, V(factor), x); });
+}
+
+inline void UU::Lerp(CSpan<const double> a, CSpan<const double> b, double factor, CSpan<double> out)
+{
+	using V = CSimdNative<double>;
+
+	Detail::SimdTransform(a, b, out, [factor](const V & x, const V & y) { return MulAdd(y - x, V(factor), x); });
+}
+
+inline void UU::RoundToInt(CSpan<const float> in, CSpan<int32_t> out, ERounding rounding)
+{
+	Detail::ParallelRoundToInt(in, out, rounding);
+}
+
+inline void UU::RoundToInt(CSpan<const double> in, CSpan<int32_t> out, ERounding rounding)
+{
+	Detail::ParallelRoundToInt(in, out, rounding);
+}
+
+inline void UU::ToFloat(CSpan<const int32_t> in, CSpan<float> out)
+{
+	ParallelFor(in.Size(), MATH_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			out[i] = static_cast<float>(in[i]);
+	});
+}
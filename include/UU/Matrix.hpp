@@ -5,6 +5,7 @@
 #endif
 
 #include <array>
+#include "TableMath.hpp"
 inline int nextval = 0;
 
 namespace UU
@@ -67,6 +68,10 @@ namespace UU
 		CMatrix<T, rows, columns>						Transpose() const;
 		void											TransposeInPlace();
 
+		// Gram-Schmidt on the rows, normalised with TMath::InvSqrt. Rows must be linearly independent.
+		template<typename TMath = CDefaultMath>
+		CMatrix											Orthonormalized() const;
+
 		void											Negate();
 		bool											IsZero() const;
 
@@ -405,6 +410,44 @@ void UU::CMatrix<T, rows, columns>::TransposeInPlace()
 			data[i][j] = data[j][i];
 }
 
+template<typename T, size_t rows, size_t columns>
+template<typename TMath>
+UU::CMatrix<T, rows, columns> UU::CMatrix<T, rows, columns>::Orthonormalized() const
+{
+	static_assert(rows <= columns);
+
+	CMatrix temp;
+
+	temp = *this;
+
+	for (size_t i = 0; i < rows; ++i)
+	{
+		// Modified Gram-Schmidt, projecting out each finished row from the running remainder.
+		for (size_t k = 0; k < i; ++k)
+		{
+			T dot = T();
+
+			for (size_t j = 0; j < columns; ++j)
+				dot += temp.data[i][j] * temp.data[k][j];
+
+			for (size_t j = 0; j < columns; ++j)
+				temp.data[i][j] -= dot * temp.data[k][j];
+		}
+
+		T len_sqr = T();
+
+		for (size_t j = 0; j < columns; ++j)
+			len_sqr += temp.data[i][j] * temp.data[i][j];
+
+		const T inv_len = TMath::InvSqrt(len_sqr);
+
+		for (size_t j = 0; j < columns; ++j)
+			temp.data[i][j] *= inv_len;
+	}
+
+	return temp;
+}
+
 template <typename T, size_t rows, size_t columns>
 void UU::CMatrix<T, rows, columns>::Negate()
 {
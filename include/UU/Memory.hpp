@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include <cstddef>
+#include <new>
+
+namespace UU
+{
+	constexpr size_t CACHE_LINE_SIZE = 64;
+
+	template <typename T, size_t alignment = CACHE_LINE_SIZE>
+	class CAlignedAllocator
+	{
+	public:
+		using value_type = T;
+
+		template <typename U>
+		struct rebind
+		{
+			using other = CAlignedAllocator<U, alignment>;
+		};
+
+		CAlignedAllocator() noexcept = default;
+
+		template <typename U>
+		CAlignedAllocator(const CAlignedAllocator<U, alignment> &) noexcept {}
+
+		T *				allocate(size_t n);
+		void			deallocate(T * ptr, size_t n) noexcept;
+
+		template <typename U>
+		bool			operator==(const CAlignedAllocator<U, alignment> &) const noexcept { return true; }
+
+		template <typename U>
+		bool			operator!=(const CAlignedAllocator<U, alignment> &) const noexcept { return false; }
+	};
+}
+
+template <typename T, size_t alignment>
+T * UU::CAlignedAllocator<T, alignment>::allocate(size_t n)
+{
+	constexpr size_t align = alignment > alignof(T) ? alignment : alignof(T);
+
+	return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(align)));
+}
+
+template <typename T, size_t alignment>
+void UU::CAlignedAllocator<T, alignment>::deallocate(T * ptr, size_t) noexcept
+{
+	constexpr size_t align = alignment > alignof(T) ? alignment : alignof(T);
+
+	::operator delete(ptr, std::align_val_t(align));
+}
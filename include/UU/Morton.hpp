@@ -0,0 +1,389 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Math.hpp"
+#include "Parallel.hpp"
+#include "Reduce.hpp"
+#include "Simd.hpp"
+#include "Span.hpp"
+#include "VectorView.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#if defined(UU_BMI2) && (defined(_M_X64) || defined(__x86_64__))
+	#define UU_MORTON_PDEP 1
+#endif
+
+namespace UU
+{
+	// 2D codes interleave 32 bits per axis, 3D codes 21 bits per axis. x lands in the lowest bit.
+	constexpr size_t MORTON_BITS_2D = 32;
+	constexpr size_t MORTON_BITS_3D = 21;
+
+	constexpr size_t RADIX_SORT_GRAIN = 1 << 16;
+	constexpr size_t RADIX_SORT_BUCKETS = 256;
+
+	uint64_t MortonSpread2(uint64_t val);
+	uint64_t MortonCompact2(uint64_t code);
+	uint64_t MortonSpread3(uint64_t val);
+	uint64_t MortonCompact3(uint64_t code);
+
+	// Components are taken as unsigned; negative values should be biased first.
+	template <typename T>
+	uint64_t MortonEncode(const CVector<T, 2> & v);
+
+	template <typename T>
+	uint64_t MortonEncode(const CVector<T, 3> & v);
+
+	// Quantises a floating point vector into the [min, max] box before interleaving.
+	template <typename T, size_t size>
+	uint64_t MortonEncode(const CVector<T, size> & v, const CVector<T, size> & min, const CVector<T, size> & max);
+
+	template <typename T = int>
+	CVector<T, 2> MortonDecode2(uint64_t code);
+
+	template <typename T = int>
+	CVector<T, 3> MortonDecode3(uint64_t code);
+
+	// Returns the lower corner of the quantisation cell the code refers to.
+	template <typename T, size_t size>
+	CVector<T, size> MortonDecode(uint64_t code, const CVector<T, size> & min, const CVector<T, size> & max);
+
+	// Stable LSD radix sort on 8-bit digits. values, if not empty, is permuted along with keys.
+	// Digits that are identical across every key are skipped, so 3D Morton keys never pay for
+	// their unused top bit. Large inputs are histogrammed and scattered on all hardware threads.
+	void RadixSort(CSpan<uint64_t> keys, CSpan<uint32_t> values);
+
+	// Reorders points along a Z-order curve over their bounding box. If permutation is given it
+	// receives, for every output slot, the index the point had in the input.
+	template <typename T, size_t size>
+	void SortByMorton(CVectorView<T, size> points, std::vector<uint32_t> * permutation = nullptr);
+
+	// CSpans and std::vectors of CVectors forward to the view form.
+	template <typename TPoints, typename V = TViewOf<TPoints>>
+	void SortByMorton(TPoints && points, std::vector<uint32_t> * permutation = nullptr);
+}
+
+inline uint64_t UU::MortonSpread2(uint64_t val)
+{
+#if defined(UU_MORTON_PDEP)
+	return _pdep_u64(val, 0x5555555555555555ull);
+#else
+	val &= 0x00000000FFFFFFFFull;
+	val = (val | (val << 16)) & 0x0000FFFF0000FFFFull;
+	val = (val | (val << 8)) & 0x00FF00FF00FF00FFull;
+	val = (val | (val << 4)) & 0x0F0F0F0F0F0F0F0Full;
+	val = (val | (val << 2)) & 0x3333333333333333ull;
+	val = (val | (val << 1)) & 0x5555555555555555ull;
+
+	return val;
+#endif
+}
+
+inline uint64_t UU::MortonCompact2(uint64_t code)
+{
+#if defined(UU_MORTON_PDEP)
+	return _pext_u64(code, 0x5555555555555555ull);
+#else
+	code &= 0x5555555555555555ull;
+	code = (code | (code >> 1)) & 0x3333333333333333ull;
+	code = (code | (code >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+	code = (code | (code >> 4)) & 0x00FF00FF00FF00FFull;
+	code = (code | (code >> 8)) & 0x0000FFFF0000FFFFull;
+	code = (code | (code >> 16)) & 0x00000000FFFFFFFFull;
+
+	return code;
+#endif
+}
+
+inline uint64_t UU::MortonSpread3(uint64_t val)
+{
+#if defined(UU_MORTON_PDEP)
+	return _pdep_u64(val, 0x1249249249249249ull);
+#else
+	val &= 0x1FFFFFull;
+	val = (val | (val << 32)) & 0x001F00000000FFFFull;
+	val = (val | (val << 16)) & 0x001F0000FF0000FFull;
+	val = (val | (val << 8)) & 0x100F00F00F00F00Full;
+	val = (val | (val << 4)) & 0x10C30C30C30C30C3ull;
+	val = (val | (val << 2)) & 0x1249249249249249ull;
+
+	return val;
+#endif
+}
+
+inline uint64_t UU::MortonCompact3(uint64_t code)
+{
+#if defined(UU_MORTON_PDEP)
+	return _pext_u64(code, 0x1249249249249249ull);
+#else
+	code &= 0x1249249249249249ull;
+	code = (code | (code >> 2)) & 0x10C30C30C30C30C3ull;
+	code = (code | (code >> 4)) & 0x100F00F00F00F00Full;
+	code = (code | (code >> 8)) & 0x001F0000FF0000FFull;
+	code = (code | (code >> 16)) & 0x001F00000000FFFFull;
+	code = (code | (code >> 32)) & 0x1FFFFFull;
+
+	return code;
+#endif
+}
+
+template <typename T>
+uint64_t UU::MortonEncode(const CVector<T, 2> & v)
+{
+	static_assert(std::is_integral<T>::value, "Quantise floating point vectors with the min/max overload");
+
+	return MortonSpread2(static_cast<uint32_t>(v[0])) | (MortonSpread2(static_cast<uint32_t>(v[1])) << 1);
+}
+
+template <typename T>
+uint64_t UU::MortonEncode(const CVector<T, 3> & v)
+{
+	static_assert(std::is_integral<T>::value, "Quantise floating point vectors with the min/max overload");
+
+	return MortonSpread3(static_cast<uint32_t>(v[0]))
+		| (MortonSpread3(static_cast<uint32_t>(v[1])) << 1)
+		| (MortonSpread3(static_cast<uint32_t>(v[2])) << 2);
+}
+
+template <typename T, size_t size>
+uint64_t UU::MortonEncode(const CVector<T, size> & v, const CVector<T, size> & min, const CVector<T, size> & max)
+{
+	static_assert(size == 2 || size == 3, "Morton codes are only defined for 2 and 3 dimensions");
+
+	constexpr size_t bits = size == 2 ? MORTON_BITS_2D : MORTON_BITS_3D;
+	constexpr double cells = static_cast<double>(1ull << bits);
+
+	uint64_t q[size];
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		const double extent = static_cast<double>(max[i]) - static_cast<double>(min[i]);
+		const double t = extent > 0.0 ? (static_cast<double>(v[i]) - static_cast<double>(min[i])) / extent : 0.0;
+
+		q[i] = static_cast<uint64_t>(Clamp(t * cells, 0.0, cells - 1.0));
+	}
+
+	if constexpr (size == 2)
+		return MortonSpread2(q[0]) | (MortonSpread2(q[1]) << 1);
+	else
+		return MortonSpread3(q[0]) | (MortonSpread3(q[1]) << 1) | (MortonSpread3(q[2]) << 2);
+}
+
+template <typename T>
+UU::CVector<T, 2> UU::MortonDecode2(uint64_t code)
+{
+	return CVector<T, 2>(static_cast<T>(MortonCompact2(code)), static_cast<T>(MortonCompact2(code >> 1)));
+}
+
+template <typename T>
+UU::CVector<T, 3> UU::MortonDecode3(uint64_t code)
+{
+	return CVector<T, 3>(static_cast<T>(MortonCompact3(code)),
+		static_cast<T>(MortonCompact3(code >> 1)),
+		static_cast<T>(MortonCompact3(code >> 2)));
+}
+
+template <typename T, size_t size>
+UU::CVector<T, size> UU::MortonDecode(uint64_t code, const CVector<T, size> & min, const CVector<T, size> & max)
+{
+	static_assert(size == 2 || size == 3, "Morton codes are only defined for 2 and 3 dimensions");
+
+	constexpr size_t bits = size == 2 ? MORTON_BITS_2D : MORTON_BITS_3D;
+	constexpr double inv_cells = 1.0 / static_cast<double>(1ull << bits);
+
+	CVector<T, size> temp;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		const uint64_t q = size == 2 ? MortonCompact2(code >> i) : MortonCompact3(code >> i);
+		const double extent = static_cast<double>(max[i]) - static_cast<double>(min[i]);
+
+		temp[i] = static_cast<T>(static_cast<double>(min[i]) + extent * static_cast<double>(q) * inv_cells);
+	}
+
+	return temp;
+}
+
+inline void UU::RadixSort(CSpan<uint64_t> keys, CSpan<uint32_t> values)
+{
+	const size_t count = keys.Size();
+	const bool has_values = !values.Empty();
+
+	if (count < 2)
+		return;
+
+	const size_t chunks = ParallelChunkCount(count, RADIX_SORT_GRAIN);
+
+	std::vector<uint64_t> key_buffer(count);
+	std::vector<uint32_t> value_buffer(has_values ? count : 0);
+	std::vector<size_t> histogram(chunks * RADIX_SORT_BUCKETS);
+
+	uint64_t * src_keys = keys.Data();
+	uint64_t * dst_keys = key_buffer.data();
+	uint32_t * src_values = values.Data();
+	uint32_t * dst_values = value_buffer.data();
+
+	// A digit position only needs a pass if some key differs from the first one there.
+	uint64_t varying = 0;
+
+	for (size_t i = 1; i < count; ++i)
+		varying |= src_keys[i] ^ src_keys[0];
+
+	for (size_t shift = 0; shift < 64; shift += 8)
+	{
+		if (((varying >> shift) & 0xFF) == 0)
+			continue;
+
+		ParallelFor(count, RADIX_SORT_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+		{
+			size_t * h = &histogram[chunk * RADIX_SORT_BUCKETS];
+
+			for (size_t d = 0; d < RADIX_SORT_BUCKETS; ++d)
+				h[d] = 0;
+
+			for (size_t i = begin; i < end; ++i)
+				++h[(src_keys[i] >> shift) & 0xFF];
+		});
+
+		// Exclusive prefix over (digit, chunk) so each chunk scatters into its own stable slots.
+		size_t offset = 0;
+
+		for (size_t d = 0; d < RADIX_SORT_BUCKETS; ++d)
+			for (size_t c = 0; c < chunks; ++c)
+			{
+				const size_t n = histogram[c * RADIX_SORT_BUCKETS + d];
+
+				histogram[c * RADIX_SORT_BUCKETS + d] = offset;
+				offset += n;
+			}
+
+		ParallelFor(count, RADIX_SORT_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+		{
+			size_t * h = &histogram[chunk * RADIX_SORT_BUCKETS];
+
+			if (has_values)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const size_t dst = h[(src_keys[i] >> shift) & 0xFF]++;
+
+					dst_keys[dst] = src_keys[i];
+					dst_values[dst] = src_values[i];
+				}
+			}
+			else
+			{
+				for (size_t i = begin; i < end; ++i)
+					dst_keys[h[(src_keys[i] >> shift) & 0xFF]++] = src_keys[i];
+			}
+		});
+
+		std::swap(src_keys, dst_keys);
+		std::swap(src_values, dst_values);
+	}
+
+	if (src_keys != keys.Data())
+	{
+		ParallelFor(count, RADIX_SORT_GRAIN, [&](size_t, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				keys[i] = src_keys[i];
+
+				if (has_values)
+					values[i] = src_values[i];
+			}
+		});
+	}
+}
+
+template <typename T, size_t size>
+void UU::SortByMorton(CVectorView<T, size> points, std::vector<uint32_t> * permutation)
+{
+	static_assert(size == 2 || size == 3, "Morton codes are only defined for 2 and 3 dimensions");
+
+	const size_t count = points.Size();
+
+	if (count == 0)
+	{
+		if (permutation)
+			permutation->clear();
+
+		return;
+	}
+
+	const CAABox<T, size> bounds = Bounds(CVectorView<const T, size>(points));
+	const CVector<T, size> & min = bounds.min;
+	const CVector<T, size> & max = bounds.max;
+
+	// Integer points are biased to the minimum corner and, if the extent does not fit the code,
+	// shifted down so the curve still covers the whole box.
+	constexpr size_t bits = size == 2 ? MORTON_BITS_2D : MORTON_BITS_3D;
+	size_t shift = 0;
+
+	if constexpr (std::is_integral<T>::value)
+	{
+		for (size_t k = 0; k < size; ++k)
+		{
+			const auto extent = static_cast<uint64_t>(static_cast<int64_t>(max[k]) - static_cast<int64_t>(min[k]));
+
+			while ((extent >> shift) >= (1ull << bits))
+				++shift;
+		}
+	}
+
+	std::vector<uint64_t> keys(count);
+	std::vector<uint32_t> order(count);
+
+	ParallelFor(count, RADIX_SORT_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			if constexpr (std::is_integral<T>::value)
+			{
+				CVector<uint32_t, size> biased;
+
+				for (size_t k = 0; k < size; ++k)
+					biased[k] = static_cast<uint32_t>((static_cast<int64_t>(points[i][k]) - static_cast<int64_t>(min[k])) >> shift);
+
+				keys[i] = MortonEncode(biased);
+			}
+			else
+			{
+				keys[i] = MortonEncode(points[i], min, max);
+			}
+
+			order[i] = static_cast<uint32_t>(i);
+		}
+	});
+
+	RadixSort(keys, order);
+
+	std::vector<CVector<T, size>> sorted(count);
+
+	ParallelFor(count, RADIX_SORT_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			sorted[i] = points[order[i]];
+	});
+
+	ParallelFor(count, RADIX_SORT_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			points[i] = sorted[i];
+	});
+
+	if (permutation)
+		*permutation = std::move(order);
+}
+
+template <typename TPoints, typename V>
+void UU::SortByMorton(TPoints && points, std::vector<uint32_t> * permutation)
+{
+	SortByMorton(V(points), permutation);
+}
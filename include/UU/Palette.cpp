@@ -0,0 +1,593 @@
+#include "../UU.hpp"
+#include "Palette.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using UU::CColour;
+	using UU::CSpan;
+
+	constexpr size_t CELL_SHIFT = 8 - UU::PALETTE_LOOKUP_BITS;
+	constexpr size_t CELL_LEVELS = size_t(1) << UU::PALETTE_LOOKUP_BITS;
+	constexpr size_t CELL_COUNT = CELL_LEVELS * CELL_LEVELS * CELL_LEVELS;
+
+	size_t Cell(CColour col)
+	{
+		return (size_t(col.r >> CELL_SHIFT) << (2 * UU::PALETTE_LOOKUP_BITS)) | (size_t(col.g >> CELL_SHIFT) << UU::PALETTE_LOOKUP_BITS) | size_t(col.b >> CELL_SHIFT);
+	}
+
+	// Count and channel sums of the pixels falling in one histogram cell.
+	class CBin final
+	{
+	public:
+
+		uint64_t		count = 0, r = 0, g = 0, b = 0;
+	};
+
+	// A histogram cell reduced to its mean colour, weighted by its pixel count.
+	class CEntry final
+	{
+	public:
+
+		float			c[3];
+		float			weight;
+	};
+
+	// A median cut box over entries [begin, end), split next along its longest axis.
+	class CBox final
+	{
+	public:
+
+		size_t			begin, end;
+		size_t			axis;
+		float			score;
+	};
+
+	// The palette in planes padded to whole registers with entries no query can be nearest to.
+	class CPalettePlanes final
+	{
+	private:
+
+		using V = UU::CSimdNative<float>;
+
+		std::vector<float, UU::CAlignedAllocator<float>>	r, g, b;
+		size_t												size;
+
+	public:
+
+		explicit CPalettePlanes(CSpan<const CColour> colours)
+			: size(colours.Size())
+		{
+			const size_t padded = (size + V::LANES - 1) / V::LANES * V::LANES;
+
+			r.assign(padded, 1e9f);
+			g.assign(padded, 1e9f);
+			b.assign(padded, 1e9f);
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				r[i] = colours[i].r;
+				g[i] = colours[i].g;
+				b[i] = colours[i].b;
+			}
+		}
+
+		// The first entry at the smallest squared distance, the same choice as a scalar scan.
+		size_t Nearest(float x, float y, float z) const
+		{
+			alignas(64) float lane_index[V::LANES], best_distance[V::LANES], best_index[V::LANES];
+
+			for (size_t j = 0; j < V::LANES; ++j)
+				lane_index[j] = static_cast<float>(j);
+
+			const V vx(x), vy(y), vz(z), step(static_cast<float>(V::LANES));
+			V best(FLT_MAX), best_i(0.f), index = V::Load(lane_index);
+
+			for (size_t i = 0; i < r.size(); i += V::LANES)
+			{
+				const V dr = V::Load(&r[i]) - vx;
+				const V dg = V::Load(&g[i]) - vy;
+				const V db = V::Load(&b[i]) - vz;
+				const V d = dr * dr + dg * dg + db * db;
+				const auto closer = d < best;
+
+				best = Select(closer, d, best);
+				best_i = Select(closer, index, best_i);
+				index = index + step;
+			}
+
+			best.Store(best_distance);
+			best_i.Store(best_index);
+
+			size_t nearest = static_cast<size_t>(best_index[0]);
+			float distance = best_distance[0];
+
+			for (size_t j = 1; j < V::LANES; ++j)
+			{
+				const auto i = static_cast<size_t>(best_index[j]);
+
+				if (best_distance[j] < distance || (best_distance[j] == distance && i < nearest))
+				{
+					nearest = i;
+					distance = best_distance[j];
+				}
+			}
+
+			return nearest;
+		}
+	};
+
+	// Per-thread private histograms over [0, count), merged into the first.
+	template <typename Fn>
+	std::vector<CBin> Histogram(size_t count, size_t grain, Fn && fn)
+	{
+		const size_t chunks = UU::ParallelChunkCount(count, grain);
+
+		std::vector<std::vector<CBin>> parts(chunks > 0 ? chunks : 1);
+
+		UU::ParallelFor(count, grain, [&](size_t chunk, size_t begin, size_t end)
+		{
+			parts[chunk].resize(CELL_COUNT);
+			fn(begin, end, parts[chunk].data());
+		});
+
+		parts[0].resize(CELL_COUNT);
+
+		for (size_t i = 1; i < parts.size(); ++i)
+		{
+			for (size_t cell = 0; cell < CELL_COUNT; ++cell)
+			{
+				parts[0][cell].count += parts[i][cell].count;
+				parts[0][cell].r += parts[i][cell].r;
+				parts[0][cell].g += parts[i][cell].g;
+				parts[0][cell].b += parts[i][cell].b;
+			}
+		}
+
+		return std::move(parts[0]);
+	}
+
+	void Count(CBin * bins, CColour col)
+	{
+		CBin & bin = bins[Cell(col)];
+
+		++bin.count;
+		bin.r += col.r;
+		bin.g += col.g;
+		bin.b += col.b;
+	}
+
+	CBox MakeBox(const std::vector<CEntry> & entries, size_t begin, size_t end)
+	{
+		float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		float weight = 0.f;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			for (size_t k = 0; k < 3; ++k)
+			{
+				min[k] = std::min(min[k], entries[i].c[k]);
+				max[k] = std::max(max[k], entries[i].c[k]);
+			}
+
+			weight += entries[i].weight;
+		}
+
+		size_t axis = 0;
+
+		for (size_t k = 1; k < 3; ++k)
+			if (max[k] - min[k] > max[axis] - min[axis])
+				axis = k;
+
+		// Population times extent, so both crowded and widely spread boxes get split.
+		const float score = end - begin > 1 ? weight * (max[axis] - min[axis]) : 0.f;
+
+		return CBox{ begin, end, axis, score };
+	}
+
+	CColour MeanColour(const std::vector<CEntry> & entries, size_t begin, size_t end)
+	{
+		double sum[3] = { 0, 0, 0 }, weight = 0;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			for (size_t k = 0; k < 3; ++k)
+				sum[k] += double(entries[i].c[k]) * entries[i].weight;
+
+			weight += entries[i].weight;
+		}
+
+		return CColour(
+			static_cast<uint8_t>(std::lround(sum[0] / weight)),
+			static_cast<uint8_t>(std::lround(sum[1] / weight)),
+			static_cast<uint8_t>(std::lround(sum[2] / weight)));
+	}
+
+	std::vector<CColour> MedianCut(std::vector<CEntry> & entries, size_t size)
+	{
+		std::vector<CBox> boxes;
+
+		if (entries.empty())
+			return {};
+
+		boxes.push_back(MakeBox(entries, 0, entries.size()));
+
+		while (boxes.size() < size)
+		{
+			const auto largest = std::max_element(boxes.begin(), boxes.end(), [](const CBox & a, const CBox & b) { return a.score < b.score; });
+
+			if (largest->score <= 0.f)
+				break;
+
+			const CBox box = *largest;
+			const size_t axis = box.axis;
+
+			std::sort(entries.begin() + box.begin, entries.begin() + box.end, [axis](const CEntry & a, const CEntry & b) { return a.c[axis] < b.c[axis]; });
+
+			float total = 0.f;
+
+			for (size_t i = box.begin; i < box.end; ++i)
+				total += entries[i].weight;
+
+			// Split at the weighted median, keeping at least one entry on each side.
+			size_t split = box.begin + 1;
+			float below = entries[box.begin].weight;
+
+			while (split < box.end - 1 && below + entries[split].weight <= total / 2)
+				below += entries[split++].weight;
+
+			*largest = MakeBox(entries, box.begin, split);
+			boxes.push_back(MakeBox(entries, split, box.end));
+		}
+
+		std::vector<CColour> colours;
+		colours.reserve(boxes.size());
+
+		for (const CBox & box : boxes)
+			colours.push_back(MeanColour(entries, box.begin, box.end));
+
+		return colours;
+	}
+
+	// Lloyd iterations with histogram cells as weighted points; entries left without points keep their colour.
+	void Refine(const std::vector<CEntry> & entries, std::vector<CColour> & colours, size_t iterations)
+	{
+		using CSum = std::vector<double>;
+
+		for (size_t iteration = 0; iteration < iterations; ++iteration)
+		{
+			const CPalettePlanes planes(CSpan<const CColour>(colours.data(), colours.size()));
+			const size_t grain = UU::PALETTE_PARALLEL_GRAIN / 16;
+			const size_t chunks = UU::ParallelChunkCount(entries.size(), grain);
+
+			std::vector<CSum> parts(chunks > 0 ? chunks : 1, CSum(colours.size() * 4, 0.0));
+
+			UU::ParallelFor(entries.size(), grain, [&](size_t chunk, size_t begin, size_t end)
+			{
+				double * sums = parts[chunk].data();
+
+				for (size_t i = begin; i < end; ++i)
+				{
+					const CEntry & e = entries[i];
+					double * sum = sums + 4 * planes.Nearest(e.c[0], e.c[1], e.c[2]);
+
+					sum[0] += double(e.c[0]) * e.weight;
+					sum[1] += double(e.c[1]) * e.weight;
+					sum[2] += double(e.c[2]) * e.weight;
+					sum[3] += e.weight;
+				}
+			});
+
+			for (size_t i = 1; i < parts.size(); ++i)
+				for (size_t j = 0; j < parts[0].size(); ++j)
+					parts[0][j] += parts[i][j];
+
+			for (size_t i = 0; i < colours.size(); ++i)
+			{
+				const double * sum = parts[0].data() + 4 * i;
+
+				if (sum[3] > 0)
+					colours[i] = CColour(
+						static_cast<uint8_t>(std::lround(sum[0] / sum[3])),
+						static_cast<uint8_t>(std::lround(sum[1] / sum[3])),
+						static_cast<uint8_t>(std::lround(sum[2] / sum[3])));
+			}
+		}
+	}
+
+	std::vector<CColour> FromHistogram(const std::vector<CBin> & bins, size_t size, size_t refinements)
+	{
+		std::vector<CEntry> entries;
+
+		for (const CBin & bin : bins)
+		{
+			if (bin.count == 0)
+				continue;
+
+			const auto n = static_cast<double>(bin.count);
+
+			entries.push_back(CEntry{ { float(bin.r / n), float(bin.g / n), float(bin.b / n) }, float(n) });
+		}
+
+		std::vector<CColour> colours = MedianCut(entries, std::min(size, UU::PALETTE_MAX_SIZE));
+
+		Refine(entries, colours, refinements);
+
+		return colours;
+	}
+
+	constexpr uint8_t BAYER_8X8[8][8] =
+	{
+		{  0, 32,  8, 40,  2, 34, 10, 42 },
+		{ 48, 16, 56, 24, 50, 18, 58, 26 },
+		{ 12, 44,  4, 36, 14, 46,  6, 38 },
+		{ 60, 28, 52, 20, 62, 30, 54, 22 },
+		{  3, 35, 11, 43,  1, 33,  9, 41 },
+		{ 51, 19, 59, 27, 49, 17, 57, 25 },
+		{ 15, 47,  7, 39, 13, 45,  5, 37 },
+		{ 63, 31, 55, 23, 61, 29, 53, 21 }
+	};
+
+	uint8_t ClampChannel(int32_t c)
+	{
+		return static_cast<uint8_t>(c < 0 ? 0 : c > 255 ? 255 : c);
+	}
+}
+
+// CPalette - Function Definitions
+
+UU::CPalette::CPalette(CSpan<const CColour> palette)
+{
+	Build(palette);
+}
+
+void UU::CPalette::Build(CSpan<const CColour> palette)
+{
+	colours.assign(palette.begin(), palette.begin() + std::min(palette.Size(), PALETTE_MAX_SIZE));
+	lookup.clear();
+
+	if (colours.empty())
+		return;
+
+	const CPalettePlanes planes(Colours());
+
+	lookup.resize(CELL_COUNT);
+
+	ParallelFor(CELL_COUNT, PALETTE_PARALLEL_GRAIN / 16, [&](size_t, size_t begin, size_t end)
+	{
+		// Cell levels 8k to 8k + 7 centre on 8k + 3.5.
+		constexpr float half = float(size_t(1) << CELL_SHIFT) / 2 - 0.5f;
+
+		for (size_t cell = begin; cell < end; ++cell)
+		{
+			const float r = float((cell >> (2 * PALETTE_LOOKUP_BITS)) << CELL_SHIFT) + half;
+			const float g = float(((cell >> PALETTE_LOOKUP_BITS) & (CELL_LEVELS - 1)) << CELL_SHIFT) + half;
+			const float b = float((cell & (CELL_LEVELS - 1)) << CELL_SHIFT) + half;
+
+			lookup[cell] = static_cast<uint8_t>(planes.Nearest(r, g, b));
+		}
+	});
+}
+
+void UU::CPalette::Generate(CSpan<const CColour> pixels, size_t size, size_t refinements)
+{
+	const auto bins = Histogram(pixels.Size(), PALETTE_PARALLEL_GRAIN, [&](size_t begin, size_t end, CBin * bins)
+	{
+		for (size_t i = begin; i < end; ++i)
+			Count(bins, pixels[i]);
+	});
+
+	const auto palette = FromHistogram(bins, size, refinements);
+
+	Build(CSpan<const CColour>(palette.data(), palette.size()));
+}
+
+void UU::CPalette::Generate(CImageView<const CColour> image, size_t size, size_t refinements)
+{
+	if (image.IsContiguous())
+	{
+		Generate(image.Pixels(), size, refinements);
+		return;
+	}
+
+	const size_t grain = image.Width() > 0 ? (PALETTE_PARALLEL_GRAIN + image.Width() - 1) / image.Width() : 1;
+
+	const auto bins = Histogram(image.Height(), grain, [&](size_t begin, size_t end, CBin * bins)
+	{
+		for (size_t y = begin; y < end; ++y)
+		{
+			const CColour * row = image.Row(y);
+
+			for (size_t x = 0; x < image.Width(); ++x)
+				Count(bins, row[x]);
+		}
+	});
+
+	const auto palette = FromHistogram(bins, size, refinements);
+
+	Build(CSpan<const CColour>(palette.data(), palette.size()));
+}
+
+void UU::CPalette::Clear()
+{
+	colours.clear();
+	lookup.clear();
+}
+
+uint8_t UU::CPalette::Nearest(CColour col) const
+{
+	if (lookup.empty())
+		return 0;
+
+	return lookup[Cell(col)];
+}
+
+uint8_t UU::CPalette::NearestExact(CColour col) const
+{
+	size_t nearest = 0;
+	int32_t distance = INT32_MAX;
+
+	for (size_t i = 0; i < colours.size(); ++i)
+	{
+		const int32_t dr = int32_t(colours[i].r) - col.r;
+		const int32_t dg = int32_t(colours[i].g) - col.g;
+		const int32_t db = int32_t(colours[i].b) - col.b;
+		const int32_t d = dr * dr + dg * dg + db * db;
+
+		if (d < distance)
+		{
+			nearest = i;
+			distance = d;
+		}
+	}
+
+	return static_cast<uint8_t>(nearest);
+}
+
+const UU::CColour & UU::CPalette::operator[](size_t i) const
+{
+	return colours[i];
+}
+
+UU::CSpan<const UU::CColour> UU::CPalette::Colours() const
+{
+	return CSpan<const CColour>(colours.data(), colours.size());
+}
+
+size_t UU::CPalette::Size() const
+{
+	return colours.size();
+}
+
+bool UU::CPalette::Empty() const
+{
+	return colours.empty();
+}
+
+// Quantisation
+
+void UU::Quantise(CImageView<const CColour> in, const CPalette & palette, CImageView<uint8_t> out, EDither dither)
+{
+	if (palette.Empty())
+	{
+		ParallelForRows(out, [&](size_t, CSpan<uint8_t> row) { std::fill(row.begin(), row.end(), uint8_t(0)); });
+		return;
+	}
+
+	switch (dither)
+	{
+	case EDither::None:
+	{
+		ParallelForRows(out, [&](size_t y, CSpan<uint8_t> row)
+		{
+			const CColour * src = in.Row(y);
+
+			for (size_t x = 0; x < row.Size(); ++x)
+				row[x] = palette.Nearest(src[x]);
+		});
+
+		break;
+	}
+	case EDither::Ordered:
+	{
+		// Offsets spanning about one palette step, taking the entries as spread evenly over the colour cube.
+		const auto spread = static_cast<int32_t>(255.0 / std::cbrt(static_cast<double>(palette.Size())));
+
+		int32_t offsets[8][8];
+
+		for (size_t y = 0; y < 8; ++y)
+			for (size_t x = 0; x < 8; ++x)
+				offsets[y][x] = (2 * BAYER_8X8[y][x] + 1 - 64) * spread / 128;
+
+		ParallelForRows(out, [&](size_t y, CSpan<uint8_t> row)
+		{
+			const CColour * src = in.Row(y);
+			const int32_t * offset = offsets[y & 7];
+
+			for (size_t x = 0; x < row.Size(); ++x)
+			{
+				const int32_t o = offset[x & 7];
+
+				row[x] = palette.Nearest(CColour(ClampChannel(src[x].r + o), ClampChannel(src[x].g + o), ClampChannel(src[x].b + o)));
+			}
+		});
+
+		break;
+	}
+	case EDither::FloydSteinberg:
+	{
+		const size_t width = in.Width();
+		const size_t grain = width > 0 ? (PALETTE_PARALLEL_GRAIN + width - 1) / width : 1;
+
+		ParallelFor(in.Height(), grain, [&](size_t, size_t begin, size_t end)
+		{
+			// Errors from the row above and for the row below in sixteenths, with a pixel of padding on either side.
+			const size_t padded = 3 * (width + 2);
+
+			std::vector<int32_t> errors(2 * padded, 0);
+			int32_t * current = errors.data();
+			int32_t * next = current + padded;
+
+			for (size_t y = begin; y < end; ++y)
+			{
+				const CColour * src = in.Row(y);
+				uint8_t * dst = out.Row(y);
+				const bool reverse = ((y - begin) & 1) != 0;
+				const ptrdiff_t forward = reverse ? -3 : 3;
+
+				std::fill(next, next + padded, 0);
+
+				// Error pushed to the following pixel of the row, carried rather than stored.
+				int32_t carry_r = 0, carry_g = 0, carry_b = 0;
+
+				for (size_t i = 0; i < width; ++i)
+				{
+					const size_t x = reverse ? width - 1 - i : i;
+					const ptrdiff_t at = 3 * ptrdiff_t(x + 1);
+
+					const CColour want(
+						ClampChannel(src[x].r + ((current[at] + carry_r + 8) >> 4)),
+						ClampChannel(src[x].g + ((current[at + 1] + carry_g + 8) >> 4)),
+						ClampChannel(src[x].b + ((current[at + 2] + carry_b + 8) >> 4)));
+
+					const uint8_t index = palette.Nearest(want);
+					const CColour & chosen = palette[index];
+
+					dst[x] = index;
+
+					const int32_t er = int32_t(want.r) - chosen.r;
+					const int32_t eg = int32_t(want.g) - chosen.g;
+					const int32_t eb = int32_t(want.b) - chosen.b;
+
+					carry_r = 7 * er;
+					carry_g = 7 * eg;
+					carry_b = 7 * eb;
+
+					next[at - forward] += 3 * er;
+					next[at - forward + 1] += 3 * eg;
+					next[at - forward + 2] += 3 * eb;
+					next[at] += 5 * er;
+					next[at + 1] += 5 * eg;
+					next[at + 2] += 5 * eb;
+					next[at + forward] += er;
+					next[at + forward + 1] += eg;
+					next[at + forward + 2] += eb;
+				}
+
+				std::swap(current, next);
+			}
+		});
+
+		break;
+	}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Colour.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+#include "Span.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace UU
+{
+	constexpr size_t PALETTE_MAX_SIZE = 256;
+
+	// Bits kept per channel by the nearest colour table and the generation histogram, 32 x 32 x 32 cells.
+	constexpr size_t PALETTE_LOOKUP_BITS = 5;
+	constexpr size_t PALETTE_PARALLEL_GRAIN = 1 << 15;
+
+	enum class EDither : uint8_t
+	{
+		None,
+		Ordered,			// 8 x 8 Bayer matrix, independent per pixel
+		FloydSteinberg		// Serpentine error diffusion, restarted at the top of every band of rows a thread takes
+	};
+
+	// Up to 256 opaque colours with a table mapping every 5-5-5 cell to the entry nearest its centre, so lookups
+	// are a single load. No colour is more than 3.5 levels per channel from its cell's centre, so the entry a
+	// lookup gives is at most 7 sqrt(3), about 12.1 levels, further away than the nearest. Alpha is ignored
+	// throughout.
+	class CPalette final
+	{
+	private:
+
+		std::vector<CColour>								colours;
+		std::vector<uint8_t, CAlignedAllocator<uint8_t>>	lookup;
+
+	public:
+
+		CPalette() = default;
+
+		explicit CPalette(CSpan<const CColour> palette);
+
+		// Uses the given colours as they are.
+		void					Build(CSpan<const CColour> palette);
+
+		// Median cut over a histogram of the pixels, counted in per-thread bins, followed by refinements
+		// k-means passes over the histogram cells. Gives fewer than size colours if the pixels have fewer
+		// distinct cells.
+		void					Generate(CSpan<const CColour> pixels, size_t size = PALETTE_MAX_SIZE, size_t refinements = 2);
+		void					Generate(CImageView<const CColour> image, size_t size = PALETTE_MAX_SIZE, size_t refinements = 2);
+
+		void					Clear();
+
+		// Index of the entry nearest the colour's lookup cell, and of the entry nearest the colour itself. An
+		// empty palette gives 0.
+		uint8_t					Nearest(CColour col) const;
+		uint8_t					NearestExact(CColour col) const;
+
+		const CColour &			operator[](size_t i) const;
+
+		CSpan<const CColour>	Colours() const;
+		size_t					Size() const;
+		bool					Empty() const;
+	};
+
+	// Palette indices of in written to out, both the same size, rows split across threads.
+	void				Quantise(CImageView<const CColour> in, const CPalette & palette, CImageView<uint8_t> out, EDither dither = EDither::None);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace UU
+{
+	size_t HardwareThreads();
+
+	// 1 for any non-empty range when called from inside a ParallelFor chunk, so nested loops run inline
+	// instead of starting threads from every worker.
+	size_t ParallelChunkCount(size_t count, size_t grain);
+
+	// Splits [0, count) into ParallelChunkCount(count, grain) contiguous chunks and calls
+	// fn(chunk_index, begin, end) for each one, the first on the calling thread. All chunks finish before
+	// it returns, and the first exception thrown by any of them is then rethrown.
+	template <typename Fn>
+	void ParallelFor(size_t count, size_t grain, Fn && fn);
+
+	namespace Detail
+	{
+		// Set while the thread runs a chunk of a ParallelFor with more than one chunk.
+		inline thread_local bool in_parallel_for = false;
+
+		// Joins the workers however ParallelFor is left.
+		class CThreadJoiner final
+		{
+		public:
+
+			std::vector<std::thread> &	threads;
+
+			~CThreadJoiner()
+			{
+				for (std::thread & thread : threads)
+					if (thread.joinable())
+						thread.join();
+			}
+		};
+	}
+}
+
+inline size_t UU::HardwareThreads()
+{
+	static const size_t threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+	return threads;
+}
+
+inline size_t UU::ParallelChunkCount(size_t count, size_t grain)
+{
+	if (count == 0)
+		return 0;
+
+	if (Detail::in_parallel_for)
+		return 1;
+
+	if (grain == 0)
+		grain = 1;
+
+	const size_t by_grain = (count + grain - 1) / grain;
+
+	return by_grain < HardwareThreads() ? by_grain : HardwareThreads();
+}
+
+template <typename Fn>
+void UU::ParallelFor(size_t count, size_t grain, Fn && fn)
+{
+	const size_t chunks = ParallelChunkCount(count, grain);
+
+	if (chunks <= 1)
+	{
+		if (chunks == 1)
+			fn(size_t(0), size_t(0), count);
+
+		return;
+	}
+
+	std::exception_ptr error;
+	std::mutex error_mutex;
+
+	const auto run = [&fn, &error, &error_mutex, count, chunks](size_t i)
+	{
+		Detail::in_parallel_for = true;
+
+		try
+		{
+			fn(i, count * i / chunks, count * (i + 1) / chunks);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(error_mutex);
+
+			if (!error)
+				error = std::current_exception();
+		}
+
+		Detail::in_parallel_for = false;
+	};
+
+	{
+		std::vector<std::thread> workers;
+		Detail::CThreadJoiner joiner{ workers };
+
+		workers.reserve(chunks - 1);
+
+		for (size_t i = 1; i < chunks; ++i)
+			workers.emplace_back(run, i);
+
+		run(0);
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
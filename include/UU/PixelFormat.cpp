@@ -0,0 +1,503 @@
+#include "../UU.hpp"
+#include "PixelFormat.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <cstring>
+
+namespace
+{
+	using UU::CColour;
+	using UU::EPixelFormat;
+
+	// Channel (0 to 3 for r, g, b and a) held by each byte of a pixel of the four byte formats.
+	constexpr uint8_t CHANNEL_ORDER[3][4] =
+	{
+		{ 0, 1, 2, 3 },		// RGBA8
+		{ 2, 1, 0, 3 },		// BGRA8
+		{ 3, 0, 1, 2 }		// ARGB8
+	};
+
+	bool IsByteOrder(EPixelFormat format)
+	{
+		return format == EPixelFormat::RGBA8 || format == EPixelFormat::BGRA8 || format == EPixelFormat::ARGB8;
+	}
+
+	// Source byte of every destination byte when moving pixels from one byte order to another.
+	void ShuffleBetween(EPixelFormat from, EPixelFormat to, uint8_t shuffle[4])
+	{
+		const uint8_t * in = CHANNEL_ORDER[static_cast<size_t>(from)];
+		const uint8_t * out = CHANNEL_ORDER[static_cast<size_t>(to)];
+
+		for (uint8_t j = 0; j < 4; ++j)
+			for (uint8_t k = 0; k < 4; ++k)
+				if (in[k] == out[j])
+					shuffle[j] = k;
+	}
+
+	void Swizzle(const uint8_t * in, uint8_t * out, size_t count, const uint8_t shuffle[4])
+	{
+		size_t i = 0;
+
+#if defined(UU_SSSE3)
+		alignas(32) int8_t mask[32];
+
+		for (size_t j = 0; j < 32; ++j)
+			mask[j] = static_cast<int8_t>((j & 15 & ~size_t(3)) + shuffle[j & 3]);
+#endif
+#if defined(UU_AVX2)
+		const __m256i mask8 = _mm256_load_si256(reinterpret_cast<const __m256i *>(mask));
+
+		for (; i + 8 <= count; i += 8)
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 4 * i), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 4 * i)), mask8));
+#endif
+#if defined(UU_SSSE3)
+		const __m128i mask4 = _mm_load_si128(reinterpret_cast<const __m128i *>(mask));
+
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4 * i), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4 * i)), mask4));
+#elif defined(UU_SSE2)
+		// Without pshufb every byte is shifted down, masked and shifted into place, the counts being the same
+		// for all pixels.
+		const __m128i byte = _mm_set1_epi32(0xff);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4 * i));
+			__m128i r = _mm_setzero_si128();
+
+			for (size_t j = 0; j < 4; ++j)
+				r = _mm_or_si128(r, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(v, _mm_cvtsi32_si128(8 * shuffle[j])), byte), _mm_cvtsi32_si128(int(8 * j))));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4 * i), r);
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			uint32_t p, r = 0;
+			std::memcpy(&p, in + 4 * i, 4);
+
+			for (size_t j = 0; j < 4; ++j)
+				r |= ((p >> (8 * shuffle[j])) & 0xff) << (8 * j);
+
+			std::memcpy(out + 4 * i, &r, 4);
+		}
+	}
+
+	// Scalar forms of the channel conversions, matched bit for bit by the SIMD loops.
+
+	uint8_t Expand5(uint32_t c) { return static_cast<uint8_t>((c << 3) | (c >> 2)); }
+	uint8_t Expand6(uint32_t c) { return static_cast<uint8_t>((c << 2) | (c >> 4)); }
+
+	// c * bits / 255 rounded to nearest, for bits of 31 or 63.
+	uint16_t Narrow8(uint32_t c, uint32_t bits)
+	{
+		const uint32_t t = c * bits + 128;
+
+		return static_cast<uint16_t>((t + (t >> 8)) >> 8);
+	}
+
+	// c / 257 rounded to nearest.
+	uint8_t Narrow16(uint32_t c)
+	{
+		return static_cast<uint8_t>((c - ((c + 128) >> 8) + 128) >> 8);
+	}
+
+	uint8_t NarrowFloat(float c)
+	{
+		if (!(c > 0.f))
+			return 0;
+
+		if (c > 1.f)
+			return 255;
+
+		return static_cast<uint8_t>(static_cast<int32_t>(c * 255.f + 0.5f));
+	}
+
+	void DecodeRGB8(const uint8_t * in, CColour * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSSE3)
+		const __m128i mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alpha = _mm_set1_epi32(static_cast<int32_t>(0xff000000));
+
+		// Each step reads 16 bytes for 4 pixels, so stop while that stays inside the buffer.
+		for (; i + 6 <= count; i += 4)
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 3 * i)), mask), alpha));
+#endif
+
+		for (; i < count; ++i)
+			out[i] = CColour(in[3 * i], in[3 * i + 1], in[3 * i + 2]);
+	}
+
+	void EncodeRGB8(const CColour * in, uint8_t * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSSE3)
+		const __m128i mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), mask);
+			const int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(out + 3 * i), v);
+			std::memcpy(out + 3 * i + 8, &tail, 4);
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			out[3 * i] = in[i].r;
+			out[3 * i + 1] = in[i].g;
+			out[3 * i + 2] = in[i].b;
+		}
+	}
+
+	void DecodeRGB565(const uint8_t * in, CColour * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		const __m128i mask5 = _mm_set1_epi16(0x1f);
+		const __m128i mask6 = _mm_set1_epi16(0x3f);
+		const __m128i alpha = _mm_set1_epi16(static_cast<int16_t>(0xff00));
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i));
+			const __m128i r = _mm_srli_epi16(v, 11);
+			const __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask6);
+			const __m128i b = _mm_and_si128(v, mask5);
+
+			const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+			const __m128i g8 = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+			const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+			const __m128i rg = _mm_or_si128(r8, _mm_slli_epi16(g8, 8));
+			const __m128i ba = _mm_or_si128(b8, alpha);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi16(rg, ba));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 4), _mm_unpackhi_epi16(rg, ba));
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			uint16_t c;
+			std::memcpy(&c, in + 2 * i, 2);
+
+			out[i] = CColour(Expand5(c >> 11), Expand6((c >> 5) & 0x3f), Expand5(c & 0x1f));
+		}
+	}
+
+	void EncodeRGB565(const CColour * in, uint8_t * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		const __m128i byte = _mm_set1_epi32(0xff);
+		const __m128i half = _mm_set1_epi16(128);
+
+		const auto narrow = [&](__m128i c, int16_t bits)
+		{
+			const __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, _mm_set1_epi16(bits)), half);
+
+			return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		};
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 4));
+
+			// Channels of 8 pixels in 16-bit lanes.
+			const __m128i r = _mm_packs_epi32(_mm_and_si128(lo, byte), _mm_and_si128(hi, byte));
+			const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 8), byte), _mm_and_si128(_mm_srli_epi32(hi, 8), byte));
+			const __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 16), byte), _mm_and_si128(_mm_srli_epi32(hi, 16), byte));
+
+			const __m128i c = _mm_or_si128(_mm_slli_epi16(narrow(r, 31), 11), _mm_or_si128(_mm_slli_epi16(narrow(g, 63), 5), narrow(b, 31)));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), c);
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			const auto c = static_cast<uint16_t>(Narrow8(in[i].r, 31) << 11 | Narrow8(in[i].g, 63) << 5 | Narrow8(in[i].b, 31));
+
+			std::memcpy(out + 2 * i, &c, 2);
+		}
+	}
+
+	void DecodeRGBA16(const uint8_t * in, CColour * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		const __m128i round = _mm_set1_epi16(127);
+		const __m128i half = _mm_set1_epi16(128);
+
+		const auto narrow = [&](__m128i c)
+		{
+			// (c + 128) >> 8 taken through avg so it cannot overflow the lane.
+			const __m128i q = _mm_srli_epi16(_mm_avg_epu16(c, round), 7);
+
+			return _mm_srli_epi16(_mm_add_epi16(_mm_sub_epi16(c, q), half), 8);
+		};
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 8 * i));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 8 * i + 16));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(narrow(lo), narrow(hi)));
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			uint16_t c[4];
+			std::memcpy(c, in + 8 * i, 8);
+
+			out[i] = CColour(Narrow16(c[0]), Narrow16(c[1]), Narrow16(c[2]), Narrow16(c[3]));
+		}
+	}
+
+	void EncodeRGBA16(const CColour * in, uint8_t * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		// Each byte paired with itself is c * 257.
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8 * i), _mm_unpacklo_epi8(v, v));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8 * i + 16), _mm_unpackhi_epi8(v, v));
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			const uint16_t c[4] = { uint16_t(in[i].r * 257), uint16_t(in[i].g * 257), uint16_t(in[i].b * 257), uint16_t(in[i].a * 257) };
+
+			std::memcpy(out + 8 * i, c, 8);
+		}
+	}
+
+	void DecodeFloat4(const uint8_t * in, CColour * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		const auto narrow = [](const uint8_t * p)
+		{
+			// max returns its second operand for NaN, which clears it.
+			const __m128 c = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(reinterpret_cast<const float *>(p)), _mm_setzero_ps()), _mm_set1_ps(1.f));
+
+			return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+		};
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const uint8_t * p = in + 16 * i;
+
+			const __m128i lo = _mm_packs_epi32(narrow(p), narrow(p + 16));
+			const __m128i hi = _mm_packs_epi32(narrow(p + 32), narrow(p + 48));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(lo, hi));
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			float c[4];
+			std::memcpy(c, in + 16 * i, 16);
+
+			out[i] = CColour(NarrowFloat(c[0]), NarrowFloat(c[1]), NarrowFloat(c[2]), NarrowFloat(c[3]));
+		}
+	}
+
+	void EncodeFloat4(const CColour * in, uint8_t * out, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(UU_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(255.f);
+
+		const auto widen = [&](__m128i c16, uint8_t * p)
+		{
+			_mm_storeu_ps(reinterpret_cast<float *>(p), _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(c16, zero)), scale));
+			_mm_storeu_ps(reinterpret_cast<float *>(p + 16), _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(c16, zero)), scale));
+		};
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+
+			widen(_mm_unpacklo_epi8(v, zero), out + 16 * i);
+			widen(_mm_unpackhi_epi8(v, zero), out + 16 * i + 32);
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			const float c[4] = { in[i].r / 255.f, in[i].g / 255.f, in[i].b / 255.f, in[i].a / 255.f };
+
+			std::memcpy(out + 16 * i, c, 16);
+		}
+	}
+
+	void Decode(const uint8_t * in, EPixelFormat format, CColour * out, size_t count)
+	{
+		uint8_t shuffle[4];
+
+		switch (format)
+		{
+		case EPixelFormat::RGBA8:
+		case EPixelFormat::BGRA8:
+		case EPixelFormat::ARGB8:
+			ShuffleBetween(format, EPixelFormat::RGBA8, shuffle);
+			Swizzle(in, reinterpret_cast<uint8_t *>(out), count, shuffle);
+			break;
+		case EPixelFormat::RGB8:
+			DecodeRGB8(in, out, count);
+			break;
+		case EPixelFormat::RGB565:
+			DecodeRGB565(in, out, count);
+			break;
+		case EPixelFormat::RGBA16:
+			DecodeRGBA16(in, out, count);
+			break;
+		case EPixelFormat::Float4:
+			DecodeFloat4(in, out, count);
+			break;
+		}
+	}
+
+	void Encode(const CColour * in, EPixelFormat format, uint8_t * out, size_t count)
+	{
+		uint8_t shuffle[4];
+
+		switch (format)
+		{
+		case EPixelFormat::RGBA8:
+		case EPixelFormat::BGRA8:
+		case EPixelFormat::ARGB8:
+			ShuffleBetween(EPixelFormat::RGBA8, format, shuffle);
+			Swizzle(reinterpret_cast<const uint8_t *>(in), out, count, shuffle);
+			break;
+		case EPixelFormat::RGB8:
+			EncodeRGB8(in, out, count);
+			break;
+		case EPixelFormat::RGB565:
+			EncodeRGB565(in, out, count);
+			break;
+		case EPixelFormat::RGBA16:
+			EncodeRGBA16(in, out, count);
+			break;
+		case EPixelFormat::Float4:
+			EncodeFloat4(in, out, count);
+			break;
+		}
+	}
+
+	void Convert(const uint8_t * in, EPixelFormat in_format, uint8_t * out, EPixelFormat out_format, size_t count)
+	{
+		if (IsByteOrder(in_format) && IsByteOrder(out_format))
+		{
+			uint8_t shuffle[4];
+
+			ShuffleBetween(in_format, out_format, shuffle);
+			Swizzle(in, out, count, shuffle);
+			return;
+		}
+
+		if (in_format == EPixelFormat::RGBA8)
+		{
+			Encode(reinterpret_cast<const CColour *>(in), out_format, out, count);
+			return;
+		}
+
+		if (out_format == EPixelFormat::RGBA8)
+		{
+			Decode(in, in_format, reinterpret_cast<CColour *>(out), count);
+			return;
+		}
+
+		// Anything else goes through CColour a block at a time.
+		constexpr size_t block = 256;
+
+		const size_t in_size = UU::PixelFormatSize(in_format);
+		const size_t out_size = UU::PixelFormatSize(out_format);
+
+		CColour temp[block];
+
+		for (size_t i = 0; i < count; i += block)
+		{
+			const size_t n = count - i < block ? count - i : block;
+
+			Decode(in + i * in_size, in_format, temp, n);
+			Encode(temp, out_format, out + i * out_size, n);
+		}
+	}
+}
+
+size_t UU::PixelFormatSize(EPixelFormat format)
+{
+	switch (format)
+	{
+	case EPixelFormat::RGBA8:
+	case EPixelFormat::BGRA8:
+	case EPixelFormat::ARGB8:
+		return 4;
+	case EPixelFormat::RGB8:
+		return 3;
+	case EPixelFormat::RGB565:
+		return 2;
+	case EPixelFormat::RGBA16:
+		return 8;
+	case EPixelFormat::Float4:
+		return 16;
+	}
+
+	return 0;
+}
+
+void UU::ConvertPixels(const void * in, EPixelFormat in_format, void * out, EPixelFormat out_format, size_t count)
+{
+	const size_t in_size = PixelFormatSize(in_format);
+	const size_t out_size = PixelFormatSize(out_format);
+
+	ParallelFor(count, PIXEL_FORMAT_PARALLEL_GRAIN, [&](size_t, size_t begin, size_t end)
+	{
+		Convert(static_cast<const uint8_t *>(in) + begin * in_size, in_format, static_cast<uint8_t *>(out) + begin * out_size, out_format, end - begin);
+	});
+}
+
+void UU::ConvertPixels(const void * in, size_t in_stride, EPixelFormat in_format, void * out, size_t out_stride, EPixelFormat out_format, size_t width, size_t height)
+{
+	const size_t grain = width > 0 ? (PIXEL_FORMAT_PARALLEL_GRAIN + width - 1) / width : 1;
+
+	ParallelFor(height, grain, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t y = begin; y < end; ++y)
+			Convert(static_cast<const uint8_t *>(in) + y * in_stride, in_format, static_cast<uint8_t *>(out) + y * out_stride, out_format, width);
+	});
+}
+
+void UU::EncodePixels(CSpan<const CColour> in, EPixelFormat format, void * out)
+{
+	ConvertPixels(in.Data(), EPixelFormat::RGBA8, out, format, in.Size());
+}
+
+void UU::DecodePixels(const void * in, EPixelFormat format, CSpan<CColour> out)
+{
+	ConvertPixels(in, format, out.Data(), EPixelFormat::RGBA8, out.Size());
+}
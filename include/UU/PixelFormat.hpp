@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Colour.hpp"
+#include "Span.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace UU
+{
+	// Formats are named by their order in memory. RGBA8 is CColour itself, BGRA8 the bytes of a little endian
+	// ToD3DColour, RGB565 a native uint16_t with red in the top bits, RGBA16 native uint16_t channels where
+	// 65535 is 255 and Float4 floats in [0, 1], the same as the CVec4f forms of Blend.
+	enum class EPixelFormat : uint8_t
+	{
+		RGBA8,
+		BGRA8,
+		ARGB8,
+		RGB8,
+		RGB565,
+		RGBA16,
+		Float4
+	};
+
+	constexpr size_t PIXEL_FORMAT_PARALLEL_GRAIN = 1 << 16;
+
+	size_t				PixelFormatSize(EPixelFormat format);
+
+	// Converts count pixels. Narrowing rounds to nearest, widening replicates bits so white stays white, and
+	// formats without alpha read as opaque. Conversions not involving RGBA8 go through it a block at a time, so
+	// keep 8 bits of precision per channel. Byte orders of the 8-bit formats are swapped with pshufb on SSSE3,
+	// 8 pixels per step with AVX2, and the others are packed and unpacked with SSE2, all with scalar fallbacks
+	// giving the same results. in and out may be the same buffer if both formats have the same size.
+	void				ConvertPixels(const void * in, EPixelFormat in_format, void * out, EPixelFormat out_format, size_t count);
+
+	// The same for width x height images whose rows are the given number of bytes apart.
+	void				ConvertPixels(const void * in, size_t in_stride, EPixelFormat in_format, void * out, size_t out_stride, EPixelFormat out_format, size_t width, size_t height);
+
+	// Conversions from and to CColour spans, out or in holding in.Size() or out.Size() pixels of format.
+	void				EncodePixels(CSpan<const CColour> in, EPixelFormat format, void * out);
+	void				DecodePixels(const void * in, EPixelFormat format, CSpan<CColour> out);
+}
@@ -0,0 +1,491 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Math.hpp"
+#include "Simd.hpp"
+#include "Span.hpp"
+#include "TableMath.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+
+namespace UU
+{
+	enum class EPolyScheme : uint8_t
+	{
+		// One multiply-add per coefficient, each depending on the previous one.
+		Horner,
+		// Pairs of coefficients combined with x, x^2, x^4, ... in a tree, shorter dependency chains for
+		// latency bound code at the cost of the extra powers and slightly different rounding.
+		Estrin
+	};
+
+	enum class EPolyError : uint8_t
+	{
+		Absolute,
+		// Error relative to |fn(x)|, fn must not vanish on the interval.
+		Relative
+	};
+
+	// c[0] + c[1] t + ... + c[degree] t^degree with t = x * scale + offset, which maps the fitted interval onto [-1, 1].
+	template <typename T, size_t degree>
+	class CPolynomial final
+	{
+	public:
+		std::array<T, degree + 1>	coefficients = {};
+		T							scale = T(1);
+		T							offset = T(0);
+
+		template <EPolyScheme scheme = EPolyScheme::Horner>
+		T							Evaluate(T x) const;
+		template <EPolyScheme scheme = EPolyScheme::Horner, size_t lanes>
+		CSimd<T, lanes>				Evaluate(const CSimd<T, lanes> & x) const;
+
+		// Element-wise form for float and double, out may alias in.
+		template <EPolyScheme scheme = EPolyScheme::Horner>
+		void						Evaluate(CSpan<const T> in, CSpan<T> out) const;
+
+		T							operator()(T x) const { return Evaluate(x); }
+
+		// Prints the coefficients at full precision, ready to paste into code generated offline.
+		friend std::ostream & operator<<(std::ostream & os, const CPolynomial & p)
+		{
+			const std::streamsize precision = os.precision(std::numeric_limits<T>::max_digits10);
+
+			os << "{";
+
+			for (size_t i = 0; i < degree; ++i)
+				os << p.coefficients[i] << ", ";
+
+			os << p.coefficients[degree] << "} scale " << p.scale << " offset " << p.offset;
+
+			os.precision(precision);
+
+			return os;
+		}
+	};
+
+	// Interpolates fn at the degree + 1 Chebyshev nodes of [a, b]. For smooth functions the error is within
+	// a small factor of the minimax error. fn takes and returns double, and the fit is a constant expression
+	// whenever fn is constexpr, e.g. constexpr auto p = FitChebyshev<float, 6>([](double x) { return ...; }, 0.0, 1.0);
+	template <typename T, size_t degree, typename Fn>
+	constexpr CPolynomial<T, degree> FitChebyshev(Fn && fn, double a, double b);
+
+	// Remez exchange towards the polynomial with the smallest maximum absolute or relative error on [a, b],
+	// starting from the Chebyshev extrema. Error extrema are searched on a grid of 64 points per reference
+	// point, so the result equioscillates to about that resolution. Constant evaluation of high degrees
+	// may need a higher /constexpr:steps or -fconstexpr-ops-limit.
+	template <typename T, size_t degree, typename Fn>
+	constexpr CPolynomial<T, degree> FitMinimax(Fn && fn, double a, double b, EPolyError error = EPolyError::Absolute, size_t iterations = 12);
+
+	// Error of p against fn over evenly spaced samples of [a, b], evaluated in T the way callers will use it.
+	class CPolyErrorReport final
+	{
+	public:
+		double					max_abs_error = 0.0;
+		double					max_abs_x = 0.0;
+		double					max_rel_error = 0.0;
+		double					max_rel_x = 0.0;
+		double					max_ulp_error = 0.0;
+		double					max_ulp_x = 0.0;
+		double					rms_error = 0.0;
+		size_t					samples = 0;
+
+		friend std::ostream & operator<<(std::ostream & os, const CPolyErrorReport & r)
+		{
+			os << "max abs " << r.max_abs_error << " at " << r.max_abs_x
+				<< ", max rel " << r.max_rel_error << " at " << r.max_rel_x
+				<< ", max ulp " << r.max_ulp_error << " at " << r.max_ulp_x
+				<< ", rms " << r.rms_error << " over " << r.samples << " samples";
+
+			return os;
+		}
+	};
+
+	template <EPolyScheme scheme = EPolyScheme::Horner, typename T, size_t degree, typename Fn>
+	CPolyErrorReport ErrorReport(const CPolynomial<T, degree> & p, Fn && fn, double a, double b, size_t samples = 1 << 16);
+}
+
+namespace UU
+{
+	namespace Detail
+	{
+		constexpr double ConstexprAbs(double x)
+		{
+			return x < 0.0 ? -x : x;
+		}
+
+		// cos(pi * f) for f in [0, 1].
+		constexpr double ConstexprCosPi(double f)
+		{
+			const double x = 3.14159265358979323846 * f;
+
+			return x <= 1.57079632679489661923 ? ConstexprCos(x) : -ConstexprCos(3.14159265358979323846 - x);
+		}
+
+		// Gaussian elimination with partial pivoting on an n x (n + 1) augmented matrix.
+		template <size_t n>
+		constexpr std::array<double, n> Solve(std::array<std::array<double, n + 1>, n> m)
+		{
+			for (size_t col = 0; col < n; ++col)
+			{
+				size_t pivot = col;
+
+				for (size_t r = col + 1; r < n; ++r)
+				{
+					if (ConstexprAbs(m[r][col]) > ConstexprAbs(m[pivot][col]))
+						pivot = r;
+				}
+
+				for (size_t c = 0; c <= n; ++c)
+				{
+					const double t = m[col][c];
+
+					m[col][c] = m[pivot][c];
+					m[pivot][c] = t;
+				}
+
+				for (size_t r = col + 1; r < n; ++r)
+				{
+					const double f = m[r][col] / m[col][col];
+
+					for (size_t c = col; c <= n; ++c)
+						m[r][c] -= f * m[col][c];
+				}
+			}
+
+			std::array<double, n> x = {};
+
+			for (size_t i = n; i-- > 0;)
+			{
+				double s = m[i][n];
+
+				for (size_t c = i + 1; c < n; ++c)
+					s -= m[i][c] * x[c];
+
+				x[i] = s / m[i][i];
+			}
+
+			return x;
+		}
+
+		template <size_t count>
+		constexpr double EvaluateMonomial(const std::array<double, count> & c, double t)
+		{
+			double result = c[count - 1];
+
+			for (size_t i = count - 1; i-- > 0;)
+				result = result * t + c[i];
+
+			return result;
+		}
+
+		template <typename T, size_t degree>
+		constexpr CPolynomial<T, degree> MakePolynomial(const std::array<double, degree + 1> & c, double a, double b)
+		{
+			CPolynomial<T, degree> p;
+
+			for (size_t i = 0; i <= degree; ++i)
+				p.coefficients[i] = static_cast<T>(c[i]);
+
+			p.scale = static_cast<T>(2.0 / (b - a));
+			p.offset = static_cast<T>(-(a + b) / (b - a));
+
+			return p;
+		}
+
+		template <typename T>
+		T FusedMulAdd(T a, T b, T c)
+		{
+#if defined(UU_FMA)
+			return std::fma(a, b, c);
+#else
+			return a * b + c;
+#endif
+		}
+
+		template <typename T, size_t lanes>
+		CSimd<T, lanes> FusedMulAdd(const CSimd<T, lanes> & a, const CSimd<T, lanes> & b, const CSimd<T, lanes> & c)
+		{
+			return MulAdd(a, b, c);
+		}
+
+		// V is T or a CSimd of T.
+		template <EPolyScheme scheme, typename V, typename T, size_t degree>
+		V EvaluatePolynomial(const CPolynomial<T, degree> & p, const V & x)
+		{
+			const V t = FusedMulAdd(x, V(p.scale), V(p.offset));
+
+			if constexpr (scheme == EPolyScheme::Horner || degree < 2)
+			{
+				V result = V(p.coefficients[degree]);
+
+				for (size_t i = degree; i-- > 0;)
+					result = FusedMulAdd(result, t, V(p.coefficients[i]));
+
+				return result;
+			}
+			else
+			{
+				// Each pass halves the number of terms with the next power of t.
+				V terms[degree + 1];
+				V power = t;
+
+				for (size_t i = 0; i <= degree; ++i)
+					terms[i] = V(p.coefficients[i]);
+
+				for (size_t count = degree + 1; count > 1; count = (count + 1) / 2)
+				{
+					for (size_t i = 0; i < count / 2; ++i)
+						terms[i] = FusedMulAdd(terms[2 * i + 1], power, terms[2 * i]);
+
+					if (count & 1)
+						terms[count / 2] = terms[count - 1];
+
+					power = power * power;
+				}
+
+				return terms[0];
+			}
+		}
+	}
+}
+
+template <typename T, size_t degree>
+template <UU::EPolyScheme scheme>
+T UU::CPolynomial<T, degree>::Evaluate(const T x) const
+{
+	return Detail::EvaluatePolynomial<scheme>(*this, x);
+}
+
+template <typename T, size_t degree>
+template <UU::EPolyScheme scheme, size_t lanes>
+UU::CSimd<T, lanes> UU::CPolynomial<T, degree>::Evaluate(const CSimd<T, lanes> & x) const
+{
+	return Detail::EvaluatePolynomial<scheme>(*this, x);
+}
+
+template <typename T, size_t degree>
+template <UU::EPolyScheme scheme>
+void UU::CPolynomial<T, degree>::Evaluate(CSpan<const T> in, CSpan<T> out) const
+{
+	Detail::SimdTransform(in, out, [this](const CSimdNative<T> & x) { return Detail::EvaluatePolynomial<scheme>(*this, x); });
+}
+
+template <typename T, size_t degree, typename Fn>
+constexpr UU::CPolynomial<T, degree> UU::FitChebyshev(Fn && fn, const double a, const double b)
+{
+	constexpr size_t n = degree + 1;
+
+	// Chebyshev coefficients c_j = 2/n sum_k f(t_k) T_j(t_k), with T_j(t_k) from the three term recurrence.
+	std::array<double, n> cheb = {};
+
+	for (size_t k = 0; k < n; ++k)
+	{
+		const double t = Detail::ConstexprCosPi((static_cast<double>(k) + 0.5) / static_cast<double>(n));
+		const double y = fn(0.5 * (a + b) + 0.5 * (b - a) * t);
+
+		double t_prev = 1.0, t_cur = t;
+
+		cheb[0] += y;
+
+		for (size_t j = 1; j < n; ++j)
+		{
+			cheb[j] += y * t_cur;
+
+			const double t_next = 2.0 * t * t_cur - t_prev;
+
+			t_prev = t_cur;
+			t_cur = t_next;
+		}
+	}
+
+	for (size_t j = 0; j < n; ++j)
+		cheb[j] *= (j == 0 ? 1.0 : 2.0) / static_cast<double>(n);
+
+	// Expands sum_j c_j T_j(t) into powers of t, T_{j+1} = 2 t T_j - T_{j-1}.
+	std::array<double, n> mono = {};
+	std::array<double, n> poly_prev = {}, poly_cur = {};
+
+	poly_prev[0] = 1.0;
+	mono[0] = cheb[0];
+
+	if constexpr (n > 1)
+	{
+		poly_cur[1] = 1.0;
+		mono[1] = cheb[1];
+	}
+
+	for (size_t j = 2; j < n; ++j)
+	{
+		std::array<double, n> poly_next = {};
+
+		for (size_t i = 0; i < n; ++i)
+			poly_next[i] = (i > 0 ? 2.0 * poly_cur[i - 1] : 0.0) - poly_prev[i];
+
+		for (size_t i = 0; i < n; ++i)
+			mono[i] += cheb[j] * poly_next[i];
+
+		poly_prev = poly_cur;
+		poly_cur = poly_next;
+	}
+
+	return Detail::MakePolynomial<T, degree>(mono, a, b);
+}
+
+template <typename T, size_t degree, typename Fn>
+constexpr UU::CPolynomial<T, degree> UU::FitMinimax(Fn && fn, const double a, const double b, const EPolyError error, const size_t iterations)
+{
+	constexpr size_t n = degree + 2;
+	constexpr size_t grid = 64 * n;
+
+	const bool relative = error == EPolyError::Relative;
+
+	const auto g = [&](double t) { return fn(0.5 * (a + b) + 0.5 * (b - a) * t); };
+	const auto weighted_error = [&](const std::array<double, degree + 1> & c, double t)
+	{
+		const double y = g(t);
+		const double e = Detail::EvaluateMonomial(c, t) - y;
+
+		return relative ? e / Detail::ConstexprAbs(y) : e;
+	};
+
+	// Chebyshev extrema in ascending order.
+	std::array<double, n> reference = {};
+
+	for (size_t i = 0; i < n; ++i)
+		reference[i] = -Detail::ConstexprCosPi(static_cast<double>(i) / static_cast<double>(n - 1));
+
+	std::array<double, degree + 1> c = {};
+
+	for (size_t it = 0; it < iterations; ++it)
+	{
+		// p(t_i) + (-1)^i E w(t_i) = f(t_i) for the levelled error E.
+		std::array<std::array<double, n + 1>, n> m = {};
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			const double y = g(reference[i]);
+
+			double power = 1.0;
+
+			for (size_t j = 0; j <= degree; ++j)
+			{
+				m[i][j] = power;
+				power *= reference[i];
+			}
+
+			m[i][degree + 1] = (i & 1 ? -1.0 : 1.0) * (relative ? Detail::ConstexprAbs(y) : 1.0);
+			m[i][n] = y;
+		}
+
+		const std::array<double, n> solution = Detail::Solve<n>(m);
+
+		for (size_t j = 0; j <= degree; ++j)
+			c[j] = solution[j];
+
+		// New reference: the largest error of every run of equal sign on the grid.
+		std::array<double, grid> run_t = {}, run_e = {};
+		size_t runs = 0;
+
+		for (size_t s = 0; s < grid; ++s)
+		{
+			const double t = -1.0 + 2.0 * static_cast<double>(s) / static_cast<double>(grid - 1);
+			const double e = weighted_error(c, t);
+
+			if (runs == 0 || (e < 0.0) != (run_e[runs - 1] < 0.0))
+			{
+				run_t[runs] = t;
+				run_e[runs] = e;
+				++runs;
+			}
+			else if (Detail::ConstexprAbs(e) > Detail::ConstexprAbs(run_e[runs - 1]))
+			{
+				run_t[runs - 1] = t;
+				run_e[runs - 1] = e;
+			}
+		}
+
+		if (runs < n)
+			break;
+
+		// Dropping runs from the ends keeps the signs alternating.
+		size_t first = 0, last = runs - 1;
+
+		while (last - first + 1 > n)
+		{
+			if (Detail::ConstexprAbs(run_e[first]) < Detail::ConstexprAbs(run_e[last]))
+				++first;
+			else
+				--last;
+		}
+
+		double smallest = Detail::ConstexprAbs(run_e[first]), largest = smallest;
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			reference[i] = run_t[first + i];
+
+			const double e = Detail::ConstexprAbs(run_e[first + i]);
+
+			smallest = e < smallest ? e : smallest;
+			largest = e > largest ? e : largest;
+		}
+
+		if (largest - smallest <= 1e-6 * largest)
+			break;
+	}
+
+	return Detail::MakePolynomial<T, degree>(c, a, b);
+}
+
+template <UU::EPolyScheme scheme, typename T, size_t degree, typename Fn>
+UU::CPolyErrorReport UU::ErrorReport(const CPolynomial<T, degree> & p, Fn && fn, const double a, const double b, const size_t samples)
+{
+	CPolyErrorReport report;
+	double sum_sqr = 0.0;
+
+	report.samples = samples;
+
+	for (size_t s = 0; s < samples; ++s)
+	{
+		// The reference is taken at the argument after rounding to T, so only the approximation is measured.
+		const T x = static_cast<T>(samples > 1 ? a + (b - a) * static_cast<double>(s) / static_cast<double>(samples - 1) : a);
+		const double y = fn(static_cast<double>(x));
+		const double e = std::fabs(static_cast<double>(p.template Evaluate<scheme>(x)) - y);
+
+		sum_sqr += e * e;
+
+		if (e > report.max_abs_error)
+		{
+			report.max_abs_error = e;
+			report.max_abs_x = x;
+		}
+
+		if (y != 0.0 && e / std::fabs(y) > report.max_rel_error)
+		{
+			report.max_rel_error = e / std::fabs(y);
+			report.max_rel_x = x;
+		}
+
+		// Units of the last place of T at y, floored at the smallest subnormal.
+		const double ulp = std::fmax(std::ldexp(static_cast<double>(std::numeric_limits<T>::epsilon()), std::ilogb(y)),
+			static_cast<double>(std::numeric_limits<T>::denorm_min()));
+
+		if (y != 0.0 && e / ulp > report.max_ulp_error)
+		{
+			report.max_ulp_error = e / ulp;
+			report.max_ulp_x = x;
+		}
+	}
+
+	report.rms_error = samples > 0 ? std::sqrt(sum_sqr / static_cast<double>(samples)) : 0.0;
+
+	return report;
+}
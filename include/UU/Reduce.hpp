@@ -0,0 +1,457 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "AABox.hpp"
+#include "Math.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+#include "Span.hpp"
+#include "VectorView.hpp"
+
+#include <type_traits>
+#include <vector>
+
+namespace UU
+{
+	// Points summed directly before results are merged pairwise; bounds the rounding error to
+	// O(REDUCE_BLOCK_SIZE + log n) ulps instead of O(n).
+	constexpr size_t REDUCE_BLOCK_SIZE = 1024;
+	constexpr size_t REDUCE_PARALLEL_GRAIN = 1 << 16;
+
+	// Integers are reduced in double so the sums cannot overflow.
+	template <typename T>
+	using TReduceAccumulator = std::conditional_t<std::is_floating_point<T>::value, T, double>;
+
+	// Count, mean and scatter matrix (sum of centred outer products) of a point set.
+	// Two sets are combined with Chan's parallel form of Welford's update.
+	template <typename T, size_t size>
+	class CPointMoments
+	{
+	public:
+		using A = std::conditional_t<std::is_same<T, long double>::value, long double, double>;
+
+		size_t	count = 0;
+		A		mean[size] = {};
+		A		scatter[size][size] = {};
+
+		void	Merge(const CPointMoments & m);
+	};
+
+	// Points may be any CVectorView; strided views are gathered block by block into a packed
+	// scratch buffer so the SIMD paths still see contiguous data.
+	template <typename T, size_t size>
+	CAABox<T, size> Bounds(CVectorView<const T, size> points);
+
+	template <typename T, size_t size>
+	CVector<T, size> Centroid(CVectorView<const T, size> points);
+
+	template <typename T, size_t size>
+	CPointMoments<T, size> Moments(CVectorView<const T, size> points);
+
+	// Population covariance (divided by n). centroid, if given, receives the mean.
+	template <typename T, size_t size>
+	CMatrix<T, size, size> Covariance(CVectorView<const T, size> points, CVector<T, size> * centroid = nullptr);
+
+	// CSpans and std::vectors of CVectors, and mutable views, forward to the forms above.
+	template <typename TPoints, typename V = TConstViewOf<TPoints>>
+	CAABox<typename V::TValue, V::SIZE> Bounds(const TPoints & points);
+
+	template <typename TPoints, typename V = TConstViewOf<TPoints>>
+	CVector<typename V::TValue, V::SIZE> Centroid(const TPoints & points);
+
+	template <typename TPoints, typename V = TConstViewOf<TPoints>>
+	CPointMoments<typename V::TValue, V::SIZE> Moments(const TPoints & points);
+
+	template <typename TPoints, typename V = TConstViewOf<TPoints>, typename = std::enable_if_t<!std::is_same<TPoints, V>::value>>
+	CMatrix<typename V::TValue, V::SIZE, V::SIZE> Covariance(const TPoints & points, CVector<typename V::TValue, V::SIZE> * centroid = nullptr);
+}
+
+namespace UU
+{
+	namespace Detail
+	{
+		// Flat component arrays are processed in periods of lcm(size, lanes) so every SIMD lane
+		// always sees the same component; lanes are folded back per component at the end.
+		constexpr size_t ReducePeriod(size_t size, size_t lanes)
+		{
+			size_t period = size;
+
+			while (period % lanes != 0)
+				period += size;
+
+			return period;
+		}
+
+		// Lanes every sum accumulator layout is built on, a whole number of registers at any width, so
+		// sums come out the same whatever the SIMD width.
+		constexpr size_t REDUCE_LANES = 16;
+
+		template <typename T>
+		constexpr bool REDUCE_SIMD = std::is_same<T, float>::value || std::is_same<T, double>::value;
+
+		template <typename T, size_t size>
+		void BoundsRange(const T * flat, size_t count, T * min, T * max)
+		{
+			const size_t n = count * size;
+			size_t i = 0;
+
+			if constexpr (REDUCE_SIMD<T>)
+			{
+				using V = CSimdNative<T>;
+
+				constexpr size_t period = ReducePeriod(size, V::LANES);
+				constexpr size_t regs = period / V::LANES;
+
+				if (n >= period)
+				{
+					T lanes_min[period], lanes_max[period];
+					V mn[regs], mx[regs];
+
+					for (size_t j = 0; j < period; ++j)
+					{
+						lanes_min[j] = min[j % size];
+						lanes_max[j] = max[j % size];
+					}
+
+					for (size_t r = 0; r < regs; ++r)
+					{
+						mn[r] = V::Load(lanes_min + r * V::LANES);
+						mx[r] = V::Load(lanes_max + r * V::LANES);
+					}
+
+					// Min and Max give their second operand when either is NaN, so with the point first a NaN
+					// is skipped as the scalar compares below skip it.
+					for (; i + period <= n; i += period)
+						for (size_t r = 0; r < regs; ++r)
+						{
+							const V v = V::Load(flat + i + r * V::LANES);
+
+							mn[r] = Min(v, mn[r]);
+							mx[r] = Max(v, mx[r]);
+						}
+
+					for (size_t r = 0; r < regs; ++r)
+					{
+						mn[r].Store(lanes_min + r * V::LANES);
+						mx[r].Store(lanes_max + r * V::LANES);
+					}
+
+					for (size_t j = 0; j < period; ++j)
+					{
+						min[j % size] = lanes_min[j] < min[j % size] ? lanes_min[j] : min[j % size];
+						max[j % size] = lanes_max[j] > max[j % size] ? lanes_max[j] : max[j % size];
+					}
+				}
+			}
+
+			for (; i < n; ++i)
+			{
+				min[i % size] = flat[i] < min[i % size] ? flat[i] : min[i % size];
+				max[i % size] = flat[i] > max[i % size] ? flat[i] : max[i % size];
+			}
+		}
+
+		template <typename A, typename T, size_t size>
+		void SumBlock(const T * flat, size_t count, A * out)
+		{
+			constexpr size_t period = ReducePeriod(size, REDUCE_LANES);
+
+			const size_t n = count * size;
+			size_t i = 0;
+
+			for (size_t j = 0; j < size; ++j)
+				out[j] = A(0);
+
+			if constexpr (REDUCE_SIMD<T> && std::is_same<A, T>::value)
+			{
+				using V = CSimdNative<T>;
+
+				constexpr size_t regs = period / V::LANES;
+
+				V acc[regs];
+				T lanes[period];
+
+				for (size_t r = 0; r < regs; ++r)
+					acc[r] = V(T(0));
+
+				for (; i + period <= n; i += period)
+					for (size_t r = 0; r < regs; ++r)
+						acc[r] = acc[r] + V::Load(flat + i + r * V::LANES);
+
+				for (size_t r = 0; r < regs; ++r)
+					acc[r].Store(lanes + r * V::LANES);
+
+				for (size_t j = 0; j < period; ++j)
+					out[j % size] += lanes[j];
+			}
+			else
+			{
+				A acc[period] = {};
+
+				for (; i + period <= n; i += period)
+					for (size_t j = 0; j < period; ++j)
+						acc[j] += static_cast<A>(flat[i + j]);
+
+				for (size_t j = 0; j < period; ++j)
+					out[j % size] += acc[j];
+			}
+
+			for (; i < n; ++i)
+				out[i % size] += static_cast<A>(flat[i]);
+		}
+
+		// Returns count points from begin as a packed array, gathering strided views into scratch.
+		template <typename T, size_t size>
+		const CVector<T, size> * PackedPoints(const CVectorView<const T, size> & points, size_t begin, size_t count,
+			CVector<T, size> * scratch)
+		{
+			if (points.IsContiguous())
+				return &points[begin];
+
+			for (size_t i = 0; i < count; ++i)
+				scratch[i] = points[begin + i];
+
+			return scratch;
+		}
+
+		template <typename T, size_t size>
+		std::vector<CVector<T, size>> ReduceScratch(const CVectorView<const T, size> & points)
+		{
+			return std::vector<CVector<T, size>>(points.IsContiguous() ? 0 : REDUCE_BLOCK_SIZE);
+		}
+
+		template <typename T, size_t size>
+		void BoundsView(const CVectorView<const T, size> & points, size_t begin, size_t end, T * min, T * max)
+		{
+			std::vector<CVector<T, size>> scratch = ReduceScratch(points);
+
+			for (size_t i = begin; i < end; i += REDUCE_BLOCK_SIZE)
+			{
+				const size_t n = end - i < REDUCE_BLOCK_SIZE ? end - i : REDUCE_BLOCK_SIZE;
+
+				BoundsRange<T, size>(PackedPoints(points, i, n, scratch.data())->Base(), n, min, max);
+			}
+		}
+
+		template <typename A, typename T, size_t size>
+		void PairwiseSum(const CVectorView<const T, size> & points, size_t begin, size_t count, A * out, CVector<T, size> * scratch)
+		{
+			if (count <= REDUCE_BLOCK_SIZE)
+			{
+				SumBlock<A, T, size>(PackedPoints(points, begin, count, scratch)->Base(), count, out);
+				return;
+			}
+
+			const size_t half = (count / 2 + REDUCE_BLOCK_SIZE - 1) / REDUCE_BLOCK_SIZE * REDUCE_BLOCK_SIZE;
+			A right[size];
+
+			PairwiseSum<A, T, size>(points, begin, half, out, scratch);
+			PairwiseSum<A, T, size>(points, begin + half, count - half, right, scratch);
+
+			for (size_t j = 0; j < size; ++j)
+				out[j] += right[j];
+		}
+
+		template <typename T, size_t size>
+		CPointMoments<T, size> MomentsBlock(const CVector<T, size> * points, size_t count)
+		{
+			using A = typename CPointMoments<T, size>::A;
+
+			CPointMoments<T, size> m;
+			A sum[size];
+
+			SumBlock<A, T, size>(points->Base(), count, sum);
+
+			m.count = count;
+
+			for (size_t j = 0; j < size; ++j)
+				m.mean[j] = sum[j] / static_cast<A>(count);
+
+			// Second pass over the block while it is still in cache.
+			for (size_t i = 0; i < count; ++i)
+			{
+				const T * p = points[i].Base();
+				A d[size];
+
+				for (size_t j = 0; j < size; ++j)
+					d[j] = static_cast<A>(p[j]) - m.mean[j];
+
+				for (size_t j = 0; j < size; ++j)
+					for (size_t k = j; k < size; ++k)
+						m.scatter[j][k] += d[j] * d[k];
+			}
+
+			return m;
+		}
+
+		template <typename T, size_t size>
+		CPointMoments<T, size> PairwiseMoments(const CVectorView<const T, size> & points, size_t begin, size_t count,
+			CVector<T, size> * scratch)
+		{
+			if (count <= REDUCE_BLOCK_SIZE)
+				return MomentsBlock(PackedPoints(points, begin, count, scratch), count);
+
+			const size_t half = (count / 2 + REDUCE_BLOCK_SIZE - 1) / REDUCE_BLOCK_SIZE * REDUCE_BLOCK_SIZE;
+
+			CPointMoments<T, size> m = PairwiseMoments(points, begin, half, scratch);
+			m.Merge(PairwiseMoments(points, begin + half, count - half, scratch));
+
+			return m;
+		}
+
+		// Merges per-chunk results as a balanced tree so the combining order does not depend on thread count skew.
+		template <typename R, typename Fn>
+		R TreeMerge(std::vector<R> & parts, Fn && merge)
+		{
+			for (size_t stride = 1; stride < parts.size(); stride *= 2)
+				for (size_t i = 0; i + stride < parts.size(); i += stride * 2)
+					merge(parts[i], parts[i + stride]);
+
+			return parts[0];
+		}
+	}
+}
+
+template <typename T, size_t size>
+void UU::CPointMoments<T, size>::Merge(const CPointMoments & m)
+{
+	if (m.count == 0)
+		return;
+
+	if (count == 0)
+	{
+		*this = m;
+		return;
+	}
+
+	const A n_a = static_cast<A>(count), n_b = static_cast<A>(m.count);
+	const A n = n_a + n_b;
+	A delta[size];
+
+	for (size_t j = 0; j < size; ++j)
+	{
+		delta[j] = m.mean[j] - mean[j];
+		mean[j] += delta[j] * (n_b / n);
+	}
+
+	const A weight = n_a * n_b / n;
+
+	for (size_t j = 0; j < size; ++j)
+		for (size_t k = j; k < size; ++k)
+			scatter[j][k] += m.scatter[j][k] + delta[j] * delta[k] * weight;
+
+	count += m.count;
+}
+
+template <typename T, size_t size>
+UU::CAABox<T, size> UU::Bounds(CVectorView<const T, size> points)
+{
+	const size_t chunks = ParallelChunkCount(points.Size(), REDUCE_PARALLEL_GRAIN);
+
+	std::vector<CAABox<T, size>> parts(chunks > 0 ? chunks : 1);
+
+	ParallelFor(points.Size(), REDUCE_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+	{
+		Detail::BoundsView(points, begin, end, parts[chunk].min.Base(), parts[chunk].max.Base());
+	});
+
+	return Detail::TreeMerge(parts, [](CAABox<T, size> & a, const CAABox<T, size> & b) { a.Grow(b); });
+}
+
+template <typename T, size_t size>
+UU::CVector<T, size> UU::Centroid(CVectorView<const T, size> points)
+{
+	using A = TReduceAccumulator<T>;
+
+	CVector<T, size> temp;
+	temp.Zero();
+
+	if (points.Empty())
+		return temp;
+
+	const size_t chunks = ParallelChunkCount(points.Size(), REDUCE_PARALLEL_GRAIN);
+
+	std::vector<CVector<A, size>> parts(chunks);
+
+	ParallelFor(points.Size(), REDUCE_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+	{
+		std::vector<CVector<T, size>> scratch = Detail::ReduceScratch(points);
+
+		Detail::PairwiseSum<A, T, size>(points, begin, end - begin, parts[chunk].Base(), scratch.data());
+	});
+
+	const CVector<A, size> sum = Detail::TreeMerge(parts, [](CVector<A, size> & a, const CVector<A, size> & b) { a += b; });
+
+	for (size_t j = 0; j < size; ++j)
+		temp[j] = static_cast<T>(sum[j] / static_cast<A>(points.Size()));
+
+	return temp;
+}
+
+template <typename T, size_t size>
+UU::CPointMoments<T, size> UU::Moments(CVectorView<const T, size> points)
+{
+	if (points.Empty())
+		return CPointMoments<T, size>();
+
+	const size_t chunks = ParallelChunkCount(points.Size(), REDUCE_PARALLEL_GRAIN);
+
+	std::vector<CPointMoments<T, size>> parts(chunks);
+
+	ParallelFor(points.Size(), REDUCE_PARALLEL_GRAIN, [&](size_t chunk, size_t begin, size_t end)
+	{
+		std::vector<CVector<T, size>> scratch = Detail::ReduceScratch(points);
+
+		parts[chunk] = Detail::PairwiseMoments(points, begin, end - begin, scratch.data());
+	});
+
+	return Detail::TreeMerge(parts, [](CPointMoments<T, size> & a, const CPointMoments<T, size> & b) { a.Merge(b); });
+}
+
+template <typename T, size_t size>
+UU::CMatrix<T, size, size> UU::Covariance(CVectorView<const T, size> points, CVector<T, size> * centroid)
+{
+	const CPointMoments<T, size> m = Moments(points);
+	const auto inv_n = m.count > 0 ? 1 / static_cast<typename CPointMoments<T, size>::A>(m.count) : 0;
+
+	CMatrix<T, size, size> temp;
+
+	for (size_t j = 0; j < size; ++j)
+		for (size_t k = j; k < size; ++k)
+			temp[j][k] = temp[k][j] = static_cast<T>(m.scatter[j][k] * inv_n);
+
+	if (centroid)
+	{
+		for (size_t j = 0; j < size; ++j)
+			(*centroid)[j] = static_cast<T>(m.mean[j]);
+	}
+
+	return temp;
+}
+
+template <typename TPoints, typename V>
+UU::CAABox<typename V::TValue, V::SIZE> UU::Bounds(const TPoints & points)
+{
+	return Bounds(V(points));
+}
+
+template <typename TPoints, typename V>
+UU::CVector<typename V::TValue, V::SIZE> UU::Centroid(const TPoints & points)
+{
+	return Centroid(V(points));
+}
+
+template <typename TPoints, typename V>
+UU::CPointMoments<typename V::TValue, V::SIZE> UU::Moments(const TPoints & points)
+{
+	return Moments(V(points));
+}
+
+template <typename TPoints, typename V, typename>
+UU::CMatrix<typename V::TValue, V::SIZE, V::SIZE> UU::Covariance(const TPoints & points, CVector<typename V::TValue, V::SIZE> * centroid)
+{
+	return Covariance(V(points), centroid);
+}
@@ -0,0 +1,556 @@
+#include "../UU.hpp"
+#include "Resample.hpp"
+#include "Parallel.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	using UU::CColour;
+	using UU::CLinearColour;
+	using UU::CResampleAxis;
+	using UU::CSpan;
+	using UU::EResampleFilter;
+
+	using V = UU::CSimdNative<float>;
+	using F4 = UU::CSimd<float, 4>;
+
+	static_assert(sizeof(CColour) == 4, "Rows of CColour are read as bytes");
+	static_assert(sizeof(CLinearColour) == 4 * sizeof(float), "Rows of CLinearColour are read as floats");
+
+	constexpr int32_t WEIGHT_ONE = 1 << UU::RESAMPLE_WEIGHT_BITS;
+	constexpr int32_t WEIGHT_HALF = WEIGHT_ONE / 2;
+
+	double Support(EResampleFilter filter)
+	{
+		switch (filter)
+		{
+		case EResampleFilter::Bilinear:
+			return 1.0;
+		case EResampleFilter::Bicubic:
+			return 2.0;
+		case EResampleFilter::Lanczos:
+			return 3.0;
+		}
+
+		return 1.0;
+	}
+
+	double Sinc(double x)
+	{
+		if (x == 0.0)
+			return 1.0;
+
+		x *= UU::DBL_PI;
+
+		return std::sin(x) / x;
+	}
+
+	double Kernel(EResampleFilter filter, double x)
+	{
+		x = std::fabs(x);
+
+		switch (filter)
+		{
+		case EResampleFilter::Bilinear:
+			return x < 1.0 ? 1.0 - x : 0.0;
+		case EResampleFilter::Bicubic:
+		{
+			constexpr double a = -0.5;
+
+			if (x < 1.0)
+				return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+
+			if (x < 2.0)
+				return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+
+			return 0.0;
+		}
+		case EResampleFilter::Lanczos:
+			return x < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+		}
+
+		return 0.0;
+	}
+
+#if defined(UU_SSE2)
+	int32_t WeightPair(const int16_t * w)
+	{
+		uint32_t pair;
+
+		std::memcpy(&pair, w, sizeof(pair));
+
+		return static_cast<int32_t>(pair);
+	}
+#endif
+
+	uint8_t ClampChannel(int32_t sum)
+	{
+		const int32_t c = sum >> UU::RESAMPLE_WEIGHT_BITS;
+
+		return c < 0 ? 0 : c > 255 ? 255 : static_cast<uint8_t>(c);
+	}
+
+	// Fixed point rows. Sums start at half a unit and are shifted down, so they round to nearest, then clamp
+	// to a byte as the SIMD packs saturate.
+
+	// Each output pixel reads its taps a pair of pixels at a time, their channels interleaved so that one
+	// multiply-add weighs both and sums them per channel.
+	void ResampleRow(const CColour * in, CColour * out, const CResampleAxis & axis)
+	{
+		const size_t n = axis.OutSize();
+
+		if (axis.Identity())
+		{
+			std::memcpy(out, in, n * sizeof(CColour));
+			return;
+		}
+
+#if defined(UU_SSE2)
+		const size_t taps = axis.Taps();
+		const __m128i zero = _mm_setzero_si128(), half = _mm_set1_epi32(WEIGHT_HALF);
+
+		for (size_t x = 0; x < n; ++x)
+		{
+			const CColour * src = in + axis.First(x);
+			const int16_t * w = axis.Fixed(x);
+			__m128i acc = half;
+			size_t k = 0;
+
+			for (; k + 4 <= taps; k += 4)
+			{
+				const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k));
+				const __m128i low = _mm_unpacklo_epi8(pixels, zero), high = _mm_unpackhi_epi8(pixels, zero);
+
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(low, _mm_srli_si128(low, 8)), _mm_set1_epi32(WeightPair(w + k))));
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(high, _mm_srli_si128(high, 8)), _mm_set1_epi32(WeightPair(w + k + 2))));
+			}
+
+			for (; k + 2 <= taps; k += 2)
+			{
+				const __m128i low = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + k)), zero);
+
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(low, _mm_srli_si128(low, 8)), _mm_set1_epi32(WeightPair(w + k))));
+			}
+
+			if (k < taps)
+			{
+				uint32_t pixel;
+
+				std::memcpy(&pixel, src + k, sizeof(pixel));
+
+				const __m128i low = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int32_t>(pixel)), zero);
+
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(low, zero), _mm_set1_epi32(static_cast<uint16_t>(w[k]))));
+			}
+
+			const __m128i words = _mm_packs_epi32(_mm_srai_epi32(acc, UU::RESAMPLE_WEIGHT_BITS), zero);
+			const uint32_t pixel = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(words, zero)));
+
+			std::memcpy(static_cast<void *>(out + x), &pixel, sizeof(pixel));
+		}
+#else
+		const size_t taps = axis.Taps();
+
+		for (size_t x = 0; x < n; ++x)
+		{
+			const CColour * src = in + axis.First(x);
+			const int16_t * w = axis.Fixed(x);
+			int32_t r = WEIGHT_HALF, g = WEIGHT_HALF, b = WEIGHT_HALF, a = WEIGHT_HALF;
+
+			for (size_t k = 0; k < taps; ++k)
+			{
+				r += w[k] * src[k].r;
+				g += w[k] * src[k].g;
+				b += w[k] * src[k].b;
+				a += w[k] * src[k].a;
+			}
+
+			out[x] = CColour(ClampChannel(r), ClampChannel(g), ClampChannel(b), ClampChannel(a));
+		}
+#endif
+	}
+
+	// out[x] = sum of w[k] * rows[k][x]. Pairs of rows are interleaved byte by byte, so that each multiply-add
+	// weighs a channel of one pixel in both.
+	void ResampleColumns(const CColour * const * rows, const int16_t * w, size_t taps, CColour * out, size_t n)
+	{
+		size_t x = 0;
+
+#if defined(UU_AVX2)
+		{
+			const __m256i zero = _mm256_setzero_si256(), half = _mm256_set1_epi32(WEIGHT_HALF);
+
+			for (; x + 8 <= n; x += 8)
+			{
+				__m256i acc0 = half, acc1 = half, acc2 = half, acc3 = half;
+
+				for (size_t k = 0; k < taps; k += 2)
+				{
+					const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + x));
+					const __m256i b = k + 1 < taps ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k + 1] + x)) : zero;
+					const __m256i pair = _mm256_set1_epi32(k + 1 < taps ? WeightPair(w + k) : static_cast<uint16_t>(w[k]));
+					const __m256i low = _mm256_unpacklo_epi8(a, b), high = _mm256_unpackhi_epi8(a, b);
+
+					acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi8(low, zero), pair));
+					acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi8(low, zero), pair));
+					acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi8(high, zero), pair));
+					acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi8(high, zero), pair));
+				}
+
+				// Unpacking and packing both work within 128 bit lanes, so the pixels come back in order.
+				const __m256i first = _mm256_packs_epi32(_mm256_srai_epi32(acc0, UU::RESAMPLE_WEIGHT_BITS), _mm256_srai_epi32(acc1, UU::RESAMPLE_WEIGHT_BITS));
+				const __m256i second = _mm256_packs_epi32(_mm256_srai_epi32(acc2, UU::RESAMPLE_WEIGHT_BITS), _mm256_srai_epi32(acc3, UU::RESAMPLE_WEIGHT_BITS));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm256_packus_epi16(first, second));
+			}
+		}
+#endif
+
+#if defined(UU_SSE2)
+		{
+			const __m128i zero = _mm_setzero_si128(), half = _mm_set1_epi32(WEIGHT_HALF);
+
+			for (; x + 4 <= n; x += 4)
+			{
+				__m128i acc0 = half, acc1 = half, acc2 = half, acc3 = half;
+
+				for (size_t k = 0; k < taps; k += 2)
+				{
+					const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + x));
+					const __m128i b = k + 1 < taps ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k + 1] + x)) : zero;
+					const __m128i pair = _mm_set1_epi32(k + 1 < taps ? WeightPair(w + k) : static_cast<uint16_t>(w[k]));
+					const __m128i low = _mm_unpacklo_epi8(a, b), high = _mm_unpackhi_epi8(a, b);
+
+					acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi8(low, zero), pair));
+					acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi8(low, zero), pair));
+					acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi8(high, zero), pair));
+					acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi8(high, zero), pair));
+				}
+
+				const __m128i first = _mm_packs_epi32(_mm_srai_epi32(acc0, UU::RESAMPLE_WEIGHT_BITS), _mm_srai_epi32(acc1, UU::RESAMPLE_WEIGHT_BITS));
+				const __m128i second = _mm_packs_epi32(_mm_srai_epi32(acc2, UU::RESAMPLE_WEIGHT_BITS), _mm_srai_epi32(acc3, UU::RESAMPLE_WEIGHT_BITS));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(first, second));
+			}
+		}
+#endif
+
+		for (; x < n; ++x)
+		{
+			int32_t r = WEIGHT_HALF, g = WEIGHT_HALF, b = WEIGHT_HALF, a = WEIGHT_HALF;
+
+			for (size_t k = 0; k < taps; ++k)
+			{
+				const CColour & col = rows[k][x];
+
+				r += w[k] * col.r;
+				g += w[k] * col.g;
+				b += w[k] * col.b;
+				a += w[k] * col.a;
+			}
+
+			out[x] = CColour(ClampChannel(r), ClampChannel(g), ClampChannel(b), ClampChannel(a));
+		}
+	}
+
+	// Linear light rows, the channels of a pixel in a register.
+
+	void ResampleRow(const CLinearColour * in, float * out, const CResampleAxis & axis)
+	{
+		const size_t n = axis.OutSize(), taps = axis.Taps();
+		const float * src = reinterpret_cast<const float *>(in);
+
+		if (axis.Identity())
+		{
+			std::memcpy(out, src, 4 * n * sizeof(float));
+			return;
+		}
+
+		for (size_t x = 0; x < n; ++x)
+		{
+			const float * p = src + 4 * axis.First(x);
+			const float * w = axis.Weights(x);
+			F4 acc(0.f);
+
+			for (size_t k = 0; k < taps; ++k)
+				acc = MulAdd(F4(w[k]), F4::Load(p + 4 * k), acc);
+
+			acc.Store(out + 4 * x);
+		}
+	}
+
+	void ResampleColumns(const float * const * rows, const float * w, size_t taps, float * out, size_t n)
+	{
+		size_t i = 0;
+
+		for (; i + 2 * V::LANES <= n; i += 2 * V::LANES)
+		{
+			V acc0(0.f), acc1(0.f);
+
+			for (size_t k = 0; k < taps; ++k)
+			{
+				const V weight(w[k]);
+
+				acc0 = MulAdd(weight, V::Load(rows[k] + i), acc0);
+				acc1 = MulAdd(weight, V::Load(rows[k] + i + V::LANES), acc1);
+			}
+
+			acc0.Store(out + i);
+			acc1.Store(out + i + V::LANES);
+		}
+
+		for (; i < n; ++i)
+		{
+			float acc = 0.f;
+
+			for (size_t k = 0; k < taps; ++k)
+				acc += w[k] * rows[k][i];
+
+			out[i] = acc;
+		}
+	}
+
+	size_t BandGrain(const CResampleAxis & horizontal)
+	{
+		const size_t width = horizontal.OutSize();
+
+		return width > 0 ? (UU::RESAMPLE_PARALLEL_GRAIN + width - 1) / width : 1;
+	}
+
+	// Threads take bands of output rows. The input rows under a band's vertical windows are resampled
+	// horizontally into a ring of taps rows, row y in slot y % taps, each once as the windows move down.
+	template <typename TRow, typename Horizontal, typename Vertical>
+	void ResampleBands(const CResampleAxis & horizontal, const CResampleAxis & vertical, size_t row_size, Horizontal && filter_row, Vertical && filter_columns)
+	{
+		UU::ParallelFor(vertical.OutSize(), BandGrain(horizontal), [&](size_t chunk, size_t begin, size_t end)
+		{
+			const size_t taps = vertical.Taps();
+
+			std::vector<TRow, UU::CAlignedAllocator<TRow>> ring(taps * row_size);
+			std::vector<const TRow *> rows(taps);
+			size_t next = vertical.First(begin);
+
+			for (size_t y = begin; y < end; ++y)
+			{
+				const size_t first = vertical.First(y);
+
+				next = std::max(next, first);
+
+				for (; next < first + taps; ++next)
+					filter_row(chunk, next, ring.data() + next % taps * row_size);
+
+				for (size_t k = 0; k < taps; ++k)
+					rows[k] = ring.data() + (first + k) % taps * row_size;
+
+				filter_columns(chunk, y, rows.data());
+			}
+		});
+	}
+}
+
+UU::CResampleAxis::CResampleAxis(size_t in_size, size_t out_size, EResampleFilter filter)
+{
+	Build(in_size, out_size, filter);
+}
+
+void UU::CResampleAxis::Build(size_t in_size, size_t out_size, EResampleFilter filter)
+{
+	this->in_size = in_size;
+	identity = in_size == out_size;
+	taps = 0;
+	first.assign(out_size, 0);
+	fixed.clear();
+	weights.clear();
+
+	if (in_size == 0 || out_size == 0)
+		return;
+
+	if (identity)
+	{
+		taps = 1;
+		fixed.assign(out_size, static_cast<int16_t>(WEIGHT_ONE));
+		weights.assign(out_size, 1.f);
+
+		for (size_t i = 0; i < out_size; ++i)
+			first[i] = static_cast<uint32_t>(i);
+
+		return;
+	}
+
+	// Windows clipped to the input, then the widest sets taps.
+	const double scale = static_cast<double>(in_size) / static_cast<double>(out_size);
+	const double stretch = std::max(scale, 1.0);
+	const double support = Support(filter) * stretch;
+
+	std::vector<size_t> low(out_size), high(out_size);
+
+	for (size_t i = 0; i < out_size; ++i)
+	{
+		const double centre = (static_cast<double>(i) + 0.5) * scale;
+
+		low[i] = static_cast<size_t>(std::max(std::floor(centre - support + 0.5), 0.0));
+		high[i] = static_cast<size_t>(std::min(std::floor(centre + support + 0.5), static_cast<double>(in_size)));
+
+		if (high[i] <= low[i])
+		{
+			high[i] = std::min(low[i] + 1, in_size);
+			low[i] = high[i] - 1;
+		}
+
+		taps = std::max(taps, high[i] - low[i]);
+	}
+
+	fixed.assign(out_size * taps, 0);
+	weights.assign(out_size * taps, 0.f);
+
+	std::vector<double> window(taps);
+
+	for (size_t i = 0; i < out_size; ++i)
+	{
+		const double centre = (static_cast<double>(i) + 0.5) * scale;
+		const size_t start = std::min(low[i], in_size - taps), count = high[i] - low[i], offset = low[i] - start;
+
+		double total = 0;
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			window[k] = Kernel(filter, (static_cast<double>(low[i] + k) + 0.5 - centre) / stretch);
+			total += window[k];
+		}
+
+		// A window entirely on zeros of the kernel takes the nearest pixel.
+		if (total == 0.0)
+		{
+			std::fill(window.begin(), window.begin() + count, 0.0);
+			window[std::min(static_cast<size_t>(centre) - low[i], count - 1)] = 1.0;
+			total = 1.0;
+		}
+
+		first[i] = static_cast<uint32_t>(start);
+
+		float * w = weights.data() + i * taps + offset;
+		int16_t * q = fixed.data() + i * taps + offset;
+		int32_t sum = 0;
+		size_t largest = 0;
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			w[k] = static_cast<float>(window[k] / total);
+			q[k] = static_cast<int16_t>(std::lround(window[k] / total * WEIGHT_ONE));
+			sum += q[k];
+
+			if (std::fabs(window[k]) > std::fabs(window[largest]))
+				largest = k;
+		}
+
+		// Rounding error goes to the largest weight, so flat areas stay exactly flat.
+		q[largest] = static_cast<int16_t>(q[largest] + WEIGHT_ONE - sum);
+	}
+}
+
+size_t UU::CResampleAxis::InSize() const
+{
+	return in_size;
+}
+
+size_t UU::CResampleAxis::OutSize() const
+{
+	return first.size();
+}
+
+size_t UU::CResampleAxis::Taps() const
+{
+	return taps;
+}
+
+bool UU::CResampleAxis::Identity() const
+{
+	return identity;
+}
+
+size_t UU::CResampleAxis::First(size_t i) const
+{
+	return first[i];
+}
+
+const int16_t * UU::CResampleAxis::Fixed(size_t i) const
+{
+	return fixed.data() + i * taps;
+}
+
+const float * UU::CResampleAxis::Weights(size_t i) const
+{
+	return weights.data() + i * taps;
+}
+
+UU::CResampler::CResampler(size_t in_width, size_t in_height, size_t out_width, size_t out_height, EResampleFilter filter)
+{
+	Build(in_width, in_height, out_width, out_height, filter);
+}
+
+void UU::CResampler::Build(size_t in_width, size_t in_height, size_t out_width, size_t out_height, EResampleFilter filter)
+{
+	horizontal.Build(in_width, out_width, filter);
+	vertical.Build(in_height, out_height, filter);
+}
+
+void UU::CResampler::Resize(CImageView<const CColour> in, CImageView<CColour> out, bool gamma_correct) const
+{
+	const size_t width = horizontal.OutSize();
+
+	if (width == 0 || vertical.OutSize() == 0 || horizontal.InSize() == 0 || vertical.InSize() == 0)
+		return;
+
+	if (horizontal.Identity() && vertical.Identity())
+	{
+		ParallelForRows(out, [&](size_t y, CSpan<CColour> row) { std::memcpy(row.Data(), in.Row(y), row.Size() * sizeof(CColour)); });
+		return;
+	}
+
+	if (!gamma_correct)
+	{
+		ResampleBands<CColour>(horizontal, vertical, width,
+			[&](size_t, size_t y, CColour * row) { ResampleRow(in.Row(y), row, horizontal); },
+			[&](size_t, size_t y, const CColour * const * rows) { ResampleColumns(rows, vertical.Fixed(y), vertical.Taps(), out.Row(y), width); });
+
+		return;
+	}
+
+	// A linear row per thread, decoded into before the horizontal pass and encoded from after the vertical.
+	std::vector<std::vector<CLinearColour>> linear(ParallelChunkCount(vertical.OutSize(), BandGrain(horizontal)));
+
+	for (auto & row : linear)
+		row.resize(std::max(in.Width(), width));
+
+	ResampleBands<float>(horizontal, vertical, 4 * width,
+		[&](size_t chunk, size_t y, float * row)
+		{
+			ToLinear(CSpan<const CColour>(in.Row(y), in.Width()), CSpan<CLinearColour>(linear[chunk].data(), in.Width()));
+			ResampleRow(linear[chunk].data(), row, horizontal);
+		},
+		[&](size_t chunk, size_t y, const float * const * rows)
+		{
+			ResampleColumns(rows, vertical.Weights(y), vertical.Taps(), reinterpret_cast<float *>(linear[chunk].data()), 4 * width);
+			ToColour(CSpan<const CLinearColour>(linear[chunk].data(), width), out.RowSpan(y));
+		});
+}
+
+const UU::CResampleAxis & UU::CResampler::Horizontal() const
+{
+	return horizontal;
+}
+
+const UU::CResampleAxis & UU::CResampler::Vertical() const
+{
+	return vertical;
+}
+
+void UU::Resize(CImageView<const CColour> in, CImageView<CColour> out, EResampleFilter filter, bool gamma_correct)
+{
+	CResampler(in.Width(), in.Height(), out.Width(), out.Height(), filter).Resize(in, out, gamma_correct);
+}
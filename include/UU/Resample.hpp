@@ -0,0 +1,95 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Colour.hpp"
+#include "Image.hpp"
+#include "Memory.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace UU
+{
+	enum class EResampleFilter : uint8_t
+	{
+		Bilinear,		// Triangle, support 1
+		Bicubic,		// Keys cubic with a = -0.5, support 2
+		Lanczos			// Lanczos windowed sinc, support 3
+	};
+
+	constexpr size_t RESAMPLE_PARALLEL_GRAIN = 1 << 14;
+
+	// Fraction bits of the fixed point weights, which are int16 so that the inner loops multiply pairs of
+	// pixels at a time.
+	constexpr int32_t RESAMPLE_WEIGHT_BITS = 14;
+
+	// Weights of every output pixel along one axis, taps of them from First(i) on. When downsampling the filter
+	// is stretched by the scale, so every input pixel contributes. Windows are clipped to the input and shifted
+	// to fit in it, so taps is the same for all outputs and no reads go past the edge.
+	class CResampleAxis final
+	{
+	private:
+
+		std::vector<uint32_t>								first;
+		std::vector<int16_t, CAlignedAllocator<int16_t>>	fixed;
+		std::vector<float, CAlignedAllocator<float>>		weights;
+		size_t												in_size = 0;
+		size_t												taps = 0;
+		bool												identity = false;
+
+	public:
+
+		CResampleAxis() = default;
+
+		CResampleAxis(size_t in_size, size_t out_size, EResampleFilter filter);
+
+		void					Build(size_t in_size, size_t out_size, EResampleFilter filter);
+
+		size_t					InSize() const;
+		size_t					OutSize() const;
+		size_t					Taps() const;
+
+		// Same size in and out, every output being the input pixel under it.
+		bool					Identity() const;
+
+		size_t					First(size_t i) const;
+
+		// Weights summing to exactly 1 << RESAMPLE_WEIGHT_BITS, and the float weights they are rounded from.
+		const int16_t *			Fixed(size_t i) const;
+		const float *			Weights(size_t i) const;
+	};
+
+	// Precomputed weights for resizing images of one size to another, reusable across images. Resizing runs a
+	// horizontal pass into a ring of rows per thread and a vertical pass out of it, threads taking bands of
+	// output rows. Without gamma correction both passes are integer, weights applied to pairs of pixels in
+	// SSE2 multiply-adds and the horizontal result rounded to 8 bits. With it, pixels are decoded to linear
+	// light and filtered in float. Every channel is filtered on its own, so premultiply images with
+	// transparency to keep hidden colours from bleeding.
+	class CResampler final
+	{
+	private:
+
+		CResampleAxis	horizontal;
+		CResampleAxis	vertical;
+
+	public:
+
+		CResampler() = default;
+
+		CResampler(size_t in_width, size_t in_height, size_t out_width, size_t out_height, EResampleFilter filter = EResampleFilter::Bicubic);
+
+		void					Build(size_t in_width, size_t in_height, size_t out_width, size_t out_height, EResampleFilter filter = EResampleFilter::Bicubic);
+
+		// in and out have the sizes given to Build and must not overlap.
+		void					Resize(CImageView<const CColour> in, CImageView<CColour> out, bool gamma_correct = false) const;
+
+		const CResampleAxis &	Horizontal() const;
+		const CResampleAxis &	Vertical() const;
+	};
+
+	// Resizes in to the size of out with a CResampler built for the pair.
+	void				Resize(CImageView<const CColour> in, CImageView<CColour> out, EResampleFilter filter = EResampleFilter::Bicubic, bool gamma_correct = false);
+}
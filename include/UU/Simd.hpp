@@ -0,0 +1,1183 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+// Instruction set selection follows the compiler flags (/arch:AVX2, -mavx2, ...).
+// Every kernel using these has a scalar fallback, so defining UU_NO_SIMD forces the portable path.
+
+#if !defined(UU_NO_SIMD)
+	#if defined(__AVX512F__)
+		#define UU_AVX512 1
+	#endif
+
+	#if defined(__AVX2__)
+		#define UU_AVX2 1
+	#endif
+
+	#if defined(__AVX__) || defined(__AVX2__)
+		#define UU_AVX 1
+	#endif
+
+	#if defined(__SSE4_1__) || defined(__AVX__)
+		#define UU_SSE4 1
+	#endif
+
+	#if defined(__SSSE3__) || defined(__SSE4_1__) || defined(__AVX__)
+		#define UU_SSSE3 1
+	#endif
+
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define UU_SSE2 1
+	#endif
+
+	#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+		#define UU_FMA 1
+	#endif
+
+	#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+		#define UU_BMI2 1
+	#endif
+#endif
+
+#if defined(UU_SSE2)
+	#include <immintrin.h>
+#endif
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace UU
+{
+	// Lane flags produced by CSimd comparisons.
+	template <typename T, size_t lanes>
+	class CSimdMask
+	{
+	public:
+		bool m[lanes];
+
+		CSimdMask operator&(const CSimdMask & o) const { CSimdMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = m[i] && o.m[i]; return r; }
+		CSimdMask operator|(const CSimdMask & o) const { CSimdMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = m[i] || o.m[i]; return r; }
+		CSimdMask operator!() const { CSimdMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = !m[i]; return r; }
+	};
+
+	// Fixed width vector of float or double for writing a kernel once over every instruction set.
+	// The primary template is a plain array the compiler is free to vectorise, the specialisations
+	// below hold an SSE2, AVX2 or AVX-512 register and are used whenever the matching UU_ macro is set.
+	template <typename T, size_t lanes>
+	class CSimd
+	{
+	public:
+		using TScalar = T;
+		using TMask = CSimdMask<T, lanes>;
+
+		static constexpr size_t LANES = lanes;
+
+		T v[lanes];
+
+		CSimd() = default;
+		CSimd(T x) { for (size_t i = 0; i < lanes; ++i) v[i] = x; }
+
+		static CSimd Load(const T * p) { CSimd r; for (size_t i = 0; i < lanes; ++i) r.v[i] = p[i]; return r; }
+		void Store(T * p) const { for (size_t i = 0; i < lanes; ++i) p[i] = v[i]; }
+
+		CSimd operator-() const { CSimd r; for (size_t i = 0; i < lanes; ++i) r.v[i] = -v[i]; return r; }
+		CSimd operator+(const CSimd & o) const { CSimd r; for (size_t i = 0; i < lanes; ++i) r.v[i] = v[i] + o.v[i]; return r; }
+		CSimd operator-(const CSimd & o) const { CSimd r; for (size_t i = 0; i < lanes; ++i) r.v[i] = v[i] - o.v[i]; return r; }
+		CSimd operator*(const CSimd & o) const { CSimd r; for (size_t i = 0; i < lanes; ++i) r.v[i] = v[i] * o.v[i]; return r; }
+		CSimd operator/(const CSimd & o) const { CSimd r; for (size_t i = 0; i < lanes; ++i) r.v[i] = v[i] / o.v[i]; return r; }
+
+		TMask operator<(const CSimd & o) const { TMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = v[i] < o.v[i]; return r; }
+		TMask operator<=(const CSimd & o) const { TMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = v[i] <= o.v[i]; return r; }
+		TMask operator>(const CSimd & o) const { TMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = v[i] > o.v[i]; return r; }
+		TMask operator>=(const CSimd & o) const { TMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = v[i] >= o.v[i]; return r; }
+		TMask operator==(const CSimd & o) const { TMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = v[i] == o.v[i]; return r; }
+		TMask operator!=(const CSimd & o) const { TMask r; for (size_t i = 0; i < lanes; ++i) r.m[i] = v[i] != o.v[i]; return r; }
+	};
+
+#if defined(UU_AVX512)
+	constexpr size_t SIMD_FLOAT_LANES = 16;
+	constexpr size_t SIMD_DOUBLE_LANES = 8;
+#elif defined(UU_AVX2)
+	constexpr size_t SIMD_FLOAT_LANES = 8;
+	constexpr size_t SIMD_DOUBLE_LANES = 4;
+#else
+	constexpr size_t SIMD_FLOAT_LANES = 4;
+	constexpr size_t SIMD_DOUBLE_LANES = 2;
+#endif
+
+	// The widest CSimd the build targets for float or double.
+	template <typename T>
+	using CSimdNative = CSimd<T, sizeof(T) == sizeof(float) ? SIMD_FLOAT_LANES : SIMD_DOUBLE_LANES>;
+
+	template <typename T, size_t lanes>
+	bool Any(const CSimdMask<T, lanes> & a);
+	template <typename T, size_t lanes>
+	bool All(const CSimdMask<T, lanes> & a);
+
+	// Bit i set when lane i is set.
+	template <typename T, size_t lanes>
+	uint32_t MoveMask(const CSimdMask<T, lanes> & a);
+
+	// Per lane mask ? a : b.
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Select(const CSimdMask<T, lanes> & mask, const CSimd<T, lanes> & a, const CSimd<T, lanes> & b);
+
+	// a * b + c, fused when UU_FMA is set.
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> MulAdd(const CSimd<T, lanes> & a, const CSimd<T, lanes> & b, const CSimd<T, lanes> & c);
+
+	// Min and Max return b when either lane is NaN, like minps/maxps.
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Min(const CSimd<T, lanes> & a, const CSimd<T, lanes> & b);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Max(const CSimd<T, lanes> & a, const CSimd<T, lanes> & b);
+
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Abs(const CSimd<T, lanes> & a);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Sqrt(const CSimd<T, lanes> & a);
+
+	// Round to nearest, ties to even.
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Round(const CSimd<T, lanes> & a);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Floor(const CSimd<T, lanes> & a);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Ceil(const CSimd<T, lanes> & a);
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Trunc(const CSimd<T, lanes> & a);
+
+	// Magnitude of mag with the sign bit of sign.
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> CopySign(const CSimd<T, lanes> & mag, const CSimd<T, lanes> & sign);
+
+	// 2^n for integral n within the normal exponent range.
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Pow2i(const CSimd<T, lanes> & n);
+
+	// Splits a positive normal x into a mantissa in [1, 2) and an integral exponent.
+	template <typename T, size_t lanes>
+	CSimd<T, lanes> Frexp(const CSimd<T, lanes> & x, CSimd<T, lanes> & exponent);
+
+	// Lanes where the two's complement integer held by an integral valued q shares any set bit with mask,
+	// |q| < 2^31 for float and 2^51 for double.
+	template <typename T, size_t lanes>
+	CSimdMask<T, lanes> TestBit(const CSimd<T, lanes> & q, int32_t mask);
+
+	// Float to double halves and back.
+	template <size_t lanes>
+	CSimd<double, lanes / 2> WidenLow(const CSimd<float, lanes> & a);
+	template <size_t lanes>
+	CSimd<double, lanes / 2> WidenHigh(const CSimd<float, lanes> & a);
+	template <size_t lanes>
+	CSimd<float, lanes * 2> Narrow(const CSimd<double, lanes> & low, const CSimd<double, lanes> & high);
+
+	// Stores integral valued lanes as int32_t, saturating lanes outside the int32_t range and storing NaN as 0.
+	template <typename T, size_t lanes>
+	void StoreInt32(const CSimd<T, lanes> & a, int32_t * out);
+}
+
+template <typename T, size_t lanes>
+bool UU::Any(const CSimdMask<T, lanes> & a)
+{
+	for (size_t i = 0; i < lanes; ++i)
+	{
+		if (a.m[i])
+			return true;
+	}
+
+	return false;
+}
+
+template <typename T, size_t lanes>
+bool UU::All(const CSimdMask<T, lanes> & a)
+{
+	for (size_t i = 0; i < lanes; ++i)
+	{
+		if (!a.m[i])
+			return false;
+	}
+
+	return true;
+}
+
+template <typename T, size_t lanes>
+uint32_t UU::MoveMask(const CSimdMask<T, lanes> & a)
+{
+	uint32_t bits = 0;
+
+	for (size_t i = 0; i < lanes; ++i)
+		bits |= static_cast<uint32_t>(a.m[i]) << i;
+
+	return bits;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Select(const CSimdMask<T, lanes> & mask, const CSimd<T, lanes> & a, const CSimd<T, lanes> & b)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = mask.m[i] ? a.v[i] : b.v[i];
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::MulAdd(const CSimd<T, lanes> & a, const CSimd<T, lanes> & b, const CSimd<T, lanes> & c)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+	{
+#if defined(UU_FMA)
+		r.v[i] = std::fma(a.v[i], b.v[i], c.v[i]);
+#else
+		r.v[i] = a.v[i] * b.v[i] + c.v[i];
+#endif
+	}
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Min(const CSimd<T, lanes> & a, const CSimd<T, lanes> & b)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Max(const CSimd<T, lanes> & a, const CSimd<T, lanes> & b)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Abs(const CSimd<T, lanes> & a)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = std::fabs(a.v[i]);
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Sqrt(const CSimd<T, lanes> & a)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = std::sqrt(a.v[i]);
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Round(const CSimd<T, lanes> & a)
+{
+	// Adding and removing 2^(digits - 1) rounds to an integer in the default rounding mode without a libm call.
+	const T magic = T(1) / std::numeric_limits<T>::epsilon();
+
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+	{
+		const T m = std::fabs(a.v[i]);
+
+		r.v[i] = std::copysign(m < magic ? (m + magic) - magic : m, a.v[i]);
+	}
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Floor(const CSimd<T, lanes> & a)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = std::floor(a.v[i]);
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Ceil(const CSimd<T, lanes> & a)
+{
+	return -Floor(-a);
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Trunc(const CSimd<T, lanes> & a)
+{
+	return CopySign(Floor(Abs(a)), a);
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::CopySign(const CSimd<T, lanes> & mag, const CSimd<T, lanes> & sign)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = std::copysign(mag.v[i], sign.v[i]);
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Pow2i(const CSimd<T, lanes> & n)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.v[i] = std::ldexp(T(1), static_cast<int>(n.v[i]));
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimd<T, lanes> UU::Frexp(const CSimd<T, lanes> & x, CSimd<T, lanes> & exponent)
+{
+	CSimd<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+	{
+		int e;
+		r.v[i] = std::frexp(x.v[i], &e) * T(2);
+		exponent.v[i] = static_cast<T>(e - 1);
+	}
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+UU::CSimdMask<T, lanes> UU::TestBit(const CSimd<T, lanes> & q, int32_t mask)
+{
+	CSimdMask<T, lanes> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+		r.m[i] = (static_cast<int64_t>(q.v[i]) & mask) != 0;
+
+	return r;
+}
+
+template <size_t lanes>
+UU::CSimd<double, lanes / 2> UU::WidenLow(const CSimd<float, lanes> & a)
+{
+	CSimd<double, lanes / 2> r;
+
+	for (size_t i = 0; i < lanes / 2; ++i)
+		r.v[i] = a.v[i];
+
+	return r;
+}
+
+template <size_t lanes>
+UU::CSimd<double, lanes / 2> UU::WidenHigh(const CSimd<float, lanes> & a)
+{
+	CSimd<double, lanes / 2> r;
+
+	for (size_t i = 0; i < lanes / 2; ++i)
+		r.v[i] = a.v[lanes / 2 + i];
+
+	return r;
+}
+
+template <size_t lanes>
+UU::CSimd<float, lanes * 2> UU::Narrow(const CSimd<double, lanes> & low, const CSimd<double, lanes> & high)
+{
+	CSimd<float, lanes * 2> r;
+
+	for (size_t i = 0; i < lanes; ++i)
+	{
+		r.v[i] = static_cast<float>(low.v[i]);
+		r.v[lanes + i] = static_cast<float>(high.v[i]);
+	}
+
+	return r;
+}
+
+template <typename T, size_t lanes>
+void UU::StoreInt32(const CSimd<T, lanes> & a, int32_t * out)
+{
+	for (size_t i = 0; i < lanes; ++i)
+	{
+		const T v = a.v[i];
+
+		if (v != v)
+			out[i] = 0;
+		else if (v >= T(2147483648.0))
+			out[i] = std::numeric_limits<int32_t>::max();
+		else if (v <= T(-2147483648.0))
+			out[i] = std::numeric_limits<int32_t>::min();
+		else
+			out[i] = static_cast<int32_t>(v);
+	}
+}
+
+#if defined(UU_SSE2)
+namespace UU
+{
+	template <>
+	class CSimdMask<float, 4>
+	{
+	public:
+		__m128 m;
+
+		CSimdMask() = default;
+		CSimdMask(__m128 x) : m(x) {}
+
+		CSimdMask operator&(const CSimdMask & o) const { return _mm_and_ps(m, o.m); }
+		CSimdMask operator|(const CSimdMask & o) const { return _mm_or_ps(m, o.m); }
+		CSimdMask operator!() const { return _mm_xor_ps(m, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+	};
+
+	template <>
+	class CSimd<float, 4>
+	{
+	public:
+		using TScalar = float;
+		using TMask = CSimdMask<float, 4>;
+
+		static constexpr size_t LANES = 4;
+
+		__m128 v;
+
+		CSimd() = default;
+		CSimd(float x) : v(_mm_set1_ps(x)) {}
+		CSimd(__m128 x) : v(x) {}
+
+		static CSimd Load(const float * p) { return _mm_loadu_ps(p); }
+		void Store(float * p) const { _mm_storeu_ps(p, v); }
+
+		CSimd operator-() const { return _mm_xor_ps(v, _mm_set1_ps(-0.f)); }
+		CSimd operator+(const CSimd & o) const { return _mm_add_ps(v, o.v); }
+		CSimd operator-(const CSimd & o) const { return _mm_sub_ps(v, o.v); }
+		CSimd operator*(const CSimd & o) const { return _mm_mul_ps(v, o.v); }
+		CSimd operator/(const CSimd & o) const { return _mm_div_ps(v, o.v); }
+
+		TMask operator<(const CSimd & o) const { return _mm_cmplt_ps(v, o.v); }
+		TMask operator<=(const CSimd & o) const { return _mm_cmple_ps(v, o.v); }
+		TMask operator>(const CSimd & o) const { return _mm_cmpgt_ps(v, o.v); }
+		TMask operator>=(const CSimd & o) const { return _mm_cmpge_ps(v, o.v); }
+		TMask operator==(const CSimd & o) const { return _mm_cmpeq_ps(v, o.v); }
+		TMask operator!=(const CSimd & o) const { return _mm_cmpneq_ps(v, o.v); }
+	};
+
+	template <>
+	class CSimdMask<double, 2>
+	{
+	public:
+		__m128d m;
+
+		CSimdMask() = default;
+		CSimdMask(__m128d x) : m(x) {}
+
+		CSimdMask operator&(const CSimdMask & o) const { return _mm_and_pd(m, o.m); }
+		CSimdMask operator|(const CSimdMask & o) const { return _mm_or_pd(m, o.m); }
+		CSimdMask operator!() const { return _mm_xor_pd(m, _mm_castsi128_pd(_mm_set1_epi32(-1))); }
+	};
+
+	template <>
+	class CSimd<double, 2>
+	{
+	public:
+		using TScalar = double;
+		using TMask = CSimdMask<double, 2>;
+
+		static constexpr size_t LANES = 2;
+
+		__m128d v;
+
+		CSimd() = default;
+		CSimd(double x) : v(_mm_set1_pd(x)) {}
+		CSimd(__m128d x) : v(x) {}
+
+		static CSimd Load(const double * p) { return _mm_loadu_pd(p); }
+		void Store(double * p) const { _mm_storeu_pd(p, v); }
+
+		CSimd operator-() const { return _mm_xor_pd(v, _mm_set1_pd(-0.0)); }
+		CSimd operator+(const CSimd & o) const { return _mm_add_pd(v, o.v); }
+		CSimd operator-(const CSimd & o) const { return _mm_sub_pd(v, o.v); }
+		CSimd operator*(const CSimd & o) const { return _mm_mul_pd(v, o.v); }
+		CSimd operator/(const CSimd & o) const { return _mm_div_pd(v, o.v); }
+
+		TMask operator<(const CSimd & o) const { return _mm_cmplt_pd(v, o.v); }
+		TMask operator<=(const CSimd & o) const { return _mm_cmple_pd(v, o.v); }
+		TMask operator>(const CSimd & o) const { return _mm_cmpgt_pd(v, o.v); }
+		TMask operator>=(const CSimd & o) const { return _mm_cmpge_pd(v, o.v); }
+		TMask operator==(const CSimd & o) const { return _mm_cmpeq_pd(v, o.v); }
+		TMask operator!=(const CSimd & o) const { return _mm_cmpneq_pd(v, o.v); }
+	};
+
+	using CSimd4f = CSimd<float, 4>;
+	using CSimd2d = CSimd<double, 2>;
+
+	inline bool Any(const CSimdMask<float, 4> & a) { return _mm_movemask_ps(a.m) != 0; }
+	inline bool All(const CSimdMask<float, 4> & a) { return _mm_movemask_ps(a.m) == 0xf; }
+	inline uint32_t MoveMask(const CSimdMask<float, 4> & a) { return static_cast<uint32_t>(_mm_movemask_ps(a.m)); }
+
+	inline CSimd4f Select(const CSimdMask<float, 4> & mask, const CSimd4f & a, const CSimd4f & b)
+	{
+#if defined(UU_SSE4)
+		return _mm_blendv_ps(b.v, a.v, mask.m);
+#else
+		return _mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v));
+#endif
+	}
+
+	inline CSimd4f Min(const CSimd4f & a, const CSimd4f & b) { return _mm_min_ps(a.v, b.v); }
+	inline CSimd4f Max(const CSimd4f & a, const CSimd4f & b) { return _mm_max_ps(a.v, b.v); }
+	inline CSimd4f Abs(const CSimd4f & a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v); }
+	inline CSimd4f Sqrt(const CSimd4f & a) { return _mm_sqrt_ps(a.v); }
+
+	inline CSimd4f CopySign(const CSimd4f & mag, const CSimd4f & sign)
+	{
+		const __m128 s = _mm_set1_ps(-0.f);
+
+		return _mm_or_ps(_mm_andnot_ps(s, mag.v), _mm_and_ps(s, sign.v));
+	}
+
+	inline CSimd4f Round(const CSimd4f & a)
+	{
+#if defined(UU_SSE4)
+		return _mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+#else
+		// Same 2^23 trick as the portable path, larger values are already integral.
+		const __m128 magic = _mm_set1_ps(8388608.f);
+		const __m128 m = Abs(a).v;
+		const __m128 r = _mm_sub_ps(_mm_add_ps(m, magic), magic);
+
+		return CopySign(Select(_mm_cmplt_ps(m, magic), CSimd4f(r), CSimd4f(m)), a);
+#endif
+	}
+
+	inline CSimd4f Floor(const CSimd4f & a)
+	{
+#if defined(UU_SSE4)
+		return _mm_floor_ps(a.v);
+#else
+		const CSimd4f r = Round(a);
+
+		return Select(r > a, r - CSimd4f(1.f), r);
+#endif
+	}
+
+	inline CSimd4f MulAdd(const CSimd4f & a, const CSimd4f & b, const CSimd4f & c)
+	{
+#if defined(UU_FMA)
+		return _mm_fmadd_ps(a.v, b.v, c.v);
+#else
+		return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v);
+#endif
+	}
+
+	inline CSimd4f Pow2i(const CSimd4f & n)
+	{
+		return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127)), 23));
+	}
+
+	inline CSimd4f Frexp(const CSimd4f & x, CSimd4f & exponent)
+	{
+		const __m128i bits = _mm_castps_si128(x.v);
+		const __m128i e = _mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff));
+
+		exponent = _mm_cvtepi32_ps(_mm_sub_epi32(e, _mm_set1_epi32(127)));
+
+		return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x807fffff)), _mm_set1_epi32(0x3f800000)));
+	}
+
+	inline CSimdMask<float, 4> TestBit(const CSimd4f & q, int32_t mask)
+	{
+		const __m128i none = _mm_cmpeq_epi32(_mm_and_si128(_mm_cvtps_epi32(q.v), _mm_set1_epi32(mask)), _mm_setzero_si128());
+
+		return _mm_castsi128_ps(_mm_xor_si128(none, _mm_set1_epi32(-1)));
+	}
+
+	inline bool Any(const CSimdMask<double, 2> & a) { return _mm_movemask_pd(a.m) != 0; }
+	inline bool All(const CSimdMask<double, 2> & a) { return _mm_movemask_pd(a.m) == 0x3; }
+	inline uint32_t MoveMask(const CSimdMask<double, 2> & a) { return static_cast<uint32_t>(_mm_movemask_pd(a.m)); }
+
+	inline CSimd2d Select(const CSimdMask<double, 2> & mask, const CSimd2d & a, const CSimd2d & b)
+	{
+#if defined(UU_SSE4)
+		return _mm_blendv_pd(b.v, a.v, mask.m);
+#else
+		return _mm_or_pd(_mm_and_pd(mask.m, a.v), _mm_andnot_pd(mask.m, b.v));
+#endif
+	}
+
+	inline CSimd2d Min(const CSimd2d & a, const CSimd2d & b) { return _mm_min_pd(a.v, b.v); }
+	inline CSimd2d Max(const CSimd2d & a, const CSimd2d & b) { return _mm_max_pd(a.v, b.v); }
+	inline CSimd2d Abs(const CSimd2d & a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a.v); }
+	inline CSimd2d Sqrt(const CSimd2d & a) { return _mm_sqrt_pd(a.v); }
+
+	inline CSimd2d CopySign(const CSimd2d & mag, const CSimd2d & sign)
+	{
+		const __m128d s = _mm_set1_pd(-0.0);
+
+		return _mm_or_pd(_mm_andnot_pd(s, mag.v), _mm_and_pd(s, sign.v));
+	}
+
+	inline CSimd2d Round(const CSimd2d & a)
+	{
+#if defined(UU_SSE4)
+		return _mm_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+#else
+		const __m128d magic = _mm_set1_pd(4503599627370496.0);
+		const __m128d m = Abs(a).v;
+		const __m128d r = _mm_sub_pd(_mm_add_pd(m, magic), magic);
+
+		return CopySign(Select(_mm_cmplt_pd(m, magic), CSimd2d(r), CSimd2d(m)), a);
+#endif
+	}
+
+	inline CSimd2d Floor(const CSimd2d & a)
+	{
+#if defined(UU_SSE4)
+		return _mm_floor_pd(a.v);
+#else
+		const CSimd2d r = Round(a);
+
+		return Select(r > a, r - CSimd2d(1.0), r);
+#endif
+	}
+
+	inline CSimd2d MulAdd(const CSimd2d & a, const CSimd2d & b, const CSimd2d & c)
+	{
+#if defined(UU_FMA)
+		return _mm_fmadd_pd(a.v, b.v, c.v);
+#else
+		return _mm_add_pd(_mm_mul_pd(a.v, b.v), c.v);
+#endif
+	}
+
+	// Packed int64 conversion needs AVX-512DQ, adding 1.5 * 2^52 leaves the integer in the low mantissa bits.
+	inline __m128i SimdToInt64(const CSimd2d & q)
+	{
+		const __m128d magic = _mm_set1_pd(6755399441055744.0);
+
+		return _mm_sub_epi64(_mm_castpd_si128(_mm_add_pd(q.v, magic)), _mm_castpd_si128(magic));
+	}
+
+	inline CSimd2d Pow2i(const CSimd2d & n)
+	{
+		return _mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(SimdToInt64(n), _mm_set1_epi64x(1023)), 52));
+	}
+
+	inline CSimd2d Frexp(const CSimd2d & x, CSimd2d & exponent)
+	{
+		const __m128i bits = _mm_castpd_si128(x.v);
+		const __m128i e = _mm_and_si128(_mm_srli_epi64(bits, 52), _mm_set1_epi64x(0x7ff));
+		const __m128d two52 = _mm_castsi128_pd(_mm_set1_epi64x(0x4330000000000000));
+
+		exponent = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(e, _mm_castpd_si128(two52))), _mm_add_pd(two52, _mm_set1_pd(1023.0)));
+
+		return _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(0x800fffffffffffff)),
+			_mm_set1_epi64x(0x3ff0000000000000)));
+	}
+
+	inline CSimdMask<double, 2> TestBit(const CSimd2d & q, int32_t mask)
+	{
+		const __m128i zero = _mm_cmpeq_epi32(_mm_and_si128(SimdToInt64(q), _mm_set1_epi64x(mask)), _mm_setzero_si128());
+
+		// A lane has no bit in common when both of its dwords are zero.
+		const __m128i none = _mm_and_si128(zero, _mm_shuffle_epi32(zero, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		return _mm_castsi128_pd(_mm_xor_si128(none, _mm_set1_epi32(-1)));
+	}
+
+	inline CSimd2d WidenLow(const CSimd4f & a) { return _mm_cvtps_pd(a.v); }
+	inline CSimd2d WidenHigh(const CSimd4f & a) { return _mm_cvtps_pd(_mm_movehl_ps(a.v, a.v)); }
+	inline CSimd4f Narrow(const CSimd2d & low, const CSimd2d & high) { return _mm_movelh_ps(_mm_cvtpd_ps(low.v), _mm_cvtpd_ps(high.v)); }
+
+	inline void StoreInt32(const CSimd4f & a, int32_t * out)
+	{
+		// cvttps2dq gives 0x80000000 for NaN and out of range lanes, flipped to 0x7fffffff for lanes >= 2^31 and cleared for NaN.
+		const __m128i i = _mm_cvttps_epi32(a.v);
+		const __m128i over = _mm_castps_si128(_mm_cmpge_ps(a.v, _mm_set1_ps(2147483648.f)));
+		const __m128i ordered = _mm_castps_si128(_mm_cmpord_ps(a.v, a.v));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_and_si128(_mm_xor_si128(i, over), ordered));
+	}
+
+	inline void StoreInt32(const CSimd2d & a, int32_t * out)
+	{
+		// The int32_t range is exact in double, so NaN is zeroed and the rest clamped before converting.
+		const __m128d x = _mm_and_pd(a.v, _mm_cmpord_pd(a.v, a.v));
+		const __m128d c = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(-2147483648.0)), _mm_set1_pd(2147483647.0));
+
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_cvttpd_epi32(c));
+	}
+}
+#endif
+
+#if defined(UU_AVX2)
+namespace UU
+{
+	template <>
+	class CSimdMask<float, 8>
+	{
+	public:
+		__m256 m;
+
+		CSimdMask() = default;
+		CSimdMask(__m256 x) : m(x) {}
+
+		CSimdMask operator&(const CSimdMask & o) const { return _mm256_and_ps(m, o.m); }
+		CSimdMask operator|(const CSimdMask & o) const { return _mm256_or_ps(m, o.m); }
+		CSimdMask operator!() const { return _mm256_xor_ps(m, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+	};
+
+	template <>
+	class CSimd<float, 8>
+	{
+	public:
+		using TScalar = float;
+		using TMask = CSimdMask<float, 8>;
+
+		static constexpr size_t LANES = 8;
+
+		__m256 v;
+
+		CSimd() = default;
+		CSimd(float x) : v(_mm256_set1_ps(x)) {}
+		CSimd(__m256 x) : v(x) {}
+
+		static CSimd Load(const float * p) { return _mm256_loadu_ps(p); }
+		void Store(float * p) const { _mm256_storeu_ps(p, v); }
+
+		CSimd operator-() const { return _mm256_xor_ps(v, _mm256_set1_ps(-0.f)); }
+		CSimd operator+(const CSimd & o) const { return _mm256_add_ps(v, o.v); }
+		CSimd operator-(const CSimd & o) const { return _mm256_sub_ps(v, o.v); }
+		CSimd operator*(const CSimd & o) const { return _mm256_mul_ps(v, o.v); }
+		CSimd operator/(const CSimd & o) const { return _mm256_div_ps(v, o.v); }
+
+		TMask operator<(const CSimd & o) const { return _mm256_cmp_ps(v, o.v, _CMP_LT_OQ); }
+		TMask operator<=(const CSimd & o) const { return _mm256_cmp_ps(v, o.v, _CMP_LE_OQ); }
+		TMask operator>(const CSimd & o) const { return _mm256_cmp_ps(v, o.v, _CMP_GT_OQ); }
+		TMask operator>=(const CSimd & o) const { return _mm256_cmp_ps(v, o.v, _CMP_GE_OQ); }
+		TMask operator==(const CSimd & o) const { return _mm256_cmp_ps(v, o.v, _CMP_EQ_OQ); }
+		TMask operator!=(const CSimd & o) const { return _mm256_cmp_ps(v, o.v, _CMP_NEQ_UQ); }
+	};
+
+	template <>
+	class CSimdMask<double, 4>
+	{
+	public:
+		__m256d m;
+
+		CSimdMask() = default;
+		CSimdMask(__m256d x) : m(x) {}
+
+		CSimdMask operator&(const CSimdMask & o) const { return _mm256_and_pd(m, o.m); }
+		CSimdMask operator|(const CSimdMask & o) const { return _mm256_or_pd(m, o.m); }
+		CSimdMask operator!() const { return _mm256_xor_pd(m, _mm256_castsi256_pd(_mm256_set1_epi32(-1))); }
+	};
+
+	template <>
+	class CSimd<double, 4>
+	{
+	public:
+		using TScalar = double;
+		using TMask = CSimdMask<double, 4>;
+
+		static constexpr size_t LANES = 4;
+
+		__m256d v;
+
+		CSimd() = default;
+		CSimd(double x) : v(_mm256_set1_pd(x)) {}
+		CSimd(__m256d x) : v(x) {}
+
+		static CSimd Load(const double * p) { return _mm256_loadu_pd(p); }
+		void Store(double * p) const { _mm256_storeu_pd(p, v); }
+
+		CSimd operator-() const { return _mm256_xor_pd(v, _mm256_set1_pd(-0.0)); }
+		CSimd operator+(const CSimd & o) const { return _mm256_add_pd(v, o.v); }
+		CSimd operator-(const CSimd & o) const { return _mm256_sub_pd(v, o.v); }
+		CSimd operator*(const CSimd & o) const { return _mm256_mul_pd(v, o.v); }
+		CSimd operator/(const CSimd & o) const { return _mm256_div_pd(v, o.v); }
+
+		TMask operator<(const CSimd & o) const { return _mm256_cmp_pd(v, o.v, _CMP_LT_OQ); }
+		TMask operator<=(const CSimd & o) const { return _mm256_cmp_pd(v, o.v, _CMP_LE_OQ); }
+		TMask operator>(const CSimd & o) const { return _mm256_cmp_pd(v, o.v, _CMP_GT_OQ); }
+		TMask operator>=(const CSimd & o) const { return _mm256_cmp_pd(v, o.v, _CMP_GE_OQ); }
+		TMask operator==(const CSimd & o) const { return _mm256_cmp_pd(v, o.v, _CMP_EQ_OQ); }
+		TMask operator!=(const CSimd & o) const { return _mm256_cmp_pd(v, o.v, _CMP_NEQ_UQ); }
+	};
+
+	using CSimd8f = CSimd<float, 8>;
+	using CSimd4d = CSimd<double, 4>;
+
+	inline bool Any(const CSimdMask<float, 8> & a) { return _mm256_movemask_ps(a.m) != 0; }
+	inline bool All(const CSimdMask<float, 8> & a) { return _mm256_movemask_ps(a.m) == 0xff; }
+	inline uint32_t MoveMask(const CSimdMask<float, 8> & a) { return static_cast<uint32_t>(_mm256_movemask_ps(a.m)); }
+
+	inline CSimd8f Select(const CSimdMask<float, 8> & mask, const CSimd8f & a, const CSimd8f & b) { return _mm256_blendv_ps(b.v, a.v, mask.m); }
+	inline CSimd8f Min(const CSimd8f & a, const CSimd8f & b) { return _mm256_min_ps(a.v, b.v); }
+	inline CSimd8f Max(const CSimd8f & a, const CSimd8f & b) { return _mm256_max_ps(a.v, b.v); }
+	inline CSimd8f Abs(const CSimd8f & a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v); }
+	inline CSimd8f Sqrt(const CSimd8f & a) { return _mm256_sqrt_ps(a.v); }
+	inline CSimd8f Round(const CSimd8f & a) { return _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	inline CSimd8f Floor(const CSimd8f & a) { return _mm256_floor_ps(a.v); }
+
+	inline CSimd8f MulAdd(const CSimd8f & a, const CSimd8f & b, const CSimd8f & c)
+	{
+#if defined(UU_FMA)
+		return _mm256_fmadd_ps(a.v, b.v, c.v);
+#else
+		return _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v);
+#endif
+	}
+
+	inline CSimd8f CopySign(const CSimd8f & mag, const CSimd8f & sign)
+	{
+		const __m256 s = _mm256_set1_ps(-0.f);
+
+		return _mm256_or_ps(_mm256_andnot_ps(s, mag.v), _mm256_and_ps(s, sign.v));
+	}
+
+	inline CSimd8f Pow2i(const CSimd8f & n)
+	{
+		const __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127));
+
+		return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+	}
+
+	inline CSimd8f Frexp(const CSimd8f & x, CSimd8f & exponent)
+	{
+		const __m256i bits = _mm256_castps_si256(x.v);
+		const __m256i e = _mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff));
+
+		exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(e, _mm256_set1_epi32(127)));
+
+		return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x807fffff)), _mm256_set1_epi32(0x3f800000)));
+	}
+
+	inline CSimdMask<float, 8> TestBit(const CSimd8f & q, int32_t mask)
+	{
+		const __m256i none = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_cvtps_epi32(q.v), _mm256_set1_epi32(mask)), _mm256_setzero_si256());
+
+		return _mm256_castsi256_ps(_mm256_xor_si256(none, _mm256_set1_epi32(-1)));
+	}
+
+	inline bool Any(const CSimdMask<double, 4> & a) { return _mm256_movemask_pd(a.m) != 0; }
+	inline bool All(const CSimdMask<double, 4> & a) { return _mm256_movemask_pd(a.m) == 0xf; }
+	inline uint32_t MoveMask(const CSimdMask<double, 4> & a) { return static_cast<uint32_t>(_mm256_movemask_pd(a.m)); }
+
+	inline CSimd4d Select(const CSimdMask<double, 4> & mask, const CSimd4d & a, const CSimd4d & b) { return _mm256_blendv_pd(b.v, a.v, mask.m); }
+	inline CSimd4d Min(const CSimd4d & a, const CSimd4d & b) { return _mm256_min_pd(a.v, b.v); }
+	inline CSimd4d Max(const CSimd4d & a, const CSimd4d & b) { return _mm256_max_pd(a.v, b.v); }
+	inline CSimd4d Abs(const CSimd4d & a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v); }
+	inline CSimd4d Sqrt(const CSimd4d & a) { return _mm256_sqrt_pd(a.v); }
+	inline CSimd4d Round(const CSimd4d & a) { return _mm256_round_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	inline CSimd4d Floor(const CSimd4d & a) { return _mm256_floor_pd(a.v); }
+
+	inline CSimd4d MulAdd(const CSimd4d & a, const CSimd4d & b, const CSimd4d & c)
+	{
+#if defined(UU_FMA)
+		return _mm256_fmadd_pd(a.v, b.v, c.v);
+#else
+		return _mm256_add_pd(_mm256_mul_pd(a.v, b.v), c.v);
+#endif
+	}
+
+	inline CSimd4d CopySign(const CSimd4d & mag, const CSimd4d & sign)
+	{
+		const __m256d s = _mm256_set1_pd(-0.0);
+
+		return _mm256_or_pd(_mm256_andnot_pd(s, mag.v), _mm256_and_pd(s, sign.v));
+	}
+
+	// Doubles have no packed int64 conversion before AVX-512, adding 1.5 * 2^52 leaves the integer in the low mantissa bits.
+	inline __m256i SimdToInt64(const CSimd4d & q)
+	{
+		const __m256d magic = _mm256_set1_pd(6755399441055744.0);
+
+		return _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(q.v, magic)), _mm256_castpd_si256(magic));
+	}
+
+	inline CSimd4d Pow2i(const CSimd4d & n)
+	{
+		return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(SimdToInt64(n), _mm256_set1_epi64x(1023)), 52));
+	}
+
+	inline CSimd4d Frexp(const CSimd4d & x, CSimd4d & exponent)
+	{
+		const __m256i bits = _mm256_castpd_si256(x.v);
+		const __m256i e = _mm256_and_si256(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x7ff));
+		const __m256d two52 = _mm256_castsi256_pd(_mm256_set1_epi64x(0x4330000000000000));
+
+		exponent = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(e, _mm256_castpd_si256(two52))), _mm256_add_pd(two52, _mm256_set1_pd(1023.0)));
+
+		return _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x800fffffffffffff)),
+			_mm256_set1_epi64x(0x3ff0000000000000)));
+	}
+
+	inline CSimdMask<double, 4> TestBit(const CSimd4d & q, int32_t mask)
+	{
+		const __m256i none = _mm256_cmpeq_epi64(_mm256_and_si256(SimdToInt64(q), _mm256_set1_epi64x(mask)), _mm256_setzero_si256());
+
+		return _mm256_castsi256_pd(_mm256_xor_si256(none, _mm256_set1_epi32(-1)));
+	}
+
+	inline CSimd4d WidenLow(const CSimd8f & a) { return _mm256_cvtps_pd(_mm256_castps256_ps128(a.v)); }
+	inline CSimd4d WidenHigh(const CSimd8f & a) { return _mm256_cvtps_pd(_mm256_extractf128_ps(a.v, 1)); }
+
+	inline CSimd8f Narrow(const CSimd4d & low, const CSimd4d & high)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(low.v)), _mm256_cvtpd_ps(high.v), 1);
+	}
+
+	inline void StoreInt32(const CSimd8f & a, int32_t * out)
+	{
+		const __m256i i = _mm256_cvttps_epi32(a.v);
+		const __m256i over = _mm256_castps_si256(_mm256_cmp_ps(a.v, _mm256_set1_ps(2147483648.f), _CMP_GE_OQ));
+		const __m256i ordered = _mm256_castps_si256(_mm256_cmp_ps(a.v, a.v, _CMP_ORD_Q));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_and_si256(_mm256_xor_si256(i, over), ordered));
+	}
+
+	inline void StoreInt32(const CSimd4d & a, int32_t * out)
+	{
+		const __m256d x = _mm256_and_pd(a.v, _mm256_cmp_pd(a.v, a.v, _CMP_ORD_Q));
+		const __m256d c = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-2147483648.0)), _mm256_set1_pd(2147483647.0));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_cvttpd_epi32(c));
+	}
+}
+#endif
+
+#if defined(UU_AVX512)
+namespace UU
+{
+	template <>
+	class CSimdMask<float, 16>
+	{
+	public:
+		__mmask16 m;
+
+		CSimdMask() = default;
+		CSimdMask(__mmask16 x) : m(x) {}
+
+		CSimdMask operator&(const CSimdMask & o) const { return static_cast<__mmask16>(m & o.m); }
+		CSimdMask operator|(const CSimdMask & o) const { return static_cast<__mmask16>(m | o.m); }
+		CSimdMask operator!() const { return static_cast<__mmask16>(~m); }
+	};
+
+	template <>
+	class CSimd<float, 16>
+	{
+	public:
+		using TScalar = float;
+		using TMask = CSimdMask<float, 16>;
+
+		static constexpr size_t LANES = 16;
+
+		__m512 v;
+
+		CSimd() = default;
+		CSimd(float x) : v(_mm512_set1_ps(x)) {}
+		CSimd(__m512 x) : v(x) {}
+
+		static CSimd Load(const float * p) { return _mm512_loadu_ps(p); }
+		void Store(float * p) const { _mm512_storeu_ps(p, v); }
+
+		CSimd operator-() const { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(v), _mm512_set1_epi32(INT32_MIN))); }
+		CSimd operator+(const CSimd & o) const { return _mm512_add_ps(v, o.v); }
+		CSimd operator-(const CSimd & o) const { return _mm512_sub_ps(v, o.v); }
+		CSimd operator*(const CSimd & o) const { return _mm512_mul_ps(v, o.v); }
+		CSimd operator/(const CSimd & o) const { return _mm512_div_ps(v, o.v); }
+
+		TMask operator<(const CSimd & o) const { return _mm512_cmp_ps_mask(v, o.v, _CMP_LT_OQ); }
+		TMask operator<=(const CSimd & o) const { return _mm512_cmp_ps_mask(v, o.v, _CMP_LE_OQ); }
+		TMask operator>(const CSimd & o) const { return _mm512_cmp_ps_mask(v, o.v, _CMP_GT_OQ); }
+		TMask operator>=(const CSimd & o) const { return _mm512_cmp_ps_mask(v, o.v, _CMP_GE_OQ); }
+		TMask operator==(const CSimd & o) const { return _mm512_cmp_ps_mask(v, o.v, _CMP_EQ_OQ); }
+		TMask operator!=(const CSimd & o) const { return _mm512_cmp_ps_mask(v, o.v, _CMP_NEQ_UQ); }
+	};
+
+	template <>
+	class CSimdMask<double, 8>
+	{
+	public:
+		__mmask8 m;
+
+		CSimdMask() = default;
+		CSimdMask(__mmask8 x) : m(x) {}
+
+		CSimdMask operator&(const CSimdMask & o) const { return static_cast<__mmask8>(m & o.m); }
+		CSimdMask operator|(const CSimdMask & o) const { return static_cast<__mmask8>(m | o.m); }
+		CSimdMask operator!() const { return static_cast<__mmask8>(~m); }
+	};
+
+	template <>
+	class CSimd<double, 8>
+	{
+	public:
+		using TScalar = double;
+		using TMask = CSimdMask<double, 8>;
+
+		static constexpr size_t LANES = 8;
+
+		__m512d v;
+
+		CSimd() = default;
+		CSimd(double x) : v(_mm512_set1_pd(x)) {}
+		CSimd(__m512d x) : v(x) {}
+
+		static CSimd Load(const double * p) { return _mm512_loadu_pd(p); }
+		void Store(double * p) const { _mm512_storeu_pd(p, v); }
+
+		CSimd operator-() const { return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(v), _mm512_set1_epi64(INT64_MIN))); }
+		CSimd operator+(const CSimd & o) const { return _mm512_add_pd(v, o.v); }
+		CSimd operator-(const CSimd & o) const { return _mm512_sub_pd(v, o.v); }
+		CSimd operator*(const CSimd & o) const { return _mm512_mul_pd(v, o.v); }
+		CSimd operator/(const CSimd & o) const { return _mm512_div_pd(v, o.v); }
+
+		TMask operator<(const CSimd & o) const { return _mm512_cmp_pd_mask(v, o.v, _CMP_LT_OQ); }
+		TMask operator<=(const CSimd & o) const { return _mm512_cmp_pd_mask(v, o.v, _CMP_LE_OQ); }
+		TMask operator>(const CSimd & o) const { return _mm512_cmp_pd_mask(v, o.v, _CMP_GT_OQ); }
+		TMask operator>=(const CSimd & o) const { return _mm512_cmp_pd_mask(v, o.v, _CMP_GE_OQ); }
+		TMask operator==(const CSimd & o) const { return _mm512_cmp_pd_mask(v, o.v, _CMP_EQ_OQ); }
+		TMask operator!=(const CSimd & o) const { return _mm512_cmp_pd_mask(v, o.v, _CMP_NEQ_UQ); }
+	};
+
+	using CSimd16f = CSimd<float, 16>;
+	using CSimd8d = CSimd<double, 8>;
+
+	inline bool Any(const CSimdMask<float, 16> & a) { return a.m != 0; }
+	inline bool All(const CSimdMask<float, 16> & a) { return a.m == 0xffff; }
+	inline uint32_t MoveMask(const CSimdMask<float, 16> & a) { return a.m; }
+
+	inline CSimd16f Select(const CSimdMask<float, 16> & mask, const CSimd16f & a, const CSimd16f & b) { return _mm512_mask_blend_ps(mask.m, b.v, a.v); }
+	inline CSimd16f Min(const CSimd16f & a, const CSimd16f & b) { return _mm512_min_ps(a.v, b.v); }
+	inline CSimd16f Max(const CSimd16f & a, const CSimd16f & b) { return _mm512_max_ps(a.v, b.v); }
+	inline CSimd16f Abs(const CSimd16f & a) { return _mm512_abs_ps(a.v); }
+	inline CSimd16f Sqrt(const CSimd16f & a) { return _mm512_sqrt_ps(a.v); }
+	inline CSimd16f Round(const CSimd16f & a) { return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	inline CSimd16f Floor(const CSimd16f & a) { return _mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+	inline CSimd16f MulAdd(const CSimd16f & a, const CSimd16f & b, const CSimd16f & c) { return _mm512_fmadd_ps(a.v, b.v, c.v); }
+
+	inline CSimd16f CopySign(const CSimd16f & mag, const CSimd16f & sign)
+	{
+		const __m512i s = _mm512_set1_epi32(INT32_MIN);
+
+		return _mm512_castsi512_ps(_mm512_or_si512(_mm512_andnot_si512(s, _mm512_castps_si512(mag.v)), _mm512_and_si512(s, _mm512_castps_si512(sign.v))));
+	}
+
+	inline CSimd16f Pow2i(const CSimd16f & n)
+	{
+		return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n.v), _mm512_set1_epi32(127)), 23));
+	}
+
+	inline CSimd16f Frexp(const CSimd16f & x, CSimd16f & exponent)
+	{
+		const __m512i bits = _mm512_castps_si512(x.v);
+		const __m512i e = _mm512_and_si512(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(0xff));
+
+		exponent = _mm512_cvtepi32_ps(_mm512_sub_epi32(e, _mm512_set1_epi32(127)));
+
+		return _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x807fffff)), _mm512_set1_epi32(0x3f800000)));
+	}
+
+	inline CSimdMask<float, 16> TestBit(const CSimd16f & q, int32_t mask)
+	{
+		return _mm512_test_epi32_mask(_mm512_cvtps_epi32(q.v), _mm512_set1_epi32(mask));
+	}
+
+	inline bool Any(const CSimdMask<double, 8> & a) { return a.m != 0; }
+	inline bool All(const CSimdMask<double, 8> & a) { return a.m == 0xff; }
+	inline uint32_t MoveMask(const CSimdMask<double, 8> & a) { return a.m; }
+
+	inline CSimd8d Select(const CSimdMask<double, 8> & mask, const CSimd8d & a, const CSimd8d & b) { return _mm512_mask_blend_pd(mask.m, b.v, a.v); }
+	inline CSimd8d Min(const CSimd8d & a, const CSimd8d & b) { return _mm512_min_pd(a.v, b.v); }
+	inline CSimd8d Max(const CSimd8d & a, const CSimd8d & b) { return _mm512_max_pd(a.v, b.v); }
+	inline CSimd8d Abs(const CSimd8d & a) { return _mm512_abs_pd(a.v); }
+	inline CSimd8d Sqrt(const CSimd8d & a) { return _mm512_sqrt_pd(a.v); }
+	inline CSimd8d Round(const CSimd8d & a) { return _mm512_roundscale_pd(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	inline CSimd8d Floor(const CSimd8d & a) { return _mm512_roundscale_pd(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+	inline CSimd8d MulAdd(const CSimd8d & a, const CSimd8d & b, const CSimd8d & c) { return _mm512_fmadd_pd(a.v, b.v, c.v); }
+
+	inline CSimd8d CopySign(const CSimd8d & mag, const CSimd8d & sign)
+	{
+		const __m512i s = _mm512_set1_epi64(INT64_MIN);
+
+		return _mm512_castsi512_pd(_mm512_or_si512(_mm512_andnot_si512(s, _mm512_castpd_si512(mag.v)), _mm512_and_si512(s, _mm512_castpd_si512(sign.v))));
+	}
+
+	// Same 1.5 * 2^52 trick as the AVX2 path, vcvtpd2qq needs AVX512DQ.
+	inline __m512i SimdToInt64(const CSimd8d & q)
+	{
+		const __m512d magic = _mm512_set1_pd(6755399441055744.0);
+
+		return _mm512_sub_epi64(_mm512_castpd_si512(_mm512_add_pd(q.v, magic)), _mm512_castpd_si512(magic));
+	}
+
+	inline CSimd8d Pow2i(const CSimd8d & n)
+	{
+		return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(SimdToInt64(n), _mm512_set1_epi64(1023)), 52));
+	}
+
+	inline CSimd8d Frexp(const CSimd8d & x, CSimd8d & exponent)
+	{
+		const __m512i bits = _mm512_castpd_si512(x.v);
+		const __m512i e = _mm512_and_si512(_mm512_srli_epi64(bits, 52), _mm512_set1_epi64(0x7ff));
+		const __m512d two52 = _mm512_castsi512_pd(_mm512_set1_epi64(0x4330000000000000));
+
+		exponent = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(e, _mm512_castpd_si512(two52))), _mm512_add_pd(two52, _mm512_set1_pd(1023.0)));
+
+		return _mm512_castsi512_pd(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi64(0x800fffffffffffff)),
+			_mm512_set1_epi64(0x3ff0000000000000)));
+	}
+
+	inline CSimdMask<double, 8> TestBit(const CSimd8d & q, int32_t mask)
+	{
+		return _mm512_test_epi64_mask(SimdToInt64(q), _mm512_set1_epi64(mask));
+	}
+
+	inline CSimd8d WidenLow(const CSimd16f & a) { return _mm512_cvtps_pd(_mm512_castps512_ps256(a.v)); }
+	inline CSimd8d WidenHigh(const CSimd16f & a) { return _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a.v), 1))); }
+
+	inline CSimd16f Narrow(const CSimd8d & low, const CSimd8d & high)
+	{
+		const __m512d l = _mm512_castps_pd(_mm512_castps256_ps512(_mm512_cvtpd_ps(low.v)));
+
+		return _mm512_castpd_ps(_mm512_insertf64x4(l, _mm256_castps_pd(_mm512_cvtpd_ps(high.v)), 1));
+	}
+
+	inline void StoreInt32(const CSimd16f & a, int32_t * out)
+	{
+		const __m512i i = _mm512_cvttps_epi32(a.v);
+		const __m512i saturated = _mm512_mask_mov_epi32(i, _mm512_cmp_ps_mask(a.v, _mm512_set1_ps(2147483648.f), _CMP_GE_OQ),
+			_mm512_set1_epi32(std::numeric_limits<int32_t>::max()));
+
+		_mm512_storeu_si512(out, _mm512_maskz_mov_epi32(_mm512_cmp_ps_mask(a.v, a.v, _CMP_ORD_Q), saturated));
+	}
+
+	inline void StoreInt32(const CSimd8d & a, int32_t * out)
+	{
+		const __m512d x = _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(a.v, a.v, _CMP_ORD_Q), a.v);
+		const __m512d c = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(-2147483648.0)), _mm512_set1_pd(2147483647.0));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm512_cvttpd_epi32(c));
+	}
+}
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace UU
+{
+	template <typename T>
+	class CSpan
+	{
+	private:
+		T * data = nullptr;
+		size_t count = 0;
+	public:
+		constexpr CSpan() = default;
+		constexpr CSpan(T * ptr, size_t n) : data(ptr), count(n) {}
+
+		template <size_t N>
+		constexpr CSpan(T (&arr)[N]) : data(arr), count(N) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+		constexpr CSpan(const CSpan<U> & s) : data(s.Data()), count(s.Size()) {}
+
+		template <typename U, typename A, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+		CSpan(std::vector<U, A> & vec) : data(vec.data()), count(vec.size()) {}
+
+		template <typename U, typename A, typename = std::enable_if_t<std::is_convertible_v<const U(*)[], T(*)[]>>>
+		CSpan(const std::vector<U, A> & vec) : data(vec.data()), count(vec.size()) {}
+
+		constexpr T &		operator[](size_t i) const;
+
+		constexpr T *		Data() const;
+		constexpr size_t	Size() const;
+		constexpr bool		Empty() const;
+
+		constexpr CSpan		Subspan(size_t offset) const;
+		constexpr CSpan		Subspan(size_t offset, size_t n) const;
+
+		constexpr T *		begin() const;
+		constexpr T *		end() const;
+	};
+}
+
+template <typename T>
+constexpr T & UU::CSpan<T>::operator[](size_t i) const
+{
+	return data[i];
+}
+
+template <typename T>
+constexpr T * UU::CSpan<T>::Data() const
+{
+	return data;
+}
+
+template <typename T>
+constexpr size_t UU::CSpan<T>::Size() const
+{
+	return count;
+}
+
+template <typename T>
+constexpr bool UU::CSpan<T>::Empty() const
+{
+	return count == 0;
+}
+
+template <typename T>
+constexpr UU::CSpan<T> UU::CSpan<T>::Subspan(size_t offset) const
+{
+	return CSpan(data + offset, count - offset);
+}
+
+template <typename T>
+constexpr UU::CSpan<T> UU::CSpan<T>::Subspan(size_t offset, size_t n) const
+{
+	return CSpan(data + offset, n);
+}
+
+template <typename T>
+constexpr T * UU::CSpan<T>::begin() const
+{
+	return data;
+}
+
+template <typename T>
+constexpr T * UU::CSpan<T>::end() const
+{
+	return data + count;
+}
@@ -0,0 +1,224 @@
+#include "../UU.hpp"
+#include "Statistics.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace
+{
+	using UU::CColour;
+	using UU::CColourStatistics;
+
+	// ceil(2^32 / d) for every divisor d the bins divide by, so that (n * m) >> 32 is n / d rounded down for
+	// any n below 2^19: the error of m is under d, and n times that stays under 2^32.
+	const uint64_t * Reciprocals()
+	{
+		static const auto table = []
+		{
+			std::array<uint64_t, 1024> t{};
+
+			for (uint64_t d = 1; d < t.size(); ++d)
+				t[d] = ((uint64_t(1) << 32) + d - 1) / d;
+
+			return t;
+		}();
+
+		return table.data();
+	}
+
+	uint32_t Divide(uint32_t n, const uint64_t * reciprocals, uint32_t d)
+	{
+		return static_cast<uint32_t>((n * reciprocals[d]) >> 32);
+	}
+
+	void Accumulate(const CColour * pixels, size_t count, CColourStatistics & stats)
+	{
+		const uint64_t * reciprocals = Reciprocals();
+
+		uint64_t coloured = 0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const CColour col = pixels[i];
+			const uint32_t r = col.r, g = col.g, b = col.b;
+
+			++stats.red.bins[r];
+			++stats.green.bins[g];
+			++stats.blue.bins[b];
+			++stats.alpha.bins[col.a];
+
+			// 0.2126, 0.7152 and 0.0722 in 16 bit fixed point, summing to exactly 65536.
+			++stats.luminance.bins[(13933 * r + 46871 * g + 4732 * b + 32768) >> 16];
+
+			const uint32_t max = std::max(std::max(r, g), b), min = std::min(std::min(r, g), b);
+			const uint32_t delta = max - min, sum = max + min;
+
+			++stats.brightness.bins[(sum + 1) >> 1];
+
+			// Saturation delta / sum at or below half brightness, delta / (510 - sum) above, times 255 rounded.
+			// Greys come out as 0, their range only kept off 0 for black and white.
+			const uint32_t range = std::max(std::min(sum, 510 - sum), 1u);
+
+			++stats.saturation.bins[Divide(510 * delta + range, reciprocals, 2 * range)];
+
+			// 60 degrees per unit of the ToHSB sector offsets, the channel tested first taking ties. Greys land
+			// in bin 0 adding nothing, so nothing here branches on the data.
+			const uint32_t from_red = 60 * (g - b) + (g < b ? 360 * delta : 0);
+			const uint32_t from_green = 120 * delta + 60 * b - 60 * r;
+			const uint32_t from_blue = 240 * delta + 60 * r - 60 * g;
+			const uint32_t degrees = r == max ? from_red : g == max ? from_green : from_blue;
+			const uint32_t is_coloured = delta != 0;
+
+			stats.hue[Divide(degrees, reciprocals, std::max(delta, 1u))] += is_coloured;
+			coloured += is_coloured;
+		}
+
+		stats.count += count;
+		stats.greys += count - coloured;
+	}
+
+	template <typename Fn>
+	CColourStatistics Reduce(size_t count, size_t grain, Fn && fn)
+	{
+		const size_t chunks = UU::ParallelChunkCount(count, grain);
+
+		std::vector<CColourStatistics> parts(chunks > 0 ? chunks : 1);
+
+		UU::ParallelFor(count, grain, [&](size_t chunk, size_t begin, size_t end) { fn(begin, end, parts[chunk]); });
+
+		for (size_t i = 1; i < parts.size(); ++i)
+			parts[0].Merge(parts[i]);
+
+		return parts[0];
+	}
+}
+
+uint64_t UU::CHistogram::Count() const
+{
+	uint64_t total = 0;
+
+	for (uint64_t n : bins)
+		total += n;
+
+	return total;
+}
+
+double UU::CHistogram::Mean() const
+{
+	uint64_t total = 0, sum = 0;
+
+	for (size_t i = 0; i < HISTOGRAM_BINS; ++i)
+	{
+		total += bins[i];
+		sum += bins[i] * i;
+	}
+
+	return total > 0 ? static_cast<double>(sum) / static_cast<double>(total) : 0.0;
+}
+
+double UU::CHistogram::Variance() const
+{
+	const uint64_t total = Count();
+
+	if (total == 0)
+		return 0.0;
+
+	const double mean = Mean();
+	double sum = 0;
+
+	for (size_t i = 0; i < HISTOGRAM_BINS; ++i)
+	{
+		const double d = static_cast<double>(i) - mean;
+
+		sum += static_cast<double>(bins[i]) * d * d;
+	}
+
+	return sum / static_cast<double>(total);
+}
+
+uint8_t UU::CHistogram::Min() const
+{
+	for (size_t i = 0; i < HISTOGRAM_BINS; ++i)
+		if (bins[i] > 0)
+			return static_cast<uint8_t>(i);
+
+	return 0;
+}
+
+uint8_t UU::CHistogram::Max() const
+{
+	for (size_t i = HISTOGRAM_BINS; i-- > 0;)
+		if (bins[i] > 0)
+			return static_cast<uint8_t>(i);
+
+	return 0;
+}
+
+uint8_t UU::CHistogram::Percentile(double p) const
+{
+	const uint64_t total = Count();
+
+	if (total == 0)
+		return 0;
+
+	const double target = std::min(std::max(p, 0.0), 1.0) * static_cast<double>(total);
+	uint64_t below = 0;
+
+	for (size_t i = 0; i < HISTOGRAM_BINS; ++i)
+	{
+		below += bins[i];
+
+		if (bins[i] > 0 && static_cast<double>(below) >= target)
+			return static_cast<uint8_t>(i);
+	}
+
+	return Max();
+}
+
+void UU::CHistogram::Merge(const CHistogram & h)
+{
+	for (size_t i = 0; i < HISTOGRAM_BINS; ++i)
+		bins[i] += h.bins[i];
+}
+
+void UU::CColourStatistics::Merge(const CColourStatistics & s)
+{
+	count += s.count;
+
+	red.Merge(s.red);
+	green.Merge(s.green);
+	blue.Merge(s.blue);
+	alpha.Merge(s.alpha);
+	luminance.Merge(s.luminance);
+	saturation.Merge(s.saturation);
+	brightness.Merge(s.brightness);
+
+	for (size_t i = 0; i < HUE_BINS; ++i)
+		hue[i] += s.hue[i];
+
+	greys += s.greys;
+}
+
+UU::CColourStatistics UU::Statistics(CSpan<const CColour> pixels)
+{
+	return Reduce(pixels.Size(), STATISTICS_PARALLEL_GRAIN, [&](size_t begin, size_t end, CColourStatistics & stats)
+	{
+		Accumulate(pixels.Data() + begin, end - begin, stats);
+	});
+}
+
+UU::CColourStatistics UU::Statistics(CImageView<const CColour> image)
+{
+	const size_t width = image.Width();
+
+	if (width == 0)
+		return CColourStatistics();
+
+	return Reduce(image.Height(), (STATISTICS_PARALLEL_GRAIN + width - 1) / width, [&](size_t begin, size_t end, CColourStatistics & stats)
+	{
+		for (size_t y = begin; y < end; ++y)
+			Accumulate(image.Row(y), width, stats);
+	});
+}
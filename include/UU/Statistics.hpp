@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Colour.hpp"
+#include "Image.hpp"
+#include "Span.hpp"
+
+#include <cstdint>
+
+namespace UU
+{
+	constexpr size_t HISTOGRAM_BINS = 256;
+
+	// Hue bins of one degree each.
+	constexpr size_t HUE_BINS = 360;
+
+	constexpr size_t STATISTICS_PARALLEL_GRAIN = 1 << 16;
+
+	// Counts of an 8 bit quantity. The moments and extremes are exact, derived from the bins rather than
+	// tracked per value.
+	class CHistogram final
+	{
+	public:
+
+		uint64_t	bins[HISTOGRAM_BINS] = {};
+
+		uint64_t	Count() const;
+
+		// Population variance, divided by the count. All of these are 0 for an empty histogram.
+		double		Mean() const;
+		double		Variance() const;
+		uint8_t		Min() const;
+		uint8_t		Max() const;
+
+		// The smallest value with at least fraction p of the counts at or below it.
+		uint8_t		Percentile(double p) const;
+
+		void		Merge(const CHistogram & h);
+	};
+
+	// Histograms of a set of pixels. Luminance is the Rec. 709 luma of the encoded channels. Hue, saturation
+	// and brightness are those of CColour::ToHSB, worked out from each pixel's minimum and maximum channel in
+	// exact integer arithmetic: saturation and brightness rounded to the nearest 255th, hue to the degree
+	// below. Greys, with no hue, are counted on their own.
+	class CColourStatistics final
+	{
+	public:
+
+		uint64_t	count = 0;
+
+		CHistogram	red, green, blue, alpha;
+		CHistogram	luminance;
+		CHistogram	saturation, brightness;
+
+		uint64_t	hue[HUE_BINS] = {};
+		uint64_t	greys = 0;
+
+		void		Merge(const CColourStatistics & s);
+	};
+
+	// One pass over the pixels, split across threads that each count into their own CColourStatistics, merged
+	// once they have all finished. Images are split by rows.
+	CColourStatistics	Statistics(CSpan<const CColour> pixels);
+	CColourStatistics	Statistics(CImageView<const CColour> image);
+}
@@ -0,0 +1,633 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Math.hpp"
+#include "Simd.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace UU
+{
+	namespace Detail
+	{
+		// Series evaluations for building tables at compile time, accurate to double rounding for |x| <= pi/2.
+		constexpr double ConstexprSin(double x)
+		{
+			double term = x, sum = x;
+
+			for (int k = 1; k < 14; ++k)
+			{
+				term *= -x * x / ((2 * k) * (2 * k + 1));
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		constexpr double ConstexprCos(double x)
+		{
+			double term = 1.0, sum = 1.0;
+
+			for (int k = 1; k < 14; ++k)
+			{
+				term *= -x * x / ((2 * k - 1) * (2 * k));
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		// |x| <= 1.
+		constexpr double ConstexprExp(double x)
+		{
+			double term = 1.0, sum = 1.0;
+
+			for (int k = 1; k < 24; ++k)
+			{
+				term *= x / k;
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		// 0 <= x <= 1, folded onto [0, tan(pi/8)] with atan(x) = pi/4 + atan((x - 1) / (x + 1)).
+		constexpr double ConstexprATan(double x)
+		{
+			double offset = 0.0;
+
+			if (x > 0.41421356237309504880)
+			{
+				offset = 0.78539816339744830962;
+				x = (x - 1.0) / (x + 1.0);
+			}
+
+			double power = x, sum = x;
+
+			for (int k = 1; k < 24; ++k)
+			{
+				power *= -x * x;
+				sum += power / (2 * k + 1);
+			}
+
+			return offset + sum;
+		}
+
+		template <typename T, size_t size>
+		constexpr std::array<T, size + 1> MakeSinTable()
+		{
+			std::array<T, size + 1> table = {};
+
+			for (size_t i = 0; i <= size; ++i)
+			{
+				const size_t t = i & (size - 1);
+				const size_t quadrant = t / (size / 4);
+				const double a = 6.28318530717958647693 * static_cast<double>(t - quadrant * (size / 4)) / static_cast<double>(size);
+
+				const double v = quadrant == 0 ? ConstexprSin(a) : quadrant == 1 ? ConstexprCos(a) : quadrant == 2 ? -ConstexprSin(a) : -ConstexprCos(a);
+
+				table[i] = static_cast<T>(v);
+			}
+
+			return table;
+		}
+
+		template <typename T, size_t size>
+		constexpr std::array<T, size + 1> MakeATanTable()
+		{
+			std::array<T, size + 1> table = {};
+
+			for (size_t i = 0; i <= size; ++i)
+				table[i] = static_cast<T>(ConstexprATan(static_cast<double>(i) / static_cast<double>(size)));
+
+			return table;
+		}
+
+		template <typename T, size_t size>
+		constexpr std::array<T, size + 1> MakeExp2Table()
+		{
+			std::array<T, size + 1> table = {};
+
+			for (size_t i = 0; i <= size; ++i)
+				table[i] = static_cast<T>(ConstexprExp(0.69314718055994530942 * static_cast<double>(i) / static_cast<double>(size)));
+
+			return table;
+		}
+
+		// Floor for the table index, avoiding the libm call of std::floor.
+		template <typename T>
+		int64_t FloorToInt(T x)
+		{
+			const auto i = static_cast<int64_t>(x);
+
+			return x < static_cast<T>(i) ? i - 1 : i;
+		}
+
+		// 2^n for n within the normal exponent range, built in the exponent bits.
+		template <typename T>
+		T Pow2(int64_t n)
+		{
+			using TBits = std::conditional_t<sizeof(T) == sizeof(float), uint32_t, uint64_t>;
+
+			const TBits bits = static_cast<TBits>(n + std::numeric_limits<T>::max_exponent - 1) << (std::numeric_limits<T>::digits - 1);
+			T p;
+
+			std::memcpy(&p, &bits, sizeof(T));
+
+			return p;
+		}
+
+		// sqrtss/sqrtsd without the errno handling of the libm call.
+		inline float SqrtHardware(float x)
+		{
+#if defined(UU_SSE2)
+			return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x)));
+#else
+			return std::sqrt(x);
+#endif
+		}
+
+		inline double SqrtHardware(double x)
+		{
+#if defined(UU_SSE2)
+			return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(x)));
+#else
+			return std::sqrt(x);
+#endif
+		}
+
+		// rsqrtss, within 1.5 * 2^-12 relative.
+		inline float InvSqrtEstimate(float x)
+		{
+#if defined(UU_SSE2)
+			return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+			return 1.f / std::sqrt(x);
+#endif
+		}
+
+		// The vector kernels of MathSimd.hpp on a single lane, found through argument dependent lookup.
+		template <typename T>
+		T SinLane(T x)
+		{
+			T r;
+
+			Sin(CSimd<T, 1>(x)).Store(&r);
+
+			return r;
+		}
+
+		template <typename T>
+		T CosLane(T x)
+		{
+			T r;
+
+			Cos(CSimd<T, 1>(x)).Store(&r);
+
+			return r;
+		}
+
+		template <typename T>
+		void SinCosLane(T x, T & sin_val, T & cos_val)
+		{
+			CSimd<T, 1> s, c;
+
+			SinCos(CSimd<T, 1>(x), s, c);
+
+			s.Store(&sin_val);
+			c.Store(&cos_val);
+		}
+
+		template <typename T>
+		T ATan2Lane(T y, T x)
+		{
+			T r;
+
+			ATan2(CSimd<T, 1>(y), CSimd<T, 1>(x)).Store(&r);
+
+			return r;
+		}
+
+		template <typename T>
+		T ExpLane(T x)
+		{
+			T r;
+
+			Exp(CSimd<T, 1>(x)).Store(&r);
+
+			return r;
+		}
+
+		template <typename T>
+		constexpr bool IS_SIMD_FLOAT = std::is_same<T, float>::value || std::is_same<T, double>::value;
+	}
+}
+
+namespace UU
+{
+	// Math policies for code templated on how accurate its math has to be, e.g. v.Normalized<CFastMath>() or
+	// CAngle::Forward<CTableMath<float>>(). Every policy provides static Sqrt, InvSqrt, Sin, Cos, SinCos, ATan2
+	// and Exp, which also serve as the per call form, e.g. CApproxMath::InvSqrt(x).
+
+	// The regular UU functions.
+	class CExactMath final
+	{
+	public:
+		template <typename T>
+		static T			Sqrt(T x);
+		template <typename T>
+		static T			InvSqrt(T x);
+		template <typename T>
+		static T			Sin(T x);
+		template <typename T>
+		static T			Cos(T x);
+		template <typename T>
+		static void			SinCos(T x, T & sin_val, T & cos_val);
+		template <typename T>
+		static T			ATan2(T y, T x);
+		template <typename T>
+		static T			Exp(T x);
+	};
+
+	// Throughput policy for float and double, other types use the UU functions. Sqrt is the correctly rounded
+	// instruction without the errno handling of libm. InvSqrt is a reciprocal square root estimate refined by
+	// one Newton step for float, within 4.5e-7 relative for positive normal x, and 1 / Sqrt for double. The trig
+	// functions and Exp are the polynomial kernels of the SIMD forms on a single lane, within a few ulp.
+	class CFastMath final
+	{
+	public:
+		template <typename T>
+		static T			Sqrt(T x);
+		template <typename T>
+		static T			InvSqrt(T x);
+		template <typename T>
+		static T			Sin(T x);
+		template <typename T>
+		static T			Cos(T x);
+		template <typename T>
+		static void			SinCos(T x, T & sin_val, T & cos_val);
+		template <typename T>
+		static T			ATan2(T y, T x);
+		template <typename T>
+		static T			Exp(T x);
+	};
+
+	// Approximate policy for visuals and heuristics. InvSqrt is the raw reciprocal square root estimate of float,
+	// within 3.7e-4 relative, and Sqrt x times that estimate. Double keeps the CFastMath square roots. The trig
+	// functions and Exp are those of CTableMath<float, 256>.
+	class CApproxMath final
+	{
+	public:
+		template <typename T>
+		static T			Sqrt(T x);
+		template <typename T>
+		static T			InvSqrt(T x);
+		template <typename T>
+		static T			Sin(T x);
+		template <typename T>
+		static T			Cos(T x);
+		template <typename T>
+		static void			SinCos(T x, T & sin_val, T & cos_val);
+		template <typename T>
+		static T			ATan2(T y, T x);
+		template <typename T>
+		static T			Exp(T x);
+	};
+
+	// Linear interpolation in lookup tables of table_size + 1 entries of T, built at compile time.
+	// table_size must be a power of two. Maximum absolute error:
+	//
+	//	table_size	Sin, Cos	ATan2		Exp (relative)
+	//	256			7.6e-5		1.2e-6		9.2e-7
+	//	1024		4.8e-6		7.9e-8		5.8e-8
+	//	4096		3.0e-7		5.0e-9		3.6e-9
+	//
+	// plus the rounding of T. Arguments are reduced in at least double precision. Exp falls back to UU::Exp
+	// for results outside the normal range. Tables above 1024 entries may need a higher /constexpr:steps on MSVC.
+	// Sqrt and InvSqrt are those of CExactMath.
+	template <typename T = float, size_t table_size = 1024>
+	class CTableMath final
+	{
+		static_assert(table_size >= 8 && (table_size & (table_size - 1)) == 0, "table_size must be a power of two");
+
+		using TArg = std::common_type_t<T, double>;
+
+	public:
+		// sin(2 pi i / table_size), atan(i / table_size) and 2^(i / table_size).
+		static constexpr std::array<T, table_size + 1> sin_table = Detail::MakeSinTable<T, table_size>();
+		static constexpr std::array<T, table_size + 1> atan_table = Detail::MakeATanTable<T, table_size>();
+		static constexpr std::array<T, table_size + 1> exp2_table = Detail::MakeExp2Table<T, table_size>();
+
+		template <typename U>
+		static U			Sqrt(U x);
+		template <typename U>
+		static U			InvSqrt(U x);
+		template <typename U>
+		static U			Sin(U x);
+		template <typename U>
+		static U			Cos(U x);
+		template <typename U>
+		static void			SinCos(U x, U & sin_val, U & cos_val);
+		template <typename U>
+		static U			ATan2(U y, U x);
+		template <typename U>
+		static U			Exp(U x);
+	};
+
+	// The policy of every TMath parameter left out, CExactMath unless UU_MATH_POLICY is defined before including
+	// UU.hpp, e.g. -DUU_MATH_POLICY=UU::CFastMath for a throughput build of the same code. Translation units built
+	// with different policies instantiate distinct functions only where TMath is a parameter of the function
+	// itself, so header code without one must name its policy rather than rely on the default.
+#if defined(UU_MATH_POLICY)
+	using CDefaultMath = UU_MATH_POLICY;
+#else
+	using CDefaultMath = CExactMath;
+#endif
+}
+
+template <typename T>
+T UU::CExactMath::Sqrt(T x)
+{
+	return UU::Sqrt(x);
+}
+
+template <typename T>
+T UU::CExactMath::InvSqrt(T x)
+{
+	return UU::InvSqrt(x);
+}
+
+template <typename T>
+T UU::CExactMath::Sin(T x)
+{
+	return UU::Sin(x);
+}
+
+template <typename T>
+T UU::CExactMath::Cos(T x)
+{
+	return UU::Cos(x);
+}
+
+template <typename T>
+void UU::CExactMath::SinCos(T x, T & sin_val, T & cos_val)
+{
+	UU::SinCos(x, sin_val, cos_val);
+}
+
+template <typename T>
+T UU::CExactMath::ATan2(T y, T x)
+{
+	return UU::ATan2(y, x);
+}
+
+template <typename T>
+T UU::CExactMath::Exp(T x)
+{
+	return UU::Exp(x);
+}
+
+template <typename T>
+T UU::CFastMath::Sqrt(T x)
+{
+	if constexpr (Detail::IS_SIMD_FLOAT<T>)
+		return Detail::SqrtHardware(x);
+	else
+		return UU::Sqrt(x);
+}
+
+template <typename T>
+T UU::CFastMath::InvSqrt(T x)
+{
+	if constexpr (std::is_same<T, float>::value)
+	{
+		const float r = Detail::InvSqrtEstimate(x);
+
+		return r * (1.5f - 0.5f * x * r * r);
+	}
+	else if constexpr (std::is_same<T, double>::value)
+	{
+		return 1.0 / Detail::SqrtHardware(x);
+	}
+	else
+	{
+		return UU::InvSqrt(x);
+	}
+}
+
+template <typename T>
+T UU::CFastMath::Sin(T x)
+{
+	if constexpr (Detail::IS_SIMD_FLOAT<T>)
+		return Detail::SinLane(x);
+	else
+		return UU::Sin(x);
+}
+
+template <typename T>
+T UU::CFastMath::Cos(T x)
+{
+	if constexpr (Detail::IS_SIMD_FLOAT<T>)
+		return Detail::CosLane(x);
+	else
+		return UU::Cos(x);
+}
+
+template <typename T>
+void UU::CFastMath::SinCos(T x, T & sin_val, T & cos_val)
+{
+	if constexpr (Detail::IS_SIMD_FLOAT<T>)
+		Detail::SinCosLane(x, sin_val, cos_val);
+	else
+		UU::SinCos(x, sin_val, cos_val);
+}
+
+template <typename T>
+T UU::CFastMath::ATan2(T y, T x)
+{
+	if constexpr (Detail::IS_SIMD_FLOAT<T>)
+		return Detail::ATan2Lane(y, x);
+	else
+		return UU::ATan2(y, x);
+}
+
+template <typename T>
+T UU::CFastMath::Exp(T x)
+{
+	if constexpr (Detail::IS_SIMD_FLOAT<T>)
+		return Detail::ExpLane(x);
+	else
+		return UU::Exp(x);
+}
+
+template <typename T>
+T UU::CApproxMath::Sqrt(T x)
+{
+	// x * 1/sqrt(x) only holds for normal finite x. Zero gives 0 * inf, infinity inf * 0, and the estimate of a
+	// subnormal overflows, so those and negative x take the exact path.
+	if constexpr (std::is_same<T, float>::value)
+	{
+		const bool normal = x >= std::numeric_limits<float>::min() && x < std::numeric_limits<float>::infinity();
+
+		return normal ? x * Detail::InvSqrtEstimate(x) : Detail::SqrtHardware(x);
+	}
+	else
+		return CFastMath::Sqrt(x);
+}
+
+template <typename T>
+T UU::CApproxMath::InvSqrt(T x)
+{
+	if constexpr (std::is_same<T, float>::value)
+		return Detail::InvSqrtEstimate(x);
+	else
+		return CFastMath::InvSqrt(x);
+}
+
+template <typename T>
+T UU::CApproxMath::Sin(T x)
+{
+	return CTableMath<float, 256>::Sin(x);
+}
+
+template <typename T>
+T UU::CApproxMath::Cos(T x)
+{
+	return CTableMath<float, 256>::Cos(x);
+}
+
+template <typename T>
+void UU::CApproxMath::SinCos(T x, T & sin_val, T & cos_val)
+{
+	CTableMath<float, 256>::SinCos(x, sin_val, cos_val);
+}
+
+template <typename T>
+T UU::CApproxMath::ATan2(T y, T x)
+{
+	return CTableMath<float, 256>::ATan2(y, x);
+}
+
+template <typename T>
+T UU::CApproxMath::Exp(T x)
+{
+	return CTableMath<float, 256>::Exp(x);
+}
+
+template <typename T, size_t table_size>
+template <typename U>
+U UU::CTableMath<T, table_size>::Sqrt(U x)
+{
+	return UU::Sqrt(x);
+}
+
+template <typename T, size_t table_size>
+template <typename U>
+U UU::CTableMath<T, table_size>::InvSqrt(U x)
+{
+	return UU::InvSqrt(x);
+}
+
+template <typename T, size_t table_size>
+template <typename U>
+U UU::CTableMath<T, table_size>::Sin(U x)
+{
+	const TArg pos = static_cast<TArg>(x) * TArg(table_size / 6.28318530717958647693);
+
+	if (!(Abs(pos) < TArg(int64_t(1) << 62)))
+		return UU::Sin(x);
+
+	const int64_t i = Detail::FloorToInt(pos);
+	const auto frac = static_cast<T>(pos - static_cast<TArg>(i));
+	const size_t idx = static_cast<size_t>(i) & (table_size - 1);
+
+	return static_cast<U>(sin_table[idx] + (sin_table[idx + 1] - sin_table[idx]) * frac);
+}
+
+template <typename T, size_t table_size>
+template <typename U>
+U UU::CTableMath<T, table_size>::Cos(U x)
+{
+	const TArg pos = static_cast<TArg>(x) * TArg(table_size / 6.28318530717958647693);
+
+	if (!(Abs(pos) < TArg(int64_t(1) << 62)))
+		return UU::Cos(x);
+
+	// A quarter turn on from the sine, added to the index so it cannot round the argument.
+	const int64_t i = Detail::FloorToInt(pos);
+	const auto frac = static_cast<T>(pos - static_cast<TArg>(i));
+	const size_t idx = (static_cast<size_t>(i) + table_size / 4) & (table_size - 1);
+
+	return static_cast<U>(sin_table[idx] + (sin_table[idx + 1] - sin_table[idx]) * frac);
+}
+
+template <typename T, size_t table_size>
+template <typename U>
+void UU::CTableMath<T, table_size>::SinCos(U x, U & sin_val, U & cos_val)
+{
+	const TArg pos = static_cast<TArg>(x) * TArg(table_size / 6.28318530717958647693);
+
+	if (!(Abs(pos) < TArg(int64_t(1) << 62)))
+		return UU::SinCos(x, sin_val, cos_val);
+
+	const int64_t i = Detail::FloorToInt(pos);
+	const auto frac = static_cast<T>(pos - static_cast<TArg>(i));
+	const size_t s = static_cast<size_t>(i) & (table_size - 1);
+	const size_t c = (s + table_size / 4) & (table_size - 1);
+
+	sin_val = static_cast<U>(sin_table[s] + (sin_table[s + 1] - sin_table[s]) * frac);
+	cos_val = static_cast<U>(sin_table[c] + (sin_table[c + 1] - sin_table[c]) * frac);
+}
+
+template <typename T, size_t table_size>
+template <typename U>
+U UU::CTableMath<T, table_size>::ATan2(U y, U x)
+{
+	const T ax = Abs(static_cast<T>(x)), ay = Abs(static_cast<T>(y));
+	const T lo = ax < ay ? ax : ay;
+	const T hi = ax < ay ? ay : ax;
+
+	if (!(hi > T(0) && lo >= T(0)) || hi == std::numeric_limits<T>::infinity())
+		return UU::ATan2(y, x);
+
+	const T pos = lo / hi * T(table_size);
+	const auto idx = static_cast<size_t>(pos);
+	const T frac = pos - static_cast<T>(idx);
+
+	T a = idx < table_size ? atan_table[idx] + (atan_table[idx + 1] - atan_table[idx]) * frac : atan_table[table_size];
+
+	if (ay > ax)
+		a = T(1.57079632679489661923) - a;
+
+	if (x < U(0))
+		a = T(3.14159265358979323846) - a;
+
+	return static_cast<U>(std::signbit(y) ? -a : a);
+}
+
+template <typename T, size_t table_size>
+template <typename U>
+U UU::CTableMath<T, table_size>::Exp(U x)
+{
+	// e^x = 2^n * 2^f with f in [0, 1) looked up in the table.
+	const TArg pos = static_cast<TArg>(x) * TArg(1.44269504088896340736 * table_size);
+	constexpr TArg limit = TArg((std::numeric_limits<T>::max_exponent - 2) * table_size);
+
+	if (!(Abs(pos) < limit))
+		return static_cast<U>(UU::Exp(static_cast<T>(x)));
+
+	const int64_t i = Detail::FloorToInt(pos);
+	const auto frac = static_cast<T>(pos - static_cast<TArg>(i));
+	const auto idx = static_cast<size_t>(i & static_cast<int64_t>(table_size - 1));
+	const int64_t n = (i - static_cast<int64_t>(idx)) / static_cast<int64_t>(table_size);
+
+	return static_cast<U>((exp2_table[idx] + (exp2_table[idx + 1] - exp2_table[idx]) * frac) * Detail::Pow2<T>(n));
+}
@@ -4,6 +4,7 @@ namespace UU
 {
 	class CColour;
 	class CHSB;
+	class CLinearColour;
 
 	template <class T, size_t dim>
 	class CVector;
@@ -17,6 +18,32 @@ namespace UU
 	template <class T, size_t size_of_state = 4>
 	class CRandom;
 
+	template <typename T>
+	class CSpan;
+
+	template <typename T, size_t alignment>
+	class CAlignedAllocator;
+
+	template <typename T, size_t size>
+	class CVectorView;
+
+	template <typename T, size_t size>
+	class CAABox;
+
+	template <typename T, size_t size>
+	class CPointMoments;
+
+	class CRay;
+	class CRayHit;
+	class CRayPacket8;
+	class CRayHit8;
+	class CBvhNode;
+	class CBvhTriangle;
+	class CBvh;
+	class CSphereSoA;
+	class CAABoxSoA;
+	class CFrustum;
+
 	using CVec2f = CVector<float, 2>;
 	using CVec3f = CVector<float, 3>;
 	using CVec4f = CVector<float, 4>;
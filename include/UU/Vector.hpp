@@ -6,6 +6,7 @@
 
 #include "Constants.hpp"
 #include "Math.hpp"
+#include "TableMath.hpp"
 
 #include <initializer_list>
 #include <iostream>
@@ -67,24 +68,27 @@ namespace UU
 		bool operator==(const CVector & v) const;
 		bool operator!=(const CVector & v) const;
 
+		// TMath is a math policy such as CExactMath, CFastMath or CTableMath<float>.
+		template<typename TMath = CDefaultMath>
 		T Length() const;
 		T LengthSqr() const;
 
 		bool IsLengthGreaterThan(T val) const;
 		bool IsLengthLesserThan(T val) const;
 
+		template<typename TMath = CDefaultMath>
 		T DistTo(const CVector & v) const;
 		T DistToSqr(const CVector & v) const;
 
-		template<typename U, bool radians = true>
+		template<typename TMath = CDefaultMath, typename U, bool radians = true>
 		CVector Rotated(const CAngle<U, size * (size - 1) / 2, radians> & a) const;
 
-		template<typename U, bool radians = true>
+		template<typename TMath = CDefaultMath, typename U, bool radians = true>
 		void RotateInPlace(const CAngle<U, size * (size - 1) / 2, radians> & a);
 
 		bool WithinAABox(const CVector & min, const CVector & max) const;
 
-		template <typename U, bool radians = true>
+		template <typename U, bool radians = true, typename TMath = CDefaultMath>
 		CAngle <U, size * (size - 1) / 2, radians> ToCAngle() const;
 		//CColour						ToColour() const;
 
@@ -97,7 +101,7 @@ namespace UU
 		void Negate();
 		bool IsZero(T tolerance = T()) const;
 
-		template <typename = std::enable_if_t<size == 3>>
+		template <size_t N = size, typename = std::enable_if_t<N == 3>>
 		CVector Cross(const CVector & v) const;
 		T Dot(const CVector & v) const;
 
@@ -108,7 +112,10 @@ namespace UU
 		void Randomize(const CVector & min, const CVector & max);
 		void Lerp(const CVector & v, T factor);
 
+		// Policies other than CExactMath scale by TMath::InvSqrt instead of dividing by the length.
+		template<typename TMath = CDefaultMath>
 		CVector Normalized() const;
+		template<typename TMath = CDefaultMath>
 		T NormalizeInPlace();
 
 		friend std::ostream & operator<<(std::ostream & os, const CVector<T, size> & v)
@@ -188,12 +195,17 @@ namespace UU
 		bool operator==(const CAngle & a) const;
 		bool operator!=(const CAngle & a) const;
 
+		template<typename TMath = CDefaultMath>
 		T Length() const;
 		T LengthSqr() const;
 
+		template<typename TMath = CDefaultMath>
 		CVector<T, size> ToCVector() const;
+		template<typename TMath = CDefaultMath>
 		CVector<T, size> Forward() const;
+		template<typename TMath = CDefaultMath>
 		CVector<T, size> Right() const;
+		template<typename TMath = CDefaultMath>
 		CVector<T, size> Up() const;
 		//CMatrix3x4				ToMatrix3x4() const;
 
@@ -462,6 +474,7 @@ bool UU::CVector<T, size>::operator!=(const CVector & v) const
 }
 
 template<typename T, size_t size>
+template<typename TMath>
 T UU::CVector<T, size>::Length() const
 {
 	T temp = T();
@@ -469,7 +482,7 @@ T UU::CVector<T, size>::Length() const
 	for (int i = 0; i < size; ++i)
 		temp += data[i] * data[i];
 
-	return UU::Sqrt(temp);
+	return TMath::Sqrt(temp);
 }
 
 template<typename T, size_t size>
@@ -496,11 +509,12 @@ bool UU::CVector<T, size>::IsLengthLesserThan(T val) const
 }
 
 template<typename T, size_t size>
+template<typename TMath>
 T UU::CVector<T, size>::DistTo(const CVector & v) const
 {
 	CVector temp = v - *this;
 
-	return temp.Length();
+	return temp.template Length<TMath>();
 }
 
 template<typename T, size_t size>
@@ -508,11 +522,11 @@ T UU::CVector<T, size>::DistToSqr(const CVector & v) const
 {
 	CVector temp = v - *this;
 
-	return temp.Length();
+	return temp.LengthSqr();
 }
 
 template<typename T, size_t size>
-template<typename U, bool radians>
+template<typename TMath, typename U, bool radians>
 UU::CVector<T, size> UU::CVector<T, size>::Rotated(
 	const CAngle<U, size * (size - 1) / 2, radians> & a) const
 {
@@ -522,7 +536,7 @@ UU::CVector<T, size> UU::CVector<T, size>::Rotated(
 	{
 		float s, c;
 
-		UU::SinCos(a[0], s, c);
+		TMath::SinCos(static_cast<float>(a[0]), s, c);
 
 		temp[0] = (*this).Dot(CVec2f(c, -s));
 		temp[1] = (*this).Dot(CVec2f(s, c));
@@ -531,9 +545,9 @@ UU::CVector<T, size> UU::CVector<T, size>::Rotated(
 	{
 		float sp, sy, sr, cp, cy, cr;
 
-		UU::SinCos(DegToRad(a[0]), sp, cp);
-		UU::SinCos(DegToRad(a[1]), sy, cy);
-		UU::SinCos(DegToRad(a[2]), sr, cr);
+		TMath::SinCos(static_cast<float>(DegToRad(a[0])), sp, cp);
+		TMath::SinCos(static_cast<float>(DegToRad(a[1])), sy, cy);
+		TMath::SinCos(static_cast<float>(DegToRad(a[2])), sr, cr);
 
 		const float cr_cy = cr * cy;
 		const float cr_sy = cr * sy;
@@ -549,10 +563,10 @@ UU::CVector<T, size> UU::CVector<T, size>::Rotated(
 }
 
 template<typename T, size_t size>
-template<typename U, bool radians>
+template<typename TMath, typename U, bool radians>
 void UU::CVector<T, size>::RotateInPlace(const CAngle<U, size * (size - 1) / 2, radians> & a)
 {
-	*this = Rotated(a);
+	*this = Rotated<TMath>(a);
 }
 
 template<typename T, size_t size>
@@ -568,10 +582,10 @@ bool UU::CVector<T, size>::WithinAABox(const CVector & min, const CVector & max)
 }
 
 template<typename T, size_t size>
-template<typename U, bool radians>
+template<typename U, bool radians, typename TMath>
 UU::CAngle<U, size * (size - 1) / 2, radians> UU::CVector<T, size>::ToCAngle() const
 {
-	auto normalized_vec = this->Normalized();
+	auto normalized_vec = this->template Normalized<TMath>();
 	CAngle<U, size * (size - 1) / 2, radians> temp;
 
 	if constexpr (size == 1)
@@ -641,7 +655,7 @@ bool UU::CVector<T, size>::IsZero(T tolerance) const
 }
 
 template<typename T, size_t size>
-template<typename>
+template<size_t N, typename>
 UU::CVector<T, size> UU::CVector<T, size>::Cross(const CVector & v) const
 {
 	static_assert(size == 3);
@@ -720,25 +734,40 @@ void UU::CVector<T, size>::Lerp(const CVector & v, T factor)
 }
 
 template<typename T, size_t size>
+template<typename TMath>
 UU::CVector<T, size> UU::CVector<T, size>::Normalized() const
 {
 	CVector temp = *this;
 
-	T len = Length();
-
-	temp /= len;
+	if constexpr (std::is_same<TMath, CExactMath>::value)
+		temp /= Length<TMath>();
+	else
+		temp *= TMath::InvSqrt(LengthSqr());
 
 	return temp;
 }
 
 template<typename T, size_t size>
+template<typename TMath>
 T UU::CVector<T, size>::NormalizeInPlace()
 {
-	T len = Length();
+	if constexpr (std::is_same<TMath, CExactMath>::value)
+	{
+		T len = Length<TMath>();
 
-	*this /= len;
+		*this /= len;
 
-	return len;
+		return len;
+	}
+	else
+	{
+		const T len_sqr = LengthSqr();
+		const T inv_len = TMath::InvSqrt(len_sqr);
+
+		*this *= inv_len;
+
+		return len_sqr * inv_len;
+	}
 }
 
 template<typename T, size_t size, bool radians>
@@ -899,6 +928,7 @@ bool UU::CAngle<T, size, radians>::operator!=(const CAngle & a) const
 }
 
 template<typename T, size_t size, bool radians>
+template<typename TMath>
 T UU::CAngle<T, size, radians>::Length() const
 {
 	T temp = T();
@@ -906,7 +936,7 @@ T UU::CAngle<T, size, radians>::Length() const
 	for (int i = 0; i < size; ++i)
 		temp += data[i] * data[i];
 
-	return Sqrt(temp);
+	return TMath::Sqrt(temp);
 }
 
 template<typename T, size_t size, bool radians>
@@ -921,12 +951,14 @@ T UU::CAngle<T, size, radians>::LengthSqr() const
 }
 
 template<typename T, size_t size, bool radians>
+template<typename TMath>
 UU::CVector<T, size> UU::CAngle<T, size, radians>::ToCVector() const
 {
-	return Forward();
+	return Forward<TMath>();
 }
 
 template<typename T, size_t size, bool radians>
+template<typename TMath>
 UU::CVector<T, size> UU::CAngle<T, size, radians>::Forward() const
 {
 	CVector<T, size> temp;
@@ -935,7 +967,7 @@ UU::CVector<T, size> UU::CAngle<T, size, radians>::Forward() const
 	{
 		T sx, cx;
 
-		SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
+		TMath::SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
 
 		temp.data[0] = sx;
 		temp.data[1] = -cx;
@@ -945,8 +977,8 @@ UU::CVector<T, size> UU::CAngle<T, size, radians>::Forward() const
 	{
 		T sx, cx, sy, cy;
 
-		SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
-		SinCos(radians ? data[1] : DegToRad(data[1]), sy, cy);
+		TMath::SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
+		TMath::SinCos(radians ? data[1] : DegToRad(data[1]), sy, cy);
 
 		temp.data[0] = sx * cy;
 		temp.data[1] = sx * sy;
@@ -957,6 +989,7 @@ UU::CVector<T, size> UU::CAngle<T, size, radians>::Forward() const
 }
 
 template<typename T, size_t size, bool radians>
+template<typename TMath>
 UU::CVector<T, size> UU::CAngle<T, size, radians>::Right() const
 {
 	CVector<T, size> temp;
@@ -965,9 +998,9 @@ UU::CVector<T, size> UU::CAngle<T, size, radians>::Right() const
 	{
 		T sx, cx, sy, cy, sz, cz;
 
-		SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
-		SinCos(radians ? data[1] : DegToRad(data[1]), sy, cy);
-		SinCos(radians ? data[2] : DegToRad(data[2]), sz, cz);
+		TMath::SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
+		TMath::SinCos(radians ? data[1] : DegToRad(data[1]), sy, cy);
+		TMath::SinCos(radians ? data[2] : DegToRad(data[2]), sz, cz);
 
 		temp.data[0] = cx * sy;
 		temp.data[1] = (sx * sy * sz) + (cy * cz);
@@ -978,6 +1011,7 @@ UU::CVector<T, size> UU::CAngle<T, size, radians>::Right() const
 }
 
 template<typename T, size_t size, bool radians>
+template<typename TMath>
 UU::CVector<T, size> UU::CAngle<T, size, radians>::Up() const
 {
 	CVector<T, size> temp;
@@ -986,9 +1020,9 @@ UU::CVector<T, size> UU::CAngle<T, size, radians>::Up() const
 	{
 		T sx, cx, sy, cy, sz, cz;
 
-		SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
-		SinCos(radians ? data[1] : DegToRad(data[1]), sy, cy);
-		SinCos(radians ? data[2] : DegToRad(data[2]), sz, cz);
+		TMath::SinCos(radians ? data[0] : DegToRad(data[0]), sx, cx);
+		TMath::SinCos(radians ? data[1] : DegToRad(data[1]), sy, cy);
+		TMath::SinCos(radians ? data[2] : DegToRad(data[2]), sz, cz);
 
 		temp.data[0] = -sx;
 		temp.data[1] = cx * sz;
@@ -0,0 +1,368 @@
+#pragma once
+
+#ifndef UU_INIT
+	#error "Please only include UU.hpp for now"
+#endif
+
+#include "Math.hpp"
+#include "Parallel.hpp"
+#include "Span.hpp"
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace UU
+{
+	// A span of CVector<T, size> laid out with an arbitrary byte stride, e.g. the positions inside an
+	// interleaved position/normal/uv vertex buffer. Elements are reinterpreted in place like
+	// CVector::AsCVector, so the buffer must be aligned for T. Use a const T for read-only views.
+	template <typename T, size_t size>
+	class CVectorView
+	{
+	public:
+		using TVector = std::conditional_t<std::is_const<T>::value, const CVector<std::remove_const_t<T>, size>, CVector<T, size>>;
+		using TByte = std::conditional_t<std::is_const<T>::value, const uint8_t, uint8_t>;
+		using TVoid = std::conditional_t<std::is_const<T>::value, const void, void>;
+		using TValue = std::remove_const_t<T>;
+
+		static constexpr size_t SIZE = size;
+
+		class CIterator
+		{
+		private:
+			TByte * ptr;
+			size_t stride;
+		public:
+			CIterator(TByte * p, size_t s) : ptr(p), stride(s) {}
+
+			TVector &		operator*() const { return *reinterpret_cast<TVector *>(ptr); }
+			TVector *		operator->() const { return reinterpret_cast<TVector *>(ptr); }
+
+			CIterator &		operator++() { ptr += stride; return *this; }
+			bool			operator==(const CIterator & it) const { return ptr == it.ptr; }
+			bool			operator!=(const CIterator & it) const { return ptr != it.ptr; }
+		};
+
+	private:
+		TByte * data = nullptr;
+		size_t count = 0;
+		size_t stride = sizeof(CVector<std::remove_const_t<T>, size>);
+
+	public:
+		CVectorView() = default;
+
+		CVectorView(TVoid * base, size_t n, size_t stride_bytes)
+			: data(static_cast<TByte *>(base)), count(n), stride(stride_bytes) {}
+
+		CVectorView(TVector * ptr, size_t n)
+			: data(reinterpret_cast<TByte *>(ptr)), count(n) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible<U *, TVector *>::value>>
+		CVectorView(CSpan<U> s)
+			: data(reinterpret_cast<TByte *>(s.Data())), count(s.Size()) {}
+
+		template <typename U, typename A, typename = std::enable_if_t<std::is_convertible<U *, TVector *>::value>>
+		CVectorView(std::vector<U, A> & vec)
+			: data(reinterpret_cast<TByte *>(vec.data())), count(vec.size()) {}
+
+		template <typename U, typename A, typename = std::enable_if_t<std::is_convertible<const U *, TVector *>::value>>
+		CVectorView(const std::vector<U, A> & vec)
+			: data(reinterpret_cast<TByte *>(vec.data())), count(vec.size()) {}
+
+		template <typename U, typename = std::enable_if_t<std::is_convertible<U *, T *>::value && !std::is_same<U, T>::value>>
+		CVectorView(const CVectorView<U, size> & v)
+			: data(reinterpret_cast<TByte *>(v.Bytes())), count(v.Size()), stride(v.Stride()) {}
+
+		TVector &			operator[](size_t i) const;
+
+		TByte *				Bytes() const;
+		size_t				Size() const;
+		size_t				Stride() const;
+		bool				Empty() const;
+
+		// True when the elements are packed back to back, i.e. the view is an ordinary array.
+		bool				IsContiguous() const;
+
+		CVectorView			Subview(size_t offset) const;
+		CVectorView			Subview(size_t offset, size_t n) const;
+
+		// Views the first N components of every element, the strided counterpart of CVector::AsCVector.
+		template <size_t N>
+		CVectorView<T, N>	AsCVectorView() const;
+
+		CIterator			begin() const;
+		CIterator			end() const;
+	};
+
+	template <typename T>
+	using CVec2View = CVectorView<T, 2>;
+	template <typename T>
+	using CVec3View = CVectorView<T, 3>;
+	template <typename T>
+	using CVec4View = CVectorView<T, 4>;
+
+	namespace Detail
+	{
+		template <typename V>
+		class CViewElement
+		{
+		};
+
+		template <typename T, size_t size>
+		class CViewElement<CVector<T, size>>
+		{
+		public:
+			using TScalar = T;
+			static constexpr size_t SIZE = size;
+		};
+
+		template <typename T, size_t size>
+		class CViewElement<const CVector<T, size>>
+		{
+		public:
+			using TScalar = const T;
+			static constexpr size_t SIZE = size;
+		};
+	}
+
+	// The CVectorView a CSpan, std::vector or CVectorView of CVectors converts to, so that overloads taking
+	// views can be reached from any of them without deducing through the conversion. A const std::vector
+	// gives a read-only view. Other types have no members, which removes the overload.
+	template <typename TPoints>
+	class CViewTraits
+	{
+	};
+
+	template <typename U>
+	class CViewTraits<CSpan<U>> : public Detail::CViewElement<U>
+	{
+	};
+
+	template <typename U>
+	class CViewTraits<const CSpan<U>> : public Detail::CViewElement<U>
+	{
+	};
+
+	template <typename U, typename A>
+	class CViewTraits<std::vector<U, A>> : public Detail::CViewElement<U>
+	{
+	};
+
+	template <typename U, typename A>
+	class CViewTraits<const std::vector<U, A>> : public Detail::CViewElement<const U>
+	{
+	};
+
+	template <typename T, size_t size>
+	class CViewTraits<CVectorView<T, size>> : public Detail::CViewElement<CVector<T, size>>
+	{
+	};
+
+	template <typename T, size_t size>
+	class CViewTraits<const CVectorView<T, size>> : public Detail::CViewElement<CVector<T, size>>
+	{
+	};
+
+	// TPoints may be a reference, as deduced for a forwarding parameter.
+	template <typename TPoints, typename TTraits = CViewTraits<std::remove_reference_t<TPoints>>>
+	using TViewOf = CVectorView<typename TTraits::TScalar, TTraits::SIZE>;
+
+	template <typename TPoints, typename TTraits = CViewTraits<std::remove_reference_t<TPoints>>>
+	using TConstViewOf = CVectorView<const std::remove_const_t<typename TTraits::TScalar>, TTraits::SIZE>;
+
+	// View of one CVector member across a span of interleaved structs, e.g.
+	// MakeVectorView(vertices, &SVertex::position).
+	template <typename S, typename T, size_t size>
+	auto MakeVectorView(CSpan<S> elements, CVector<T, size> std::remove_const_t<S>::* member)
+		-> CVectorView<std::conditional_t<std::is_const<S>::value, const T, T>, size>;
+
+	template <typename S, typename A, typename T, size_t size>
+	auto MakeVectorView(std::vector<S, A> & elements, CVector<T, size> S::* member) -> CVectorView<T, size>;
+
+	template <typename S, typename A, typename T, size_t size>
+	auto MakeVectorView(const std::vector<S, A> & elements, CVector<T, size> S::* member) -> CVectorView<const T, size>;
+
+	// Component-wise RoundToInt of every element, e.g. positions to grid cells with ERounding::Floor, and the
+	// conversion back. Packed views run the span kernels over all components at once. The input may be a
+	// const or mutable view.
+	template <typename TFloat, size_t size, typename = std::enable_if_t<std::is_same<std::remove_const_t<TFloat>, float>::value>>
+	void RoundToInt(CVectorView<TFloat, size> in, CVectorView<int, size> out, ERounding rounding = ERounding::Nearest);
+	template <typename TInt, size_t size, typename = std::enable_if_t<std::is_same<std::remove_const_t<TInt>, int>::value>>
+	void ToFloat(CVectorView<TInt, size> in, CVectorView<float, size> out);
+
+	// CSpans and std::vectors of CVectors forward to the view forms.
+	template <typename TIn, typename TOut, typename VIn = TConstViewOf<TIn>, typename VOut = TViewOf<TOut>>
+	void RoundToInt(const TIn & in, TOut && out, ERounding rounding = ERounding::Nearest);
+	template <typename TIn, typename TOut, typename VIn = TConstViewOf<TIn>, typename VOut = TViewOf<TOut>>
+	void ToFloat(const TIn & in, TOut && out);
+}
+
+namespace UU
+{
+	namespace Detail
+	{
+		template <ERounding rounding, typename TFloat, size_t size>
+		void RoundToIntStrided(CVectorView<TFloat, size> in, CVectorView<int, size> out)
+		{
+			ParallelFor(in.Size(), MATH_PARALLEL_GRAIN / size, [&](size_t, size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					for (size_t c = 0; c < size; ++c)
+						out[i][c] = RoundToInt<int, rounding>(in[i][c]);
+				}
+			});
+		}
+	}
+}
+
+template <typename T, size_t size>
+auto UU::CVectorView<T, size>::operator[](size_t i) const -> TVector &
+{
+	return *reinterpret_cast<TVector *>(data + i * stride);
+}
+
+template <typename T, size_t size>
+auto UU::CVectorView<T, size>::Bytes() const -> TByte *
+{
+	return data;
+}
+
+template <typename T, size_t size>
+size_t UU::CVectorView<T, size>::Size() const
+{
+	return count;
+}
+
+template <typename T, size_t size>
+size_t UU::CVectorView<T, size>::Stride() const
+{
+	return stride;
+}
+
+template <typename T, size_t size>
+bool UU::CVectorView<T, size>::Empty() const
+{
+	return count == 0;
+}
+
+template <typename T, size_t size>
+bool UU::CVectorView<T, size>::IsContiguous() const
+{
+	return stride == sizeof(CVector<std::remove_const_t<T>, size>) || count <= 1;
+}
+
+template <typename T, size_t size>
+UU::CVectorView<T, size> UU::CVectorView<T, size>::Subview(size_t offset) const
+{
+	return CVectorView(data + offset * stride, count - offset, stride);
+}
+
+template <typename T, size_t size>
+UU::CVectorView<T, size> UU::CVectorView<T, size>::Subview(size_t offset, size_t n) const
+{
+	return CVectorView(data + offset * stride, n, stride);
+}
+
+template <typename T, size_t size>
+template <size_t N>
+UU::CVectorView<T, N> UU::CVectorView<T, size>::AsCVectorView() const
+{
+	static_assert(N <= size);
+
+	return CVectorView<T, N>(data, count, stride);
+}
+
+template <typename T, size_t size>
+auto UU::CVectorView<T, size>::begin() const -> CIterator
+{
+	return CIterator(data, stride);
+}
+
+template <typename T, size_t size>
+auto UU::CVectorView<T, size>::end() const -> CIterator
+{
+	return CIterator(data + count * stride, stride);
+}
+
+template <typename S, typename T, size_t size>
+auto UU::MakeVectorView(CSpan<S> elements, CVector<T, size> std::remove_const_t<S>::* member)
+	-> CVectorView<std::conditional_t<std::is_const<S>::value, const T, T>, size>
+{
+	using TView = CVectorView<std::conditional_t<std::is_const<S>::value, const T, T>, size>;
+
+	if (elements.Empty())
+		return TView();
+
+	return TView(&(elements.Data()->*member), elements.Size(), sizeof(S));
+}
+
+template <typename S, typename A, typename T, size_t size>
+auto UU::MakeVectorView(std::vector<S, A> & elements, CVector<T, size> S::* member) -> CVectorView<T, size>
+{
+	return MakeVectorView(CSpan<S>(elements.data(), elements.size()), member);
+}
+
+template <typename S, typename A, typename T, size_t size>
+auto UU::MakeVectorView(const std::vector<S, A> & elements, CVector<T, size> S::* member) -> CVectorView<const T, size>
+{
+	return MakeVectorView(CSpan<const S>(elements.data(), elements.size()), member);
+}
+
+template <typename TFloat, size_t size, typename>
+void UU::RoundToInt(CVectorView<TFloat, size> in, CVectorView<int, size> out, ERounding rounding)
+{
+	if (in.IsContiguous() && out.IsContiguous())
+	{
+		RoundToInt(CSpan<const float>(reinterpret_cast<const float *>(in.Bytes()), in.Size() * size),
+			CSpan<int32_t>(reinterpret_cast<int32_t *>(out.Bytes()), in.Size() * size), rounding);
+
+		return;
+	}
+
+	switch (rounding)
+	{
+	case ERounding::Floor:
+		return Detail::RoundToIntStrided<ERounding::Floor>(in, out);
+	case ERounding::Ceil:
+		return Detail::RoundToIntStrided<ERounding::Ceil>(in, out);
+	case ERounding::Trunc:
+		return Detail::RoundToIntStrided<ERounding::Trunc>(in, out);
+	default:
+		return Detail::RoundToIntStrided<ERounding::Nearest>(in, out);
+	}
+}
+
+template <typename TInt, size_t size, typename>
+void UU::ToFloat(CVectorView<TInt, size> in, CVectorView<float, size> out)
+{
+	if (in.IsContiguous() && out.IsContiguous())
+	{
+		ToFloat(CSpan<const int32_t>(reinterpret_cast<const int32_t *>(in.Bytes()), in.Size() * size),
+			CSpan<float>(reinterpret_cast<float *>(out.Bytes()), in.Size() * size));
+
+		return;
+	}
+
+	ParallelFor(in.Size(), MATH_PARALLEL_GRAIN / size, [&](size_t, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			for (size_t c = 0; c < size; ++c)
+				out[i][c] = static_cast<float>(in[i][c]);
+		}
+	});
+}
+
+template <typename TIn, typename TOut, typename VIn, typename VOut>
+void UU::RoundToInt(const TIn & in, TOut && out, ERounding rounding)
+{
+	RoundToInt(VIn(in), VOut(out), rounding);
+}
+
+template <typename TIn, typename TOut, typename VIn, typename VOut>
+void UU::ToFloat(const TIn & in, TOut && out)
+{
+	ToFloat(VIn(in), VOut(out));
+}